@@ -0,0 +1,128 @@
+#include <mpi.h>
+#include <iostream>
+#include <vector>
+#include <string>
+#include <cstdlib>
+#include <cmath>
+#include <liv.h>
+#include <utils/AMRResampling.h>
+#include <utils/VolumeIO.h>
+#include <thread>
+
+// Function to fill a patch with a field that is sharper near the center of the domain, sampled at the cell centers of
+// the patch's level
+void fillPatch(const liv::AMRPatch& patch, int domainSize, int refinementRatio, float time, std::vector<float>& data) {
+    const float cellSize = 1.0f / (domainSize * std::pow(static_cast<float>(refinementRatio), patch.level));
+    data.resize(patch.box.numVoxels());
+
+    size_t i = 0;
+    for (int z = 0; z < patch.box.extent[2]; z++) {
+        for (int y = 0; y < patch.box.extent[1]; y++) {
+            for (int x = 0; x < patch.box.extent[0]; x++) {
+                const float px = (patch.box.offset[0] + x + 0.5f) * cellSize - 0.5f;
+                const float py = (patch.box.offset[1] + y + 0.5f) * cellSize - 0.5f;
+                const float pz = (patch.box.offset[2] + z + 0.5f) * cellSize - 0.5f;
+                const float radius = std::sqrt(px * px + py * py + pz * pz);
+                data[i++] = 0.5f + 0.5f * std::sin(40.0f * radius - time);
+            }
+        }
+    }
+}
+
+int main(int argc, char* argv[]) {
+    // Command-line argument parsing
+    if (argc < 2) {
+        std::cerr << "Usage: mpirun -np <num_processes> ./program <coarse_size> [<num_steps>]" << std::endl;
+        return EXIT_FAILURE;
+    }
+
+    const int coarseSize = std::atoi(argv[1]);
+    const int numSteps = argc >= 3 ? std::atoi(argv[2]) : 100;
+    const int refinementRatio = 2;
+
+    auto livEngine = liv::LiVEngine::initialize(1280, 720, "ConvexVolumesInterface");
+
+    if (!livEngine.isApplicationRank()) {
+        livEngine.runVisualizationRank();
+        MPI_Finalize();
+        return EXIT_SUCCESS;
+    }
+
+    // The blocks are distributed over the ranks running the application only
+    int rank, numProcs;
+    MPI_Comm_rank(livEngine.applicationComm, &rank);
+    MPI_Comm_size(livEngine.applicationComm, &numProcs);
+
+    // Every rank holds a coarse patch of a regular decomposition and refines the half of it closer to the center
+    const int coarseDimensions[3] = {coarseSize, coarseSize, coarseSize};
+    int blockGrid[3];
+    liv::computeBlockGrid(numProcs, blockGrid);
+    const liv::Box coarseBox = liv::blockBox(coarseDimensions, blockGrid, rank);
+
+    liv::AMRPatch coarse{0, coarseBox, nullptr};
+    liv::AMRPatch fine{1, coarseBox, nullptr};
+    for (int axis = 0; axis < 3; axis++) {
+        const bool upperHalf = coarseBox.offset[axis] * 2 >= coarseSize;
+        const int half = std::max(1, coarseBox.extent[axis] / 2);
+        const int lower = upperHalf ? coarseBox.offset[axis] : coarseBox.offset[axis] + coarseBox.extent[axis] - half;
+        fine.box.offset[axis] = lower * refinementRatio;
+        fine.box.extent[axis] = half * refinementRatio;
+    }
+
+    std::vector<float> coarseData, fineData;
+    fillPatch(coarse, coarseSize, refinementRatio, 0.0f, coarseData);
+    fillPatch(fine, coarseSize, refinementRatio, 0.0f, fineData);
+    coarse.data = coarseData.data();
+    fine.data = fineData.data();
+
+    // The brick has the resolution of the fine level
+    const liv::Box box = liv::boundingBox({coarse, fine}, 1, refinementRatio);
+    liv::AMRResampler resampler(box, 1, refinementRatio);
+    resampler.addPatch(coarse);
+    const int fineID = resampler.addPatch(fine);
+    resampler.resample();
+
+    std::thread renderThread([&livEngine]() { livEngine.doRender(); });
+
+    livEngine.setVolumeDimensions({coarseSize * refinementRatio, coarseSize * refinementRatio, coarseSize * refinementRatio});
+
+    livEngine.addProcessorDataCollective({static_cast<float>(box.offset[0]), static_cast<float>(box.offset[1]),
+                                          static_cast<float>(box.offset[2])},
+                                         {static_cast<float>(box.extent[0]), static_cast<float>(box.extent[1]),
+                                          static_cast<float>(box.extent[2])});
+
+    float pixelToWorld = livEngine.getVolumeScaling();
+
+    float position[3] = {box.offset[0] * pixelToWorld, box.offset[1] * (-1 * pixelToWorld), box.offset[2] * pixelToWorld};
+
+    liv::QuantizationOptions quantization;
+    quantization.range = liv::ValueRange{0.0f, 1.0f};
+
+    auto& brick = resampler.getBrick();
+    auto volume = liv::createVolume<float>(position, box.extent, &livEngine, quantization);
+    volume.update(brick.data(), static_cast<long int>(brick.size() * sizeof(float)));
+
+    livEngine.setSceneConfigured();
+
+    // Only the fine patch advances, so only the part of the brick it covers is resampled and transferred
+    const long int strides[3] = {1, box.extent[0], static_cast<long int>(box.extent[0]) * box.extent[1]};
+    for (int step = 1; step < numSteps; step++) {
+        fillPatch(fine, coarseSize, refinementRatio, 0.1f * step, fineData);
+        resampler.setPatchData(fineID, fineData.data());
+
+        for (const auto& region : resampler.resample({fineID})) {
+            const float *start = brick.data() + region.offset[0] + strides[1] * region.offset[1] + strides[2] * region.offset[2];
+            volume.updateRegion(region.offset, region.extent, start, strides);
+        }
+        volume.flushDirtyBricks();
+
+        std::this_thread::sleep_for(std::chrono::milliseconds(100));
+    }
+
+    renderThread.join();
+    livEngine.shutdown();
+
+    // Finalize MPI
+    MPI_Finalize();
+    return EXIT_SUCCESS;
+}
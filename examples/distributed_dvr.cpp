@@ -6,8 +6,11 @@
 #include <cstdlib>
 #include <sys/stat.h>
 #include <liv.h>
+#include <utils/BrickContainer.h>
+#include <utils/VolumeIO.h>
 #include <thread>
 #include <filesystem>
+#include <memory>
 
 struct BlockInfo {
     int sizeX;
@@ -19,26 +22,12 @@ struct BlockInfo {
     float posZ;
 };
 
-// Function to read the block data from the .raw file
-bool readBlockData(const std::string& blockFilePath, std::vector<char>& blockData) {
-    std::ifstream blockFile(blockFilePath, std::ios::binary);
-    if (!blockFile.is_open()) {
-        std::cerr << "Error: Could not open block file: " << blockFilePath << std::endl;
-        return false;
-    }
-
-    // Get the size of the file
-    blockFile.seekg(0, std::ios::end);
-    std::streamsize dataSize = blockFile.tellg();
-    blockFile.seekg(0, std::ios::beg);
-
-    blockData.resize(dataSize);
-    if (!blockFile.read(blockData.data(), dataSize)) {
-        std::cerr << "Error: Could not read block data from file: " << blockFilePath << std::endl;
-        return false;
-    }
-    blockFile.close();
-    return true;
+// Function to map the block data from the .raw file. The mapping is handed to the renderer without copying it into
+// a separate buffer, so it must stay alive as long as the volume.
+bool readBlockData(const std::string& blockFilePath, liv::MappedFile& blockData) {
+    liv::MappingOptions options;
+    options.populate = getenv("LIV_MAP_POPULATE") != nullptr;
+    return blockData.open(blockFilePath, options);
 }
 
 // Function to read the block information from the .info file
@@ -71,25 +60,9 @@ bool directoryExists(const std::string& path) {
         return (info.st_mode & S_IFDIR) != 0;
 }
 
-int main(int argc, char* argv[]) {
-    // Command-line argument parsing
-    if (argc < 2) {
-        std::cerr << "Usage: mpirun -np <num_processes> ./program "
-                     "<data_directory> [<width> <height>]" << std::endl;
-        return EXIT_FAILURE;
-    }
-
-    std::string dataDirectory = argv[1];
-    const auto [width, height] = argc >= 4
-        ? std::make_tuple(std::atoi(argv[2]), std::atoi(argv[3]))
-        : std::make_tuple(1280, 720);
-
-    auto livEngine = liv::LiVEngine::initialize(width, height, "ConvexVolumesInterface");
-
-    int rank, numProcs;
-    MPI_Comm_rank(MPI_COMM_WORLD, &rank);
-    MPI_Comm_size(MPI_COMM_WORLD, &numProcs);
-
+// Function to read the blocks written by volume_divider into <data_directory>/blocks<numProcs>
+bool loadBlocksFromDirectory(const std::string& dataDirectory, int rank, int numProcs, std::vector<int>& datasetDimensions,
+                             int& datatypeValue, BlockInfo& blockInfo, liv::MappedFile& blockData) {
     std::string infoFilePath;
     for (const auto& entry : std::filesystem::directory_iterator(dataDirectory)) {
         if (entry.path().extension() == ".info") {
@@ -99,34 +72,30 @@ int main(int argc, char* argv[]) {
     }
     if (infoFilePath.empty()) {
         std::cerr << "Error: No .info file found in directory: " << dataDirectory << ". Please ensure that there is a .info file containing the dimensions of the dataset as comma-seperated integers." << std::endl;
-        MPI_Finalize();
-        return EXIT_FAILURE;
+        return false;
     }
     std::ifstream infoFile(infoFilePath);
     if (!infoFile.is_open()) {
         std::cerr << "Error: Could not open info file: " << infoFilePath << std::endl;
-        MPI_Finalize();
-        return EXIT_FAILURE;
+        return false;
     }
 
-    int sizeX, sizeY, sizeZ, datatypeValue;
+    int sizeX, sizeY, sizeZ;
     infoFile >> sizeX >> sizeY >> sizeZ >> datatypeValue;
 
     if (infoFile.fail()) {
         std::cerr << "Error: Failed to read block info from file: " << infoFilePath << std::endl;
-        MPI_Finalize();
-        return EXIT_FAILURE;
+        return false;
     }
 
     if (datatypeValue != 8 && datatypeValue != 16) {
         std::cerr << "Error: Invalid datatype value in .info file: " << datatypeValue << ". Please ensure that the datatype value is either 8 or 16." << std::endl;
-        MPI_Finalize();
-        return EXIT_FAILURE;
+        return false;
     }
 
     infoFile.close();
 
-    std::vector<int> datasetDimensions = {sizeX, sizeY, sizeZ};
+    datasetDimensions = {sizeX, sizeY, sizeZ};
 
     // Construct the blocks directory path
     std::string blocksDirectory = dataDirectory + "/blocks" + std::to_string(numProcs);
@@ -136,61 +105,131 @@ int main(int argc, char* argv[]) {
         if (rank == 0) {
             std::cerr << "Error: Blocks directory does not exist: " << blocksDirectory << std::endl;
         }
-        MPI_Finalize();
-        return EXIT_FAILURE;
+        return false;
     }
 
     // Ensure that the rank does not exceed the number of blocks
     if (rank >= numProcs) {
         std::cerr << "Error: MPI rank " << rank << " exceeds the number of available blocks (" << numProcs << ")." << std::endl;
-        MPI_Finalize();
-        return EXIT_FAILURE;
+        return false;
     }
 
-    // Construct the file paths for the block data and info files
+    // Read the block information of this rank only, the boxes of the other ranks are gathered from them
+    std::string blockInfoFileName = blocksDirectory + "/block_" + std::to_string(rank) + ".info";
+    if (!readBlockInfo(blockInfoFileName, blockInfo)) {
+        return false;
+    }
+
+    // Read the block data
     std::string blockFileName = blocksDirectory + "/block_" + std::to_string(rank) + ".raw";
-    std::string infoFileName = blocksDirectory + "/block_" + std::to_string(rank) + ".info";
+    return readBlockData(blockFileName, blockData);
+
+}
 
+// Function to decompose a brick container or an undivided .raw volume into one block per rank and read the block
+// of this rank. Blocks of a .raw volume are read collectively.
+bool loadBlocksFromVolume(const std::string& volumeFilePath, MPI_Comm comm, int rank, int numProcs,
+                          std::vector<int>& datasetDimensions, int& datatypeValue, BlockInfo& blockInfo,
+                          std::vector<char>& blockData) {
+    liv::VolumeBlock block;
+    const bool loaded = liv::isBrickContainer(volumeFilePath)
+        ? liv::loadContainerBlock(volumeFilePath, rank, numProcs, block)
+        : liv::loadVolumeBlock(volumeFilePath, comm, block);
+    if (!loaded) {
+        return false;
+    }
 
-    // Read the block information
-    BlockInfo blockInfo;
-    if (!readBlockInfo(infoFileName, blockInfo)) {
-        MPI_Finalize();
+    datasetDimensions = {block.volume.dimensions[0], block.volume.dimensions[1], block.volume.dimensions[2]};
+    datatypeValue = block.volume.bitResolution;
+    blockData = std::move(block.data);
+
+    const auto& box = block.box;
+    blockInfo = {box.extent[0], box.extent[1], box.extent[2], datatypeValue,
+                 static_cast<float>(box.offset[0]), static_cast<float>(box.offset[1]), static_cast<float>(box.offset[2])};
+    return true;
+}
+
+// Function to pass the block to the renderer padded with a ghost layer from the blocks of neighbouring ranks, so that
+// block boundaries are interpolated without seams. The padded volume holds the buffer handed to the renderer, so it
+// must be kept alive while rendering.
+template <typename T>
+std::shared_ptr<void> createPaddedVolume(const liv::Box& box, int ghost, float pixelToWorld, const char* blockData,
+                                         liv::LiVEngine& livEngine) {
+    const liv::Box padded = liv::paddedBox(box, ghost);
+    float position[3] = {padded.offset[0] * pixelToWorld, padded.offset[1] * (-1 * pixelToWorld), padded.offset[2] * pixelToWorld};
+
+    auto volume = std::make_shared<liv::HaloVolume<T>>(position, box, ghost, &livEngine);
+    volume->update(reinterpret_cast<const T*>(blockData));
+    return volume;
+}
+
+int main(int argc, char* argv[]) {
+    // Command-line argument parsing
+    if (argc < 2) {
+        std::cerr << "Usage: mpirun -np <num_processes> ./program "
+                     "<data_directory | volume.raw | volume.livb> [<width> <height>]" << std::endl;
         return EXIT_FAILURE;
     }
 
-    // Read the block data
-    std::vector<char> blockData;
-    if (!readBlockData(blockFileName, blockData)) {
+    std::string dataDirectory = argv[1];
+    const auto [width, height] = argc >= 4
+        ? std::make_tuple(std::atoi(argv[2]), std::atoi(argv[3]))
+        : std::make_tuple(1280, 720);
+
+    auto livEngine = liv::LiVEngine::initialize(width, height, "ConvexVolumesInterface");
+
+    if (!livEngine.isApplicationRank()) {
+        livEngine.runVisualizationRank();
+        MPI_Finalize();
+        return EXIT_SUCCESS;
+    }
+
+    // The blocks are distributed over the ranks running the application only
+    int rank, numProcs;
+    MPI_Comm_rank(livEngine.applicationComm, &rank);
+    MPI_Comm_size(livEngine.applicationComm, &numProcs);
+
+    std::vector<int> datasetDimensions;
+    int datatypeValue;
+    std::vector<char> volumeBlockData;
+    liv::MappedFile mappedBlockData;
+    BlockInfo blockInfo;
+
+    // Given a brick container or a .raw file, read the block of every rank directly from it, without running
+    // volume_divider for this number of ranks. Otherwise, read the blocks volume_divider wrote for this number of ranks.
+    const bool fromVolume = std::filesystem::is_regular_file(dataDirectory);
+    const bool loaded = fromVolume
+        ? loadBlocksFromVolume(dataDirectory, livEngine.applicationComm, rank, numProcs, datasetDimensions, datatypeValue,
+                               blockInfo, volumeBlockData)
+        : loadBlocksFromDirectory(dataDirectory, rank, numProcs, datasetDimensions, datatypeValue, blockInfo, mappedBlockData);
+    if (!loaded) {
         MPI_Finalize();
         return EXIT_FAILURE;
     }
 
+    char *blockData = fromVolume ? volumeBlockData.data() : mappedBlockData.data();
+    const size_t blockDataSize = fromVolume ? volumeBlockData.size() : mappedBlockData.size();
+
     std::thread renderThread([&livEngine]() { livEngine.doRender(); });
 
     livEngine.setVolumeDimensions(datasetDimensions);
 
-    //set the processor dimensions for all ranks
+    // set the processor dimensions for all ranks, gathered from the block of each rank
 
-    std::vector<BlockInfo> allBlockInfos(numProcs);
-
-    for (int i = 0; i < numProcs; ++i) {
-        std::string blockInfoFileName = blocksDirectory + "/block_" + std::to_string(i) + ".info";
-        if (!readBlockInfo(blockInfoFileName, allBlockInfos[i])) {
-            MPI_Finalize();
-            return EXIT_FAILURE;
-        }
-        livEngine.addProcessorData(i, {allBlockInfos[i].posX, allBlockInfos[i].posY, allBlockInfos[i].posZ}, {static_cast<float>(allBlockInfos[i].sizeX), static_cast<float>(allBlockInfos[i].sizeY), static_cast<float>(allBlockInfos[i].sizeZ)});
-    }
+    livEngine.addProcessorDataCollective({blockInfo.posX, blockInfo.posY, blockInfo.posZ},
+                                         {static_cast<float>(blockInfo.sizeX), static_cast<float>(blockInfo.sizeY), static_cast<float>(blockInfo.sizeZ)});
 
     float pixelToWorld = livEngine.getVolumeScaling();
 
+    const liv::Box blockBox{{static_cast<int>(blockInfo.posX), static_cast<int>(blockInfo.posY), static_cast<int>(blockInfo.posZ)},
+                            {blockInfo.sizeX, blockInfo.sizeY, blockInfo.sizeZ}};
+
     blockInfo.posX *= pixelToWorld;
     blockInfo.posY *= (-1 * pixelToWorld);
     blockInfo.posZ *= pixelToWorld;
 
     // Now you have:
-    // - blockData: vector<char> containing the raw data of the block
+    // - blockData: pointer to the raw data of the block, blockDataSize bytes long
     // - blockInfo: BlockInfo struct containing size, bit resolution, and position
 
     // For demonstration purposes, let's print out the block info from each rank
@@ -198,18 +237,27 @@ int main(int argc, char* argv[]) {
     std::cout << "  Size: " << blockInfo.sizeX << " x " << blockInfo.sizeY << " x " << blockInfo.sizeZ << std::endl;
     std::cout << "  Bit Resolution: " << blockInfo.bitResolution << std::endl;
     std::cout << "  Position: (" << blockInfo.posX << ", " << blockInfo.posY << ", " << blockInfo.posZ << ")" << std::endl;
-    std::cout << "  Data Size: " << blockData.size() << " bytes" << std::endl;
+    std::cout << "  Data Size: " << blockDataSize << " bytes" << std::endl;
 
     float position[3] = {blockInfo.posX, blockInfo.posY, blockInfo.posZ};
     int dimensions[3] = {blockInfo.sizeX, blockInfo.sizeY, blockInfo.sizeZ};
 
-    // Pass volume data to renderer.
-    if(datatypeValue == 8) {
+    // Pass volume data to renderer. With LIV_GHOST_CELLS set, blocks are padded with that many voxels from their
+    // neighbours, which must be set the same on all ranks.
+    const char* ghostCells = getenv("LIV_GHOST_CELLS");
+    const int ghost = ghostCells != nullptr ? std::atoi(ghostCells) : 0;
+    std::shared_ptr<void> paddedVolume;
+
+    if(ghost > 0) {
+        paddedVolume = datatypeValue == 8
+            ? createPaddedVolume<char>(blockBox, ghost, pixelToWorld, blockData, livEngine)
+            : createPaddedVolume<unsigned short>(blockBox, ghost, pixelToWorld, blockData, livEngine);
+    } else if(datatypeValue == 8) {
         liv::createVolume<char>(position, dimensions, &livEngine)
-            .update(blockData.data(), blockData.size());
+            .update(blockData, static_cast<long int>(blockDataSize));
     } else {
         liv::createVolume<unsigned short>(position, dimensions, &livEngine)
-            .update(reinterpret_cast<unsigned short*>(blockData.data()), blockData.size());
+            .update(reinterpret_cast<unsigned short*>(blockData), static_cast<long int>(blockDataSize));
     }
 
     livEngine.setSceneConfigured();
@@ -218,6 +266,7 @@ int main(int argc, char* argv[]) {
     std::this_thread::sleep_for(std::chrono::seconds(100));
 
     renderThread.join();
+    livEngine.shutdown();
 
     // Finalize MPI
     MPI_Finalize();
@@ -6,6 +6,9 @@
 #include <cstdlib>
 #include <sys/stat.h>
 #include <liv.h>
+#include <utils/BrickContainer.h>
+#include <utils/Partitioning.h>
+#include <utils/VolumeIO.h>
 #include <thread>
 #include <filesystem>
 
@@ -19,26 +22,21 @@ struct BlockInfo {
     float posZ;
 };
 
-// Function to read the block data from the .raw file
-bool readBlockData(const std::string& blockFilePath, std::vector<char>& blockData) {
-    std::ifstream blockFile(blockFilePath, std::ios::binary);
-    if (!blockFile.is_open()) {
-        std::cerr << "Error: Could not open block file: " << blockFilePath << std::endl;
-        return false;
+static const char* getEnvVar(const char* varName, const bool null_is_error = true) {
+    const char* value = getenv(varName);
+    if (value == nullptr && null_is_error) {
+        std::cerr << "ERROR: " << varName << " environment variable is not set." << std::endl;
+        std::exit(EXIT_FAILURE);
     }
+    return value;
+}
 
-    // Get the size of the file
-    blockFile.seekg(0, std::ios::end);
-    std::streamsize dataSize = blockFile.tellg();
-    blockFile.seekg(0, std::ios::beg);
-
-    blockData.resize(dataSize);
-    if (!blockFile.read(blockData.data(), dataSize)) {
-        std::cerr << "Error: Could not read block data from file: " << blockFilePath << std::endl;
-        return false;
-    }
-    blockFile.close();
-    return true;
+// Function to map the block data from the .raw file. The mapping is handed to the renderer without copying it into
+// a separate buffer, so it must stay alive as long as the volume.
+bool readBlockData(const std::string& blockFilePath, liv::MappedFile& blockData) {
+    liv::MappingOptions options;
+    options.populate = getenv("LIV_MAP_POPULATE") != nullptr;
+    return blockData.open(blockFilePath, options);
 }
 
 // Function to read the block information from the .info file
@@ -92,29 +90,21 @@ bool areBlocksAdjacent(const BlockInfo& block1, const BlockInfo& block2) {
 }
 
 
-int main(int argc, char* argv[]) {
+// A block assigned to this rank, either mapped from a block file or read from a brick container
+struct Block {
+    liv::MappedFile mapped;
+    std::vector<char> loaded;
+    BlockInfo info;
+    int index;
 
-    // Command-line argument parsing
-    if (argc < 2) {
-        std::cerr << "Usage: mpirun -np <num_processes> ./program "
-                     "<data_directory> [<width> <height>]" << std::endl;
-        return EXIT_FAILURE;
-    }
+    char* data() { return mapped.data() != nullptr ? mapped.data() : loaded.data(); }
 
-    std::string dataDirectory = argv[1];
-    const auto [width, height] = argc >= 4
-        ? std::make_tuple(std::atoi(argv[2]), std::atoi(argv[3]))
-        : std::make_tuple(1280, 720);
-
-    auto livEngine = liv::LiVEngine::initialize(width, height, "NonConvexVolumesInterface");
-
-    int rank, numProcs;
-    MPI_Comm_rank(MPI_COMM_WORLD, &rank);
-    MPI_Comm_size(MPI_COMM_WORLD, &numProcs);
-
-    const auto numLayers = std::atoi(getEnvVar("LIV_NUM_LAYERS"));
-    int numBlocks = numLayers * numProcs;
+    size_t size() const { return mapped.data() != nullptr ? mapped.size() : loaded.size(); }
+};
 
+// Function to read the blocks of this rank from the directory volume_divider wrote for the total number of blocks
+bool loadBlocksFromDirectory(const std::string& dataDirectory, int rank, int numBlocks, std::vector<int>& datasetDimensions,
+                             int& datatypeValue, std::vector<Block>& blocks) {
     std::string infoFilePath;
     for (const auto& entry : std::filesystem::directory_iterator(dataDirectory)) {
         if (entry.path().extension() == ".info") {
@@ -124,35 +114,31 @@ int main(int argc, char* argv[]) {
     }
     if (infoFilePath.empty()) {
         std::cerr << "Error: No .info file found in directory: " << dataDirectory << ". Please ensure that there is a .info file containing the dimensions of the dataset as comma-seperated integers." << std::endl;
-        MPI_Finalize();
-        return EXIT_FAILURE;
+        return false;
     }
 
     std::ifstream infoFile(infoFilePath);
     if (!infoFile.is_open()) {
         std::cerr << "Error: Could not open info file: " << infoFilePath << std::endl;
-        MPI_Finalize();
-        return EXIT_FAILURE;
+        return false;
     }
 
-    int sizeX, sizeY, sizeZ, datatypeValue;
+    int sizeX, sizeY, sizeZ;
     infoFile >> sizeX >> sizeY >> sizeZ >> datatypeValue;
 
     if (infoFile.fail()) {
         std::cerr << "Error: Failed to read block info from file: " << infoFilePath << std::endl;
-        MPI_Finalize();
-        return EXIT_FAILURE;
+        return false;
     }
 
     if (datatypeValue != 8 && datatypeValue != 16) {
         std::cerr << "Error: Invalid datatype value in .info file: " << datatypeValue << ". Please ensure that the datatype value is either 8 or 16." << std::endl;
-        MPI_Finalize();
-        return EXIT_FAILURE;
+        return false;
     }
 
     infoFile.close();
 
-    std::vector<int> datasetDimensions = {sizeX, sizeY, sizeZ};
+    datasetDimensions = {sizeX, sizeY, sizeZ};
 
     // Construct the blocks directory path
     std::string blocksDirectory = dataDirectory + "/blocks" + std::to_string(numBlocks);
@@ -162,38 +148,146 @@ int main(int argc, char* argv[]) {
         if (rank == 0) {
             std::cerr << "Error: Blocks directory does not exist: " << blocksDirectory << std::endl;
         }
-        MPI_Finalize();
-        return EXIT_FAILURE;
+        return false;
     }
 
     // Assign and load blocks.
     using namespace std::string_literals;
 
-    struct Block {
-        std::vector<char> data;
-        BlockInfo info;
-        int index;
-    };
-    std::vector<Block> blocks {static_cast<std::size_t>(numLayers)};
     auto path = std::filesystem::path(blocksDirectory) / "";
 
-    for (int layer = 0; layer < numLayers; ++layer) {
+    for (int layer = 0; layer < static_cast<int>(blocks.size()); ++layer) {
         auto& block = blocks[layer];
-        block.index = layer*numProcs + (rank + layer) % numProcs;
 
         path.replace_filename("block_"s + std::to_string(block.index) + ".info");
         if (!readBlockInfo(path, blocks[layer].info)) {
-            MPI_Finalize();
-            return EXIT_FAILURE;
+            return false;
         }
 
         path.replace_extension(".raw");
-        if (!readBlockData(path, blocks[layer].data)) {
-            MPI_Finalize();
-            return EXIT_FAILURE;
+        if (!readBlockData(path, blocks[layer].mapped)) {
+            return false;
+        }
+    }
+    return true;
+}
+
+// Function to read the blocks of this rank from a brick container, decomposed into the total number of blocks
+bool loadBlocksFromContainer(const std::string& containerPath, int numBlocks, std::vector<int>& datasetDimensions,
+                             int& datatypeValue, std::vector<Block>& blocks) {
+    liv::BrickContainer container;
+    if (!container.open(containerPath)) {
+        return false;
+    }
+
+    const auto volume = container.getVolume();
+    datasetDimensions = {volume.dimensions[0], volume.dimensions[1], volume.dimensions[2]};
+    datatypeValue = volume.bitResolution;
+
+    int grid[3];
+    liv::computeBlockGrid(numBlocks, grid);
+
+    for (auto& block : blocks) {
+        const auto box = liv::blockBox(volume.dimensions, grid, block.index);
+        block.info = {box.extent[0], box.extent[1], box.extent[2], datatypeValue,
+                      static_cast<float>(box.offset[0]), static_cast<float>(box.offset[1]), static_cast<float>(box.offset[2])};
+        if (!container.readBox(box, block.loaded)) {
+            return false;
+        }
+    }
+    return true;
+}
+
+// Function to assign blocks to this rank. By default, every rank takes one block per layer, rotated across the ranks.
+// If LIV_BLOCK_ORDER is morton or hilbert, every rank takes a contiguous segment of the blocks along that curve,
+// which keeps the blocks of a rank, and of the ranks of a node, close together. Segments from a brick container are
+// balanced by the number of non-empty voxels, so ranks may receive different numbers of blocks.
+std::vector<int> assignBlocks(const std::string& dataDirectory, int rank, int numProcs, int numLayers) {
+    const int numBlocks = numLayers * numProcs;
+    std::vector<int> indices;
+
+    liv::CurveType curve;
+    const char* order = std::getenv("LIV_BLOCK_ORDER");
+    if (order == nullptr || !liv::curveTypeFromString(order, curve)) {
+        for (int layer = 0; layer < numLayers; ++layer) {
+            indices.push_back(layer*numProcs + (rank + layer) % numProcs);
+        }
+        return indices;
+    }
+
+    int grid[3];
+    liv::computeBlockGrid(numBlocks, grid);
+
+    std::vector<double> weights;
+    liv::BrickContainer container;
+    if (std::filesystem::is_regular_file(dataDirectory) && liv::isBrickContainer(dataDirectory)
+        && container.open(dataDirectory) && container.hasVoxelCounts()) {
+        const auto volume = container.getVolume();
+        for (int block = 0; block < numBlocks; ++block) {
+            // empty blocks still cost something to composite
+            weights.push_back(1.0 + container.estimateNonEmptyVoxels(liv::blockBox(volume.dimensions, grid, block)));
         }
     }
 
+    const auto curveOrder = liv::curveOrder(grid, curve);
+    const auto owners = liv::partitionAlongCurve(curveOrder, weights, numProcs);
+    for (int block : curveOrder) {
+        if (owners[block] == rank) {
+            indices.push_back(block);
+        }
+    }
+    return indices;
+}
+
+int main(int argc, char* argv[]) {
+
+    // Command-line argument parsing
+    if (argc < 2) {
+        std::cerr << "Usage: mpirun -np <num_processes> ./program "
+                     "<data_directory | volume.livb> [<width> <height>]" << std::endl;
+        return EXIT_FAILURE;
+    }
+
+    std::string dataDirectory = argv[1];
+    const auto [width, height] = argc >= 4
+        ? std::make_tuple(std::atoi(argv[2]), std::atoi(argv[3]))
+        : std::make_tuple(1280, 720);
+
+    // Bring up the JVM and renderer in the background while the blocks are loaded.
+    auto livEngine = liv::LiVEngine::initialize(width, height, "NonConvexVolumesInterface", true);
+
+    if (!livEngine.isApplicationRank()) {
+        livEngine.runVisualizationRank(false);
+        MPI_Finalize();
+        return EXIT_SUCCESS;
+    }
+
+    // The blocks are distributed over the ranks running the application only
+    int rank, numProcs;
+    MPI_Comm_rank(livEngine.applicationComm, &rank);
+    MPI_Comm_size(livEngine.applicationComm, &numProcs);
+
+    const auto numLayers = std::atoi(getEnvVar("LIV_NUM_LAYERS"));
+
+    std::vector<int> datasetDimensions;
+    int datatypeValue;
+    const int numBlocks = numLayers * numProcs;
+    const auto blockIndices = assignBlocks(dataDirectory, rank, numProcs, numLayers);
+    std::vector<Block> blocks {blockIndices.size()};
+    for (size_t i = 0; i < blocks.size(); ++i) {
+        blocks[i].index = blockIndices[i];
+    }
+
+    // Given a brick container, read the blocks of this rank from it for any number of blocks. Otherwise, read the
+    // blocks volume_divider wrote for this number of blocks.
+    const bool loaded = std::filesystem::is_regular_file(dataDirectory) && liv::isBrickContainer(dataDirectory)
+        ? loadBlocksFromContainer(dataDirectory, numBlocks, datasetDimensions, datatypeValue, blocks)
+        : loadBlocksFromDirectory(dataDirectory, rank, numBlocks, datasetDimensions, datatypeValue, blocks);
+    if (!loaded) {
+        MPI_Finalize();
+        return EXIT_FAILURE;
+    }
+
     // Count block adjacencies.
     int num_adjacent = 0;
     int num_non_adjavent = 0;
@@ -236,22 +330,38 @@ int main(int argc, char* argv[]) {
         std::cout << "    Position: (" << info.posX << ", " << info.posY << ", " << info.posZ << ")" << std::endl;
     }
 
-    // Pass volume data to renderer.
+    // Pass volume data to renderer, registering and updating all local blocks in one call each.
+    std::vector<float> positions;
+    std::vector<int> dimensions;
+    for (auto& block : blocks) {
+        positions.insert(positions.end(), {block.info.posX, block.info.posY, block.info.posZ});
+        dimensions.insert(dimensions.end(), {block.info.sizeX, block.info.sizeY, block.info.sizeZ});
+    }
+
     if(datatypeValue == 8) {
+        auto volumes = livEngine.createVolumes<char>(positions, dimensions);
+        std::vector<char*> buffers;
+        std::vector<long int> bufferSizes;
         for (auto& block : blocks) {
-            liv::createVolume<char>(&block.info.posX, &block.info.sizeX, &livEngine)
-                .update(block.data.data(), block.data.size());
+            buffers.push_back(block.data());
+            bufferSizes.push_back(static_cast<long int>(block.size()));
         }
+        livEngine.updateVolumes(volumes, buffers, bufferSizes);
     } else {
+        auto volumes = livEngine.createVolumes<unsigned short>(positions, dimensions);
+        std::vector<unsigned short*> buffers;
+        std::vector<long int> bufferSizes;
         for (auto& block : blocks) {
-            liv::createVolume<unsigned short>(&block.info.posX, &block.info.sizeX, &livEngine)
-                .update(reinterpret_cast<unsigned short*>(block.data.data()), block.data.size());
+            buffers.push_back(reinterpret_cast<unsigned short*>(block.data()));
+            bufferSizes.push_back(static_cast<long int>(block.size()));
         }
+        livEngine.updateVolumes(volumes, buffers, bufferSizes);
     }
 
     // Run renderer.
     livEngine.setSceneConfigured();
     renderThread.join();
+    livEngine.shutdown();
 
     // Finalize MPI
     MPI_Finalize();
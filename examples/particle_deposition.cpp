@@ -0,0 +1,124 @@
+#include <mpi.h>
+#include <iostream>
+#include <vector>
+#include <string>
+#include <cstdlib>
+#include <cmath>
+#include <random>
+#include <liv.h>
+#include <utils/ParticleDeposition.h>
+#include <utils/VolumeIO.h>
+#include <thread>
+
+// Function to generate the particles of this rank: a few Gaussian clusters spread over the whole domain, of which
+// every rank keeps the particles inside its own box, as a simulation with a domain decomposition would hold them.
+void generateParticles(const liv::DepositionGrid& grid, const int *gridDimensions, int numParticles,
+                       std::vector<float>& positions) {
+    std::mt19937 generator(42);
+    std::uniform_real_distribution<float> uniform(0.0f, 1.0f);
+    std::normal_distribution<float> spread(0.0f, 0.05f);
+
+    float centers[8][3];
+    for (auto& center : centers) {
+        for (float& coordinate : center) {
+            coordinate = 0.2f + 0.6f * uniform(generator);
+        }
+    }
+
+    positions.clear();
+    for (int p = 0; p < numParticles; p++) {
+        const auto& center = centers[p % 8];
+        float position[3];
+        bool inside = true;
+        for (int axis = 0; axis < 3; axis++) {
+            position[axis] = (center[axis] + spread(generator)) * gridDimensions[axis] * grid.cellSize[axis];
+            const int cell = static_cast<int>(std::floor(position[axis] / grid.cellSize[axis]));
+            inside &= cell >= grid.box.offset[axis] && cell < grid.box.offset[axis] + grid.box.extent[axis];
+        }
+        if (inside) {
+            positions.insert(positions.end(), position, position + 3);
+        }
+    }
+}
+
+int main(int argc, char* argv[]) {
+    // Command-line argument parsing
+    if (argc < 2) {
+        std::cerr << "Usage: mpirun -np <num_processes> ./program "
+                     "<grid_size> [<ngp | cic | tsc> [<num_particles>]]" << std::endl;
+        return EXIT_FAILURE;
+    }
+
+    const int gridSize = std::atoi(argv[1]);
+    liv::DepositionKernel kernel = liv::DepositionKernel::CloudInCell;
+    if (argc >= 3 && !liv::depositionKernelFromString(argv[2], kernel)) {
+        std::cerr << "Error: Unknown deposition kernel " << argv[2] << std::endl;
+        return EXIT_FAILURE;
+    }
+    const int numParticles = argc >= 4 ? std::atoi(argv[3]) : 1000000;
+
+    auto livEngine = liv::LiVEngine::initialize(1280, 720, "ConvexVolumesInterface");
+
+    if (!livEngine.isApplicationRank()) {
+        livEngine.runVisualizationRank();
+        MPI_Finalize();
+        return EXIT_SUCCESS;
+    }
+
+    // The blocks are distributed over the ranks running the application only
+    int rank, numProcs;
+    MPI_Comm_rank(livEngine.applicationComm, &rank);
+    MPI_Comm_size(livEngine.applicationComm, &numProcs);
+
+    // Every rank deposits onto its block of a regular decomposition of the grid
+    const int gridDimensions[3] = {gridSize, gridSize, gridSize};
+    int blockGrid[3];
+    liv::computeBlockGrid(numProcs, blockGrid);
+
+    liv::DepositionGrid grid{};
+    grid.box = liv::blockBox(gridDimensions, blockGrid, rank);
+    for (int axis = 0; axis < 3; axis++) {
+        grid.origin[axis] = 0.0f;
+        grid.cellSize[axis] = 1.0f;
+    }
+
+    std::vector<float> positions;
+    generateParticles(grid, gridDimensions, numParticles, positions);
+
+    liv::ParticleDeposition deposition(grid, kernel, livEngine.applicationComm);
+    if (!deposition.deposit(positions.data(), nullptr, positions.size() / 3)) {
+        MPI_Finalize();
+        return EXIT_FAILURE;
+    }
+
+    std::cout << "Process " << rank << " deposited " << positions.size() / 3 << " particles, exchanging with "
+              << deposition.getNeighbours().size() << " neighbours" << std::endl;
+
+    std::thread renderThread([&livEngine]() { livEngine.doRender(); });
+
+    livEngine.setVolumeDimensions({gridSize, gridSize, gridSize});
+
+    const auto& box = grid.box;
+    livEngine.addProcessorDataCollective({static_cast<float>(box.offset[0]), static_cast<float>(box.offset[1]),
+                                          static_cast<float>(box.offset[2])},
+                                         {static_cast<float>(box.extent[0]), static_cast<float>(box.extent[1]),
+                                          static_cast<float>(box.extent[2])});
+
+    float pixelToWorld = livEngine.getVolumeScaling();
+
+    float position[3] = {box.offset[0] * pixelToWorld, box.offset[1] * (-1 * pixelToWorld), box.offset[2] * pixelToWorld};
+
+    // The deposited weights are quantized for rendering, with the range of all ranks
+    auto& brick = deposition.getBrick();
+    auto volume = liv::createVolume<float>(position, box.extent, &livEngine);
+    volume.update(brick.data(), static_cast<long int>(brick.size() * sizeof(float)));
+
+    livEngine.setSceneConfigured();
+
+    renderThread.join();
+    livEngine.shutdown();
+
+    // Finalize MPI
+    MPI_Finalize();
+    return EXIT_SUCCESS;
+}
@@ -0,0 +1,129 @@
+#include <mpi.h>
+#include <iostream>
+#include <vector>
+#include <string>
+#include <cstdlib>
+#include <liv.h>
+#include <utils/BrickContainer.h>
+#include <utils/TimestepPrefetcher.h>
+#include <thread>
+
+// Function to read the block of this rank from one timestep. Every timestep must have the volume description of the
+// first one, so that the block keeps its size and place.
+bool readTimestepBlock(const std::string& timestepFilePath, const liv::VolumeDescription& volume, const liv::Box& box,
+                       std::vector<char>& blockData) {
+    liv::BrickContainer container;
+    if (!container.open(timestepFilePath)) {
+        return false;
+    }
+
+    const auto description = container.getVolume();
+    for (int axis = 0; axis < 3; axis++) {
+        if (description.dimensions[axis] != volume.dimensions[axis]) {
+            std::cerr << "Error: Timestep " << timestepFilePath << " differs in size from the first timestep" << std::endl;
+            return false;
+        }
+    }
+    if (description.bitResolution != volume.bitResolution) {
+        std::cerr << "Error: Timestep " << timestepFilePath << " differs in bit resolution from the first timestep" << std::endl;
+        return false;
+    }
+
+    return container.readBox(box, blockData);
+}
+
+// Function to play all timesteps into the volume and print how well I/O kept up. The playback holds the last
+// timestep, so it is kept until rendering ends.
+template <typename T>
+void playTimesteps(liv::Volume<T>& volume, const std::vector<std::string>& timestepFiles,
+                   const liv::VolumeBlock& block, double stepsPerSecond, int loops, int rank, std::thread& renderThread) {
+    liv::TimeSeriesPlayback<T> playback(volume, [&](int step, std::vector<char>& data) {
+        return readTimestepBlock(timestepFiles[step], block.volume, block.box, data);
+    }, static_cast<int>(timestepFiles.size()), stepsPerSecond);
+
+    const auto statistics = playback.play(loops);
+
+    std::cout << "Process " << rank << " played " << statistics.steps << " timesteps, "
+              << statistics.lateSteps << " late, mean read " << statistics.meanReadSeconds
+              << " s, longest wait " << statistics.maxWaitSeconds << " s" << std::endl;
+
+    renderThread.join();
+}
+
+int main(int argc, char* argv[]) {
+    // Command-line argument parsing
+    if (argc < 2) {
+        std::cerr << "Usage: mpirun -np <num_processes> ./program "
+                     "<timestep_directory> [<steps_per_second> [<loops>]]" << std::endl;
+        return EXIT_FAILURE;
+    }
+
+    std::string timestepDirectory = argv[1];
+    const double stepsPerSecond = argc >= 3 ? std::atof(argv[2]) : 10.0;
+    const int loops = argc >= 4 ? std::atoi(argv[3]) : 1;
+
+    auto livEngine = liv::LiVEngine::initialize(1280, 720, "ConvexVolumesInterface");
+
+    if (!livEngine.isApplicationRank()) {
+        livEngine.runVisualizationRank();
+        MPI_Finalize();
+        return EXIT_SUCCESS;
+    }
+
+    // The blocks are distributed over the ranks running the application only
+    int rank, numProcs;
+    MPI_Comm_rank(livEngine.applicationComm, &rank);
+    MPI_Comm_size(livEngine.applicationComm, &numProcs);
+
+    // Timesteps are brick containers written by volume_divider --container, in the order of their file names
+    const auto timestepFiles = liv::listTimestepFiles(timestepDirectory, ".livb");
+    if (timestepFiles.empty()) {
+        std::cerr << "Error: No .livb timesteps found in " << timestepDirectory << std::endl;
+        MPI_Finalize();
+        return EXIT_FAILURE;
+    }
+
+    // The header of the first timestep decides the size of the volume and the block of every rank
+    liv::VolumeBlock block;
+    {
+        liv::BrickContainer first;
+        if (!first.open(timestepFiles.front())) {
+            MPI_Finalize();
+            return EXIT_FAILURE;
+        }
+        block.volume = first.getVolume();
+    }
+    int blockGrid[3];
+    liv::computeBlockGrid(numProcs, blockGrid);
+    block.box = liv::blockBox(block.volume.dimensions, blockGrid, rank);
+
+    std::thread renderThread([&livEngine]() { livEngine.doRender(); });
+
+    livEngine.setVolumeDimensions({block.volume.dimensions[0], block.volume.dimensions[1], block.volume.dimensions[2]});
+
+    livEngine.addProcessorDataCollective({static_cast<float>(block.box.offset[0]), static_cast<float>(block.box.offset[1]),
+                                          static_cast<float>(block.box.offset[2])},
+                                         {static_cast<float>(block.box.extent[0]), static_cast<float>(block.box.extent[1]),
+                                          static_cast<float>(block.box.extent[2])});
+
+    float pixelToWorld = livEngine.getVolumeScaling();
+
+    float position[3] = {block.box.offset[0] * pixelToWorld, block.box.offset[1] * (-1 * pixelToWorld),
+                         block.box.offset[2] * pixelToWorld};
+
+    livEngine.setSceneConfigured();
+
+    if (block.volume.bitResolution == 8) {
+        auto volume = liv::createVolume<char>(position, block.box.extent, &livEngine);
+        playTimesteps(volume, timestepFiles, block, stepsPerSecond, loops, rank, renderThread);
+    } else {
+        auto volume = liv::createVolume<unsigned short>(position, block.box.extent, &livEngine);
+        playTimesteps(volume, timestepFiles, block, stepsPerSecond, loops, rank, renderThread);
+    }
+
+    livEngine.shutdown();
+
+    // Finalize MPI
+    MPI_Finalize();
+    return EXIT_SUCCESS;
+}
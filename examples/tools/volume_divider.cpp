@@ -5,17 +5,19 @@
 #include <cmath>
 #include <cstdlib>
 #include <cstring>
+#include <cerrno>
 #include <algorithm>
+#include <atomic>
+#include <future>
+#include <thread>
 #include <sys/stat.h> // For mkdir
 #include <climits>    // For INT_MAX
 #include <sys/types.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <utils/BrickContainer.h>
 
-#if defined(_WIN32)
-#include <direct.h>   // For _mkdir
-#define MKDIR(path) _mkdir(path)
-#else
 #define MKDIR(path) mkdir(path, 0755)
-#endif
 
 struct VolumeInfo {
     int x_dim;
@@ -24,6 +26,13 @@ struct VolumeInfo {
     int bit_resolution;
 };
 
+// A block of one decomposition, written to blockDir/block_<index>.raw
+struct BlockTask {
+    std::string rawFileName;
+    int startX, startY, startZ;
+    int sizeX, sizeY, sizeZ;
+};
+
 // Function to parse the .info file
 bool parseInfoFile(const std::string& infoFilePath, VolumeInfo& volInfo) {
     std::ifstream infoFile(infoFilePath);
@@ -75,70 +84,201 @@ void computeSubdivision(int numDivisions, int& nx, int& ny, int& nz) {
     }
 }
 
-bool readVolumeData(const std::string& volumeFilePath, std::vector<char>& volumeData, const VolumeInfo& volInfo) {
-    std::ifstream volumeFile(volumeFilePath, std::ios::binary);
-    if (!volumeFile.is_open()) {
-        std::cerr << "Error: Could not open volume file: " << volumeFilePath << std::endl;
-        return false;
+// Function to split a dimension into the given number of blocks, giving the remainder to the first blocks
+std::vector<int> computeBlockSizes(int dimension, int numBlocks) {
+    std::vector<int> sizes(numBlocks, dimension / numBlocks);
+    for (int i = 0; i < dimension % numBlocks; ++i) {
+        sizes[i]++;
     }
+    return sizes;
+}
 
-    size_t dataSize = static_cast<size_t>(volInfo.x_dim) * volInfo.y_dim * volInfo.z_dim * (volInfo.bit_resolution / 8);
-    volumeData.resize(dataSize);
+// Functions to read and write at an offset until all bytes are transferred
+bool preadAll(int fd, char* buffer, size_t size, off_t offset) {
+    while (size > 0) {
+        ssize_t count = pread(fd, buffer, size, offset);
+        if (count < 0 && errno == EINTR) continue;
+        if (count <= 0) return false;
+        buffer += count;
+        size -= static_cast<size_t>(count);
+        offset += count;
+    }
+    return true;
+}
 
-    volumeFile.read(reinterpret_cast<char*>(volumeData.data()), dataSize);
-    if (!volumeFile) {
-        std::cerr << "Error: Could not read volume data." << std::endl;
-        return false;
+bool pwriteAll(int fd, const char* buffer, size_t size, off_t offset) {
+    while (size > 0) {
+        ssize_t count = pwrite(fd, buffer, size, offset);
+        if (count < 0 && errno == EINTR) continue;
+        if (count <= 0) return false;
+        buffer += count;
+        size -= static_cast<size_t>(count);
+        offset += count;
     }
-    volumeFile.close();
     return true;
 }
 
-bool writeBlockData(const std::string& blockDir, int blockIndex, const std::vector<char>& blockData,
-                    int bx, int by, int bz, const VolumeInfo& volInfo, int startX, int startY, int startZ) {
-    std::string blockFileName = blockDir + "/block_" + std::to_string(blockIndex) + ".raw";
-    std::ofstream blockFile(blockFileName, std::ios::binary);
-    if (!blockFile.is_open()) {
-        std::cerr << "Error: Could not open block file for writing: " << blockFileName << std::endl;
-        return false;
+// Function to create the block files of one decomposition: the .info file, and the .raw file preallocated to its
+// final size, so that blocks can be filled with positioned writes in any order
+bool createBlockFiles(const std::string& blockDir, int numDivisions, const VolumeInfo& volInfo,
+                      std::vector<BlockTask>& tasks) {
+    int nx, ny, nz;
+    computeSubdivision(numDivisions, nx, ny, nz);
+
+    std::vector<int> blockSizesX = computeBlockSizes(volInfo.x_dim, nx);
+    std::vector<int> blockSizesY = computeBlockSizes(volInfo.y_dim, ny);
+    std::vector<int> blockSizesZ = computeBlockSizes(volInfo.z_dim, nz);
+
+    const size_t elementSize = volInfo.bit_resolution / 8;
+    int blockIndex = 0;
+    int startZ = 0;
+    for (int bz = 0; bz < nz; ++bz) {
+        int startY = 0;
+        for (int by = 0; by < ny; ++by) {
+            int startX = 0;
+            for (int bx = 0; bx < nx; ++bx) {
+                BlockTask task{blockDir + "/block_" + std::to_string(blockIndex) + ".raw",
+                               startX, startY, startZ, blockSizesX[bx], blockSizesY[by], blockSizesZ[bz]};
+
+                int fd = open(task.rawFileName.c_str(), O_WRONLY | O_CREAT | O_TRUNC, 0644);
+                if (fd < 0) {
+                    std::cerr << "Error: Could not open block file for writing: " << task.rawFileName << std::endl;
+                    return false;
+                }
+                const off_t blockSize = static_cast<off_t>(task.sizeX) * task.sizeY * task.sizeZ * elementSize;
+                // fall back to a sparse file where the file system cannot allocate up front
+                if (blockSize > 0 && posix_fallocate(fd, 0, blockSize) != 0 && ftruncate(fd, blockSize) != 0) {
+                    std::cerr << "Error: Could not allocate block file: " << task.rawFileName << std::endl;
+                    close(fd);
+                    return false;
+                }
+                close(fd);
+
+                // Write the .info file for this block
+                std::string infoFileName = blockDir + "/block_" + std::to_string(blockIndex) + ".info";
+                std::ofstream infoFile(infoFileName);
+                if (!infoFile.is_open()) {
+                    std::cerr << "Error: Could not open block info file for writing: " << infoFileName << std::endl;
+                    return false;
+                }
+                // Write size
+                infoFile << task.sizeX << " " << task.sizeY << " " << task.sizeZ << std::endl;
+                // Write bit resolution
+                infoFile << volInfo.bit_resolution << std::endl;
+                // Write location (Front Bottom Left coordinates)
+                infoFile << startX << " " << startY << " " << startZ << std::endl;
+                infoFile.close();
+
+                tasks.push_back(std::move(task));
+                blockIndex++;
+                startX += blockSizesX[bx];
+            }
+            startY += blockSizesY[by];
+        }
+        startZ += blockSizesZ[bz];
     }
+    return true;
+}
 
-    blockFile.write(reinterpret_cast<const char*>(blockData.data()), blockData.size());
-    blockFile.close();
+// Function to write the part of a block that lies in the slab of z-slices [slabStart, slabEnd). Each z-slice of the
+// block is gathered into the staging buffer and written with a single positioned write.
+bool writeBlockSlab(const BlockTask& task, const VolumeInfo& volInfo, const char* slab, int slabStart, int slabEnd,
+                    std::vector<char>& staging) {
+    const int zBegin = std::max(slabStart, task.startZ);
+    const int zEnd = std::min(slabEnd, task.startZ + task.sizeZ);
+    if (zBegin >= zEnd) {
+        return true;
+    }
 
-    // Write the .info file for this block
-    std::string infoFileName = blockDir + "/block_" + std::to_string(blockIndex) + ".info";
-    std::ofstream infoFile(infoFileName);
-    if (!infoFile.is_open()) {
-        std::cerr << "Error: Could not open block info file for writing: " << infoFileName << std::endl;
+    int fd = open(task.rawFileName.c_str(), O_WRONLY);
+    if (fd < 0) {
+        std::cerr << "Error: Could not open block file for writing: " << task.rawFileName << std::endl;
         return false;
     }
-    // Write size
-    infoFile << bx << " " << by << " " << bz << std::endl;
-    // Write bit resolution
-    infoFile << volInfo.bit_resolution << std::endl;
-    // Write location (Front Bottom Left coordinates)
-    infoFile << startX << " " << startY << " " << startZ << std::endl;
-    infoFile.close();
 
-    return true;
+    const size_t elementSize = volInfo.bit_resolution / 8;
+    const size_t rowLength = static_cast<size_t>(task.sizeX) * elementSize;
+    const size_t sliceLength = rowLength * task.sizeY;
+    const size_t volumeRowLength = static_cast<size_t>(volInfo.x_dim) * elementSize;
+    staging.resize(sliceLength);
+
+    bool success = true;
+    for (int z = zBegin; z < zEnd && success; ++z) {
+        const char* source = slab + (static_cast<size_t>(z - slabStart) * volInfo.y_dim + task.startY) * volumeRowLength
+                             + static_cast<size_t>(task.startX) * elementSize;
+        for (int y = 0; y < task.sizeY; ++y) {
+            std::memcpy(staging.data() + y * rowLength, source + y * volumeRowLength, rowLength);
+        }
+        success = pwriteAll(fd, staging.data(), sliceLength, static_cast<off_t>(z - task.startZ) * sliceLength);
+    }
+    close(fd);
+
+    if (!success) {
+        std::cerr << "Error: Could not write block data to file: " << task.rawFileName << std::endl;
+    }
+    return success;
+}
+
+// Function to write a brick of the container from the slab of z-slices starting at slabStart, which contains it
+bool writeContainerBrick(liv::BrickContainerWriter& container, int brickIndex, const VolumeInfo& volInfo,
+                         const char* slab, int slabStart, std::vector<char>& staging) {
+    const size_t elementSize = volInfo.bit_resolution / 8;
+    const liv::Box box = container.getGrid().brickBox(brickIndex);
+    staging.resize(box.numVoxels() * elementSize);
+
+    const size_t slabStrides[3] = {elementSize, elementSize * volInfo.x_dim, elementSize * volInfo.x_dim * volInfo.y_dim};
+    const size_t brickStrides[3] = {elementSize, elementSize * box.extent[0], elementSize * box.extent[0] * box.extent[1]};
+    const char* source = slab + box.offset[0] * slabStrides[0] + box.offset[1] * slabStrides[1]
+                         + (box.offset[2] - slabStart) * slabStrides[2];
+    liv::copyBox(source, slabStrides, staging.data(), brickStrides, box.extent, elementSize);
+
+    return container.writeBrick(brickIndex, staging.data());
 }
 
 int main(int argc, char* argv[]) {
-    if (argc != 4) {
-        std::cerr << "Usage: volume_divider <volume_file_path> <base_output_directory> <number_of_divisions>" << std::endl;
+    if (argc < 4) {
+        std::cerr << "Usage: volume_divider <volume_file_path> <base_output_directory> <number_of_divisions>... "
+                     "[--threads <count>] [--slab-memory <MiB>] [--container [--brick-size <voxels>] [--compress]]" << std::endl;
         return EXIT_FAILURE;
     }
 
     std::string volumeFilePath = argv[1];
     std::string baseOutputDir = argv[2];
-    int numDivisions = std::atoi(argv[3]);
+
+    // Several decompositions are written in one pass over the volume
+    std::vector<int> divisions;
+    int numThreads = static_cast<int>(std::max(1u, std::thread::hardware_concurrency()));
+    size_t slabMemory = 1024;
+    // Optionally write a single brick container, from which blocks for any number of ranks can be read
+    bool writeContainer = false;
+    int containerBrickSize = 64;
+    auto containerCompression = liv::BrickCompression::None;
+    for (int i = 3; i < argc; ++i) {
+        std::string argument = argv[i];
+        if (argument == "--threads" && i + 1 < argc) {
+            numThreads = std::atoi(argv[++i]);
+        } else if (argument == "--slab-memory" && i + 1 < argc) {
+            slabMemory = std::strtoull(argv[++i], nullptr, 10);
+        } else if (argument == "--container") {
+            writeContainer = true;
+        } else if (argument == "--brick-size" && i + 1 < argc) {
+            containerBrickSize = std::atoi(argv[++i]);
+        } else if (argument == "--compress") {
+            containerCompression = liv::BrickCompression::Deflate;
+        } else {
+            divisions.push_back(std::atoi(argv[i]));
+        }
+    }
 
     // Ensure number of divisions is positive
-    if (numDivisions <= 0) {
+    if ((divisions.empty() && !writeContainer) || std::any_of(divisions.begin(), divisions.end(), [](int n) { return n <= 0; })) {
         std::cerr << "Error: Number of divisions must be a positive integer." << std::endl;
         return EXIT_FAILURE;
     }
+    if (numThreads <= 0 || slabMemory == 0 || containerBrickSize <= 0) {
+        std::cerr << "Error: Number of threads, slab memory and brick size must be positive." << std::endl;
+        return EXIT_FAILURE;
+    }
 
     // Read the .info file
     std::string infoFilePath = volumeFilePath.substr(0, volumeFilePath.find_last_of('.')) + ".info";
@@ -147,89 +287,131 @@ int main(int argc, char* argv[]) {
         return EXIT_FAILURE;
     }
 
-    // Read the volume data
-    std::vector<char> volumeData;
-    if (!readVolumeData(volumeFilePath, volumeData, volInfo)) {
+    int volumeFile = open(volumeFilePath.c_str(), O_RDONLY);
+    if (volumeFile < 0) {
+        std::cerr << "Error: Could not open volume file: " << volumeFilePath << std::endl;
         return EXIT_FAILURE;
     }
+    posix_fadvise(volumeFile, 0, 0, POSIX_FADV_SEQUENTIAL);
 
-    // Compute the subdivision
-    int nx, ny, nz;
-    computeSubdivision(numDivisions, nx, ny, nz);
+    // Create the dataset directory within the base output directory
+    std::string volumeFileName = volumeFilePath.substr(volumeFilePath.find_last_of("/\\") + 1);
+    std::string volumeName = volumeFileName.substr(0, volumeFileName.find_last_of('.'));
+    std::string datasetDir = baseOutputDir + "/" + volumeName;
 
-    // Compute block sizes
-    std::vector<int> blockSizesX(nx, volInfo.x_dim / nx);
-    std::vector<int> blockSizesY(ny, volInfo.y_dim / ny);
-    std::vector<int> blockSizesZ(nz, volInfo.z_dim / nz);
+    // Create directories if they don't exist
+    MKDIR(baseOutputDir.c_str());
+    MKDIR(datasetDir.c_str());
 
-    // Distribute remainders
-    int remainderX = volInfo.x_dim % nx;
-    for (int i = 0; i < remainderX; ++i) {
-        blockSizesX[i]++;
+    // Create the blocksN directories and preallocate all block files
+    std::vector<BlockTask> tasks;
+    for (int numDivisions : divisions) {
+        std::string blockDirName = datasetDir + "/blocks" + std::to_string(numDivisions);
+        MKDIR(blockDirName.c_str());
+        if (!createBlockFiles(blockDirName, numDivisions, volInfo, tasks)) {
+            close(volumeFile);
+            return EXIT_FAILURE;
+        }
     }
 
-    int remainderY = volInfo.y_dim % ny;
-    for (int i = 0; i < remainderY; ++i) {
-        blockSizesY[i]++;
+    liv::BrickContainerWriter container;
+    const std::string containerFileName = datasetDir + "/" + volumeName + ".livb";
+    const int brickSize[3] = {containerBrickSize, containerBrickSize, containerBrickSize};
+    if (writeContainer) {
+        const liv::VolumeDescription description{{volInfo.x_dim, volInfo.y_dim, volInfo.z_dim}, volInfo.bit_resolution};
+        if (!container.open(containerFileName, description, brickSize, containerCompression)) {
+            close(volumeFile);
+            return EXIT_FAILURE;
+        }
     }
 
-    int remainderZ = volInfo.z_dim % nz;
-    for (int i = 0; i < remainderZ; ++i) {
-        blockSizesZ[i]++;
+    // Stream the volume in slabs of whole z-slices. The next slab is read while the blocks are filled from the
+    // current one, so that at most two slabs are held in memory.
+    const size_t sliceSize = static_cast<size_t>(volInfo.x_dim) * volInfo.y_dim * (volInfo.bit_resolution / 8);
+    int slabDepth = static_cast<int>(std::clamp<size_t>(slabMemory * 1024 * 1024 / 2 / std::max<size_t>(sliceSize, 1),
+                                                        1, std::max(volInfo.z_dim, 1)));
+    // Every brick of the container must lie within a single slab
+    if (writeContainer) {
+        slabDepth = std::max(slabDepth / containerBrickSize, 1) * containerBrickSize;
     }
 
-    // Create the dataset directory within the base output directory
-    std::string volumeFileName = volumeFilePath.substr(volumeFilePath.find_last_of("/\\") + 1);
-    std::string volumeName = volumeFileName.substr(0, volumeFileName.find_last_of('.'));
-    std::string datasetDir = baseOutputDir + "/" + volumeName;
+    auto readSlab = [&](int slabStart, std::vector<char>& slab) {
+        const int depth = std::min(slabDepth, volInfo.z_dim - slabStart);
+        slab.resize(static_cast<size_t>(depth) * sliceSize);
+        return preadAll(volumeFile, slab.data(), slab.size(), static_cast<off_t>(slabStart) * sliceSize);
+    };
 
-    // Create directories if they don't exist
-    MKDIR(baseOutputDir.c_str());
-    MKDIR(datasetDir.c_str());
+    std::vector<char> slabs[2];
+    if (volInfo.z_dim > 0 && !readSlab(0, slabs[0])) {
+        std::cerr << "Error: Could not read volume data." << std::endl;
+        close(volumeFile);
+        return EXIT_FAILURE;
+    }
 
-    // Create the blocksN directory
-    std::string blockDirName = datasetDir + "/blocks" + std::to_string(numDivisions);
-    MKDIR(blockDirName.c_str());
+    bool success = true;
+    int current = 0;
+    for (int slabStart = 0; slabStart < volInfo.z_dim && success; slabStart += slabDepth) {
+        const int slabEnd = std::min(slabStart + slabDepth, volInfo.z_dim);
 
-    // Divide the volume into blocks
-    int blockIndex = 0;
-    int startZ = 0;
-    for (int bz = 0; bz < nz; ++bz) {
-        int bzSize = blockSizesZ[bz];
-        int startY = 0;
-        for (int by = 0; by < ny; ++by) {
-            int bySize = blockSizesY[by];
-            int startX = 0;
-            for (int bx = 0; bx < nx; ++bx) {
-                int bxSize = blockSizesX[bx];
-
-                // Extract the block data
-                std::vector<char> blockData;
-                for (int z = startZ; z < startZ + bzSize; ++z) {
-                    for (int y = startY; y < startY + bySize; ++y) {
-                        size_t offset = ((size_t)z * volInfo.y_dim * volInfo.x_dim) + (y * volInfo.x_dim) + startX;
-                        size_t length = bxSize;
-                        size_t dataOffset = offset * (volInfo.bit_resolution / 8);
-                        blockData.insert(blockData.end(),
-                            volumeData.begin() + dataOffset,
-                            volumeData.begin() + dataOffset + length * (volInfo.bit_resolution / 8));
-                    }
-                }
+        std::future<bool> nextSlab;
+        if (slabEnd < volInfo.z_dim) {
+            nextSlab = std::async(std::launch::async, readSlab, slabEnd, std::ref(slabs[1 - current]));
+        }
 
-                // Write the block data to a file
-                if (!writeBlockData(blockDirName, blockIndex, blockData, bxSize, bySize, bzSize,
-                                    volInfo, startX, startY, startZ)) {
-                    return EXIT_FAILURE;
+        // Container bricks starting in this slab, which they lie in completely
+        std::vector<int> slabBricks;
+        if (writeContainer) {
+            const int offset[3] = {0, 0, slabStart};
+            const int extent[3] = {volInfo.x_dim, volInfo.y_dim, slabEnd - slabStart};
+            slabBricks = container.getGrid().bricksIntersecting(offset, extent);
+        }
+        const size_t numTasks = tasks.size() + slabBricks.size();
+
+        // Blocks are written to separate files and bricks to separate parts of the container, so threads take whole
+        // blocks and bricks without further synchronization
+        std::atomic<size_t> nextTask{0};
+        std::atomic<bool> failed{false};
+        std::vector<std::thread> workers;
+        for (int t = 0; t < numThreads; ++t) {
+            workers.emplace_back([&]() {
+                std::vector<char> staging;
+                for (size_t i = nextTask++; i < numTasks && !failed; i = nextTask++) {
+                    const bool written = i < tasks.size()
+                        ? writeBlockSlab(tasks[i], volInfo, slabs[current].data(), slabStart, slabEnd, staging)
+                        : writeContainerBrick(container, slabBricks[i - tasks.size()], volInfo, slabs[current].data(),
+                                              slabStart, staging);
+                    if (!written) {
+                        failed = true;
+                    }
                 }
+            });
+        }
+        for (auto& worker : workers) {
+            worker.join();
+        }
+        success = !failed;
 
-                blockIndex++;
-                startX += bxSize;
-            }
-            startY += bySize;
+        if (nextSlab.valid() && !nextSlab.get()) {
+            std::cerr << "Error: Could not read volume data." << std::endl;
+            success = false;
         }
-        startZ += bzSize;
+        current = 1 - current;
     }
+    close(volumeFile);
 
-    std::cout << "Volume divided into " << blockIndex << " blocks." << std::endl;
+    if (writeContainer) {
+        success = container.close() && success;
+    }
+    if (!success) {
+        return EXIT_FAILURE;
+    }
+
+    if (writeContainer) {
+        std::cout << "Volume written to brick container " << containerFileName << "." << std::endl;
+    }
+
+    for (int numDivisions : divisions) {
+        std::cout << "Volume divided into " << numDivisions << " blocks." << std::endl;
+    }
     return EXIT_SUCCESS;
 }
@@ -5,6 +5,7 @@
 #ifndef DISTRIBUTEDVIS_JVMDATA_HPP
 #define DISTRIBUTEDVIS_JVMDATA_HPP
 
+#include <chrono>
 #include <cstring>
 #include <fstream>
 #include <vector>
@@ -12,15 +13,26 @@
 #include <dirent.h>
 #include <iostream>
 #include <string>
+#include <utils/JVMConfiguration.h>
 #include <utils/JVMUtils.h>
 
-static const char* getEnvVar(const char* varName, const bool null_is_error = true) {
-    const char* value = getenv(varName);
-    if (value == nullptr && null_is_error) {
-        std::cerr << "ERROR: " << varName << " environment variable is not set." << std::endl;
-        std::exit(EXIT_FAILURE);
-    }
-    return value;
+/**
+ * Wall-clock durations of the phases of bringing up the JVM and the renderer, in seconds.
+ */
+struct StartupTimings {
+    // resolving the class path and options and distributing them to all ranks
+    double configuration = 0.0;
+    double vmCreation = 0.0;
+    double classLookup = 0.0;
+    double rendererConstruction = 0.0;
+    // time from the start of LiVEngine construction until the renderer reported that it is ready
+    double rendererReady = 0.0;
+    // time the application thread spent blocked on start-up
+    double blocked = 0.0;
+};
+
+inline double secondsSince(std::chrono::steady_clock::time_point begin) {
+    return std::chrono::duration<double>(std::chrono::steady_clock::now() - begin).count();
 }
 
 class JVMData {
@@ -29,6 +41,7 @@ public:
     jclass clazz;
     jobject obj;
     JNIEnv *env;
+    StartupTimings timings;
 
     explicit JVMData(
         int windowWidth,
@@ -36,7 +49,9 @@ public:
         int rank,
         int commSize,
         int nodeRank,
-        const std::string& className
+        const std::string& className,
+        const liv::JVMConfiguration& configuration,
+        const liv::JVMNodeOptions& nodeOptions
     );
 };
 
@@ -46,118 +61,20 @@ inline JVMData::JVMData(
     int rank,
     int commSize,
     int nodeRank,
-    const std::string& className
+    const std::string& className,
+    const liv::JVMConfiguration& configuration,
+    const liv::JVMNodeOptions& nodeOptions
 ) {
-    DIR *dir;
-    struct dirent *ent;
-    std::string classPath = "-Djava.class.path=";
-    //"/home/aryaman/Repositories/LiV-renderer/build/libs/";
-    std::string directory = getEnvVar("SCENERY_CLASS_PATH");
-    // std::string directory = "/home/aryaman/Repositories/LiV-renderer/build/libs/";
-
-
-    if ((dir = opendir (directory.c_str())) != nullptr) {
-        while ((ent = readdir (dir)) != nullptr) {
-            classPath.append(directory);
-            classPath.append(ent->d_name);
-            classPath.append(":");
-        }
-        closedir (dir);
-    } else {
-        /* could not open directory */
-        std::cerr << "ERROR: Could not open directory "<< directory <<std::endl;
-        std::exit(EXIT_FAILURE);
-    }
-
     auto fullClassName = "graphics/scenery/tests/interfaces/" + className;
 
-    JavaVMInitArgs vm_args;
-    std::ifstream optionsFile("liv_jvm_options.txt");
-    std::vector<std::string> additionalOptions;
-
-    int num_additional_options = 0;
+    // the class path and the options were resolved once and broadcast, see liv::broadcastJVMConfiguration
+    const auto optionStrings = liv::buildJVMOptions(configuration, rank, nodeOptions);
 
-    if (optionsFile.is_open()) {
-        std::cout << "Found additional JVM options file, reading options..." << std::endl;
-        std::string line;
-
-        while (std::getline(optionsFile, line)) {
-            if (!line.empty()) {
-                additionalOptions.push_back(line);
-                num_additional_options++;
-            }
-        }
-        optionsFile.close();
-    } else {
-        std::cout << "Did not find additional JVM options file, using default options. If you want to use custom options, "
-                     "please create a file named liv_jvm_options.txt in the current directory." << std::endl;
-    }
-
-    // Handle LiV-Test-Benchmark environment variable and add JVM options accordingly
-    const char* benchmarkEnv = getenv("LiV-Test-Benchmark");
-    if ((benchmarkEnv == nullptr || std::string(benchmarkEnv) == "false") && rank == 0) {
-        additionalOptions.push_back("-Dscenery.ServerAddress=tcp://127.0.0.1");
-        additionalOptions.push_back("-Dscenery.RemoteCamera=true");
-        num_additional_options += 2;
-    } else if (benchmarkEnv != nullptr && std::string(benchmarkEnv) == "true") {
-        additionalOptions.push_back("-Dscenery.LiV-Test-Benchmark=true");
-        num_additional_options += 1;
-    }
-
-    int num_options = 9 + num_additional_options;
+    JavaVMInitArgs vm_args;
+    const int num_options = static_cast<int>(optionStrings.size());
     auto *options = new JavaVMOption[num_options];   // JVM invocation options
-    options[0].optionString = (char *)classPath.c_str();
-
-    options[1].optionString = (char *)
-            "-Dscenery.VulkanRenderer.EnableValidations=false";
-
-    options[2].optionString = (char *)
-            "-Dorg.lwjgl.system.stackSize=1000";
-
-    //doing headless rendering by default
-    auto headless = (getEnvVar("SCENERY_HEADLESS", false) == nullptr) ? "true" : getEnvVar("SCENERY_HEADLESS");
-
-    std::string headlessOption = "-Dscenery.Headless=" + std::string(headless);
-
-    options[3].optionString = (char *)
-            headlessOption.c_str();
-
-    options[4].optionString = (char *)
-            "-Dscenery.LogLevel=info";
-
-    //    options[4].optionString = (char *)
-    //                                      "-Dscenery.LogLevel=debug";
-
-    auto lwjgl_shared_path = (getEnvVar("LWJGL_SHARED_PATH", false) == nullptr) ? "/tmp/" : getEnvVar("LWJGL_SHARED_PATH");
-    auto lwjgl_library_path = (getEnvVar("LWJGL_LIBRARY_PATH", false) == nullptr) ? "/tmp/" : getEnvVar("LWJGL_LIBRARY_PATH");
-    const auto rank_str = std::to_string(rank);
-
-    std::string option1 = std::string("-Dorg.lwjgl.system.SharedLibraryExtractPath=") + lwjgl_shared_path + "/rank" + rank_str;
-    std::string option2 = std::string("-Dorg.lwjgl.librarypath=") + lwjgl_library_path + "/rank" + rank_str;
-
-    options[5].optionString = (char *)
-            (option1).c_str();
-    options[6].optionString = (char *)
-            (option2).c_str();
-
-    auto mpi_jni_lib_path = (getEnvVar("MPI_JNI_LIB_PATH", false) == nullptr) ? "/usr/local/lib/" : getEnvVar("MPI_JNI_LIB_PATH");
-
-    std::string icet_option = std::string("-Djava.library.path=") + mpi_jni_lib_path;
-
-    options[7].optionString = (char *)
-            (icet_option).c_str();
-
-    std::string gpu_id_option;
-    if (getEnvVar("SCENERY_GPU_ID", false) != nullptr) {
-        gpu_id_option = std::string("-Dscenery.Renderer.DeviceId=") + std::string(getEnvVar("SCENERY_GPU_ID"));
-    } else {
-        gpu_id_option = std::string("-Dscenery.Renderer.DeviceId=") + rank_str;
-    }
-    options[8].optionString = (char *) (gpu_id_option).c_str();
-
-    // Add options from the file
-    for (size_t i = 0; i < additionalOptions.size(); ++i) {
-        options[9+i].optionString = strdup(additionalOptions[i].c_str());
+    for (int i = 0; i < num_options; ++i) {
+        options[i].optionString = (char *) optionStrings[i].c_str();
     }
 
     vm_args.version = JNI_VERSION_21;
@@ -169,6 +86,8 @@ inline JVMData::JVMData(
 
     std::cout<<"Requesting JNI version 21"<<std::endl;
 
+    auto phaseBegin = std::chrono::steady_clock::now();
+
     if (!createJavaVM(&jvm, &env, options, vm_args.nOptions)) {
         // TODO: error processing...
         std::cerr << "ERROR: JVM load failed" << std::endl;
@@ -177,6 +96,9 @@ inline JVMData::JVMData(
 
     delete[] options;
 
+    timings.vmCreation = secondsSince(phaseBegin);
+    phaseBegin = std::chrono::steady_clock::now();
+
     std::cout << "JVM load succeeded: Version " << std::endl;
     jint ver = env->GetVersion();
     std::cout << ((ver >> 16) & 0x0f) << "." << (ver & 0x0f) << std::endl;
@@ -207,6 +129,9 @@ inline JVMData::JVMData(
 
     std::cout << "Constructor found for " << fullClassName << std::endl;
 
+    timings.classLookup = secondsSince(phaseBegin);
+    phaseBegin = std::chrono::steady_clock::now();
+
     //if constructor found, continue
     jobject localObj;
     localObj = env->NewObject(localClass, constructor, windowWidth, windowHeight, rank, commSize, nodeRank);
@@ -223,6 +148,8 @@ inline JVMData::JVMData(
         }
     }
 
+    timings.rendererConstruction = secondsSince(phaseBegin);
+
     std::cout << "Object of class has been constructed" << std::endl;
 
     if (env->ExceptionOccurred()) {
@@ -12,5 +12,7 @@
 
 void registerNativeFunctions(const JVMData& jvmData, const MPIBuffers& mpiBuffers, MPI_Comm& comm);
 void setMPIParams(JVMData jvmData , int rank, int node_rank, int commSize);
+// the communicator of the ranks that composite their images, MPI_COMM_WORLD by default
+void setVisualizationCommunicator(MPI_Comm comm);
 
 #endif //MPINATIVES_H
@@ -6,11 +6,14 @@
 #define MANAGERENDERING_H
 
 #include "JVMData.h"
+#include <atomic>
+#include <string>
 #include <vector>
 namespace liv {
 
     class RenderingManager {
-        bool rendererConfigured = false;
+        // set by the thread that waited for the renderer, read by the receivers of forwarded volumes
+        std::atomic<bool> rendererConfigured{false};
         JVMData* jvmData;
 
     public:
@@ -26,10 +29,74 @@ namespace liv {
 
         void addProcessorData(int processorID, const std::vector<float>& origin, const std::vector<float>& dimensions);
 
+        /**
+         * Batched variant of addProcessorData, with 3 origin and 3 dimension values per processor.
+         */
+        void addProcessorDataBatch(const std::vector<int>& processorIDs, const std::vector<float>& origins,
+                                   const std::vector<float>& dimensions);
+
         void addVolume(int volumeID, const std::vector<int>& dimensions, const std::vector<float>& position, bool is16BitData);
 
+        /**
+         * Batched variant of addVolume, with 3 dimension and 3 position values per volume.
+         */
+        void addVolumes(const std::vector<int>& volumeIDs, const std::vector<int>& dimensions,
+                        const std::vector<float>& positions, bool is16BitData);
+
         void updateVolume(int volumeID, char *volumeBuffer, long bufferSize);
 
+        /**
+         * Batched variant of updateVolume, with one buffer per volume.
+         */
+        void updateVolumes(const std::vector<int>& volumeIDs, const std::vector<char *>& volumeBuffers,
+                           const std::vector<long>& bufferSizes);
+
+        /**
+         * Add a volume with several named fields on the same grid. Only one field is rendered at a time, see
+         * setActiveVolumeField.
+         */
+        void addVolumeFields(int volumeID, const std::vector<int>& dimensions, const std::vector<float>& position,
+                             bool is16BitData, const std::vector<std::string>& fieldNames);
+
+        /**
+         * Replace the data of all fields of a volume in a single call to the renderer, one buffer per field.
+         */
+        void updateVolumeFields(int volumeID, const std::vector<char *>& fieldBuffers, const std::vector<long>& bufferSizes);
+
+        void setActiveVolumeField(int volumeID, int field);
+
+        /**
+         * Replace several bricks of a volume in a single call to the renderer. The bricks are given as 3 offsets and
+         * 3 extents (in voxels) per brick, and their data is packed back to back in brickBuffer in the same order.
+         */
+        void updateVolumeBricks(int volumeID, const std::vector<int>& offsets, const std::vector<int>& extents,
+                                char *brickBuffer, long bufferSize);
+
+        /**
+         * Pass the value range of every brick of a volume and the histogram of its values to the renderer, which
+         * uses them to skip bricks that are empty under the current transfer function.
+         */
+        void updateBrickStatistics(int volumeID, const std::vector<int>& brickSize, const std::vector<int>& minMax,
+                                   const std::vector<int>& histogram);
+
+        /**
+         * Pass the coarse levels of a volume's multiresolution pyramid to the renderer. The dimensions contain 3
+         * values per level, and the level buffers stay owned by the caller and must remain valid until replaced.
+         */
+        void updateVolumeLevels(int volumeID, const std::vector<int>& dimensions, const std::vector<char *>& levelBuffers,
+                                const std::vector<long>& bufferSizes);
+
+        /**
+         * Remove a volume from the scene.
+         */
+        void removeVolume(int volumeID);
+
+        /**
+         * Get the time in seconds the renderer spent on each of the given volumes in the last frame. Returns an empty
+         * vector if the renderer does not measure per-volume times.
+         */
+        std::vector<float> getVolumeRenderTimes(const std::vector<int>& volumeIDs);
+
         void setSceneConfigured();
 
         void waitRendererConfigured();
@@ -0,0 +1,434 @@
+//
+// Forwarding of volume data from ranks without a renderer to the rank that renders it.
+//
+
+#ifndef VOLUMEFORWARDING_H
+#define VOLUMEFORWARDING_H
+
+#include <mpi.h>
+#include <condition_variable>
+#include <cstdint>
+#include <deque>
+#include <functional>
+#include <limits>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <utility>
+#include <vector>
+
+namespace liv {
+
+    class RenderingManager;
+
+    /**
+     * Which ranks run a JVM and renderer, selected with the LIV_RENDERING_MODE environment variable.
+     */
+    enum class RenderingMode {
+        // every rank renders its own volumes ("rank", the default)
+        PerRank,
+        // the first rank on each node renders the volumes of all ranks on the node ("node")
+        PerNode,
+        // dedicated visualization ranks render the volumes of the simulation ranks assigned to them ("transit")
+        InTransit
+    };
+
+    RenderingMode renderingModeFromEnvironment();
+
+    /**
+     * Get the number of visualization ranks in in-transit mode from the LIV_VISUALIZATION_RANKS environment variable.
+     * Defaults to one, and leaves at least one simulation rank.
+     */
+    int numVisualizationRanksFromEnvironment(int numRanks);
+
+    /**
+     * Get the visualization rank that renders the volumes of the given rank in in-transit mode. Visualization ranks are
+     * spread evenly over the ranks, each serving the simulation ranks that follow it. A visualization rank is assigned
+     * to itself.
+     */
+    int visualizationRankOf(int rank, int numRanks, int numVisualizationRanks);
+
+    /**
+     * How simulation ranks hand their volumes to visualization ranks in in-transit mode, selected with the
+     * LIV_TRANSIT_TRANSPORT environment variable.
+     */
+    enum class TransitTransport {
+        // non-blocking sends ("messages", the default)
+        MessagePassing,
+        // puts into a staging ring exposed by the visualization rank ("onesided")
+        OneSided
+    };
+
+    TransitTransport transitTransportFromEnvironment();
+
+    /**
+     * Get the minimum number of slots of each staging ring from the LIV_STAGING_SLOTS environment variable, 4 by
+     * default. Rings grow to one slot more than their sender has volumes.
+     */
+    int numStagingSlotsFromEnvironment();
+
+    /**
+     * Assigns the IDs under which forwarded volumes are registered with the renderer. IDs are handed out downwards from
+     * the largest int, so that they never collide with each other or with the volumes of the rendering rank itself,
+     * which are numbered upwards from 0, whatever the ranks and IDs of the forwarding ranks.
+     */
+    class ForwardedVolumeIDs {
+        std::map<std::pair<int, int>, int> ids;
+        int next = std::numeric_limits<int>::max();
+
+    public:
+        // returns the ID of the volume of the given rank, assigning one on first use
+        int get(int sourceRank, int volumeID);
+
+        void erase(int sourceRank, int volumeID);
+    };
+
+    enum class ForwardedOperation : int {
+        AddVolume,
+        UpdateVolume,
+        UpdateVolumeBricks,
+        UpdateBrickStatistics,
+        SetVolumeDimensions,
+        GetVolumeScaling,
+        RemoveVolume,
+        ResizeBuffer,
+        Finish
+    };
+
+    /**
+     * Fixed-size header of every forwarded operation, followed by numInts ints if numInts > 0. Where the volume data
+     * is found depends on the transport.
+     */
+    struct ForwardedMessage {
+        int operation;
+        int sourceRank;
+        int volumeID;
+        int dimensions[3];
+        float position[3];
+        int is16BitData;
+        int numInts;
+        int replyRequested;
+        // staging slot holding the volume data, if the transport uses slots
+        int slot;
+        long long dataSize;
+    };
+
+    /**
+     * Sending side of volume forwarding, used on ranks without a renderer in place of the RenderingManager.
+     */
+    class VolumeSender {
+    protected:
+        MPI_Comm comm;
+        int destination;
+        int sourceRank;
+
+        // sends the message and its int payload, and waits for the reply if one is requested
+        virtual float send(ForwardedMessage& message, const std::vector<int>& ints = {});
+
+    public:
+        VolumeSender(MPI_Comm comm, int destination, int sourceRank)
+            : comm(comm), destination(destination), sourceRank(sourceRank) {}
+
+        virtual ~VolumeSender() = default;
+
+        void addVolume(int volumeID, const int *dimensions, const float *position, bool is16BitData);
+
+        virtual void removeVolume(int volumeID);
+
+        virtual void updateVolume(int volumeID, const char *data, long size) = 0;
+
+        virtual void updateVolumeBricks(int volumeID, const std::vector<int>& offsets, const std::vector<int>& extents,
+                                        const char *data, long size) = 0;
+
+        void updateBrickStatistics(int volumeID, const std::vector<int>& brickSize, const std::vector<int>& minMax,
+                                   const std::vector<int>& histogram);
+
+        void setVolumeDimensions(const std::vector<int>& dimensions);
+
+        float getVolumeScaling();
+
+        /**
+         * Get a buffer from which the next update of the volume is forwarded without a copy, or nullptr if the
+         * transport has none. The buffer is invalidated by the next update of the volume.
+         */
+        virtual char *getSharedBuffer(int /*volumeID*/, size_t /*size*/) { return nullptr; }
+
+        /**
+         * Tell the rendering rank that no more operations follow. Must be the last call.
+         */
+        virtual void finish();
+    };
+
+    /**
+     * Receiving side of volume forwarding, run on a separate thread of a rendering rank.
+     */
+    class VolumeReceiver {
+    protected:
+        MPI_Comm comm;
+        int numSenders;
+        std::function<RenderingManager *()> renderer;
+        std::thread thread;
+        ForwardedVolumeIDs volumeIDs;
+
+        // returns the volume data of the message, which remains valid until reply is called
+        virtual const char *receiveData(const ForwardedMessage& message, int source) = 0;
+
+        // handles transport-specific operations
+        virtual void handleTransportMessage(const ForwardedMessage& /*message*/, int /*source*/) {}
+
+        // called once the renderer has been given the data returned by receiveData
+        virtual void release(const ForwardedMessage& /*message*/, int /*source*/) {}
+
+        void reply(int source, float value);
+
+        void run();
+
+    public:
+        /**
+         * @param renderer Returns the rendering manager once the renderer is ready, blocking until then.
+         */
+        VolumeReceiver(MPI_Comm comm, int numSenders, std::function<RenderingManager *()> renderer)
+            : comm(comm), numSenders(numSenders), renderer(std::move(renderer)) {}
+
+        virtual ~VolumeReceiver();
+
+        void start();
+
+        /**
+         * Wait until all senders have finished.
+         */
+        void join();
+
+        /**
+         * Free the buffers whose data was handed to the renderer. Must only be called once rendering has stopped.
+         */
+        virtual void releaseBuffers() {}
+    };
+
+    /**
+     * A segment of an MPI shared-memory window, allocated by the sender and mapped by the rendering rank.
+     */
+    struct SharedSegment {
+        MPI_Win window = MPI_WIN_NULL;
+        char *base = nullptr;
+        size_t capacity = 0;
+    };
+
+    /**
+     * Forwards volumes to the first rank of a node through MPI shared-memory windows shared only by the sender and
+     * the rendering rank, which hands pointers into them to the renderer. Each volume has two segments for full
+     * updates, which alternate so that the renderer keeps the last one until the next update of the volume, and one
+     * for brick updates, which the renderer consumes before replying. Segments are only freed once rendering has
+     * stopped, so finish blocks until the rendering rank shuts down.
+     */
+    class SharedMemoryVolumeSender : public VolumeSender {
+        MPI_Comm pairComm = MPI_COMM_NULL;
+        // keyed by volume ID and slot, freed in this order on both sides
+        std::map<std::pair<int, int>, SharedSegment> segments;
+        // the slot of the full update the renderer was last given, per volume
+        std::map<int, int> currentSlots;
+
+        int nextSlot(int volumeID);
+
+        SharedSegment& ensureCapacity(int volumeID, int slot, size_t size);
+
+        void stage(int volumeID, int slot, const char *data, size_t size);
+
+    public:
+        // collective over nodeComm together with the SharedMemoryVolumeReceiver on its first rank
+        SharedMemoryVolumeSender(MPI_Comm nodeComm, int sourceRank);
+
+        ~SharedMemoryVolumeSender() override;
+
+        void updateVolume(int volumeID, const char *data, long size) override;
+
+        void updateVolumeBricks(int volumeID, const std::vector<int>& offsets, const std::vector<int>& extents,
+                                const char *data, long size) override;
+
+        char *getSharedBuffer(int volumeID, size_t size) override;
+
+        void finish() override;
+    };
+
+    class SharedMemoryVolumeReceiver : public VolumeReceiver {
+        struct SenderSegments {
+            MPI_Comm pairComm = MPI_COMM_NULL;
+            std::map<std::pair<int, int>, SharedSegment> segments;
+        };
+
+        std::map<int, SenderSegments> senders;
+
+    protected:
+        const char *receiveData(const ForwardedMessage& message, int source) override;
+
+        void handleTransportMessage(const ForwardedMessage& message, int source) override;
+
+    public:
+        SharedMemoryVolumeReceiver(MPI_Comm nodeComm, std::function<RenderingManager *()> renderer);
+
+        ~SharedMemoryVolumeReceiver() override;
+
+        void releaseBuffers() override;
+    };
+
+    /**
+     * Forwards volumes to a visualization rank with non-blocking point-to-point messages. Updates are copied into a
+     * buffer per volume and sent from there, so the caller may reuse its buffer right away. The next update of the
+     * volume waits for the previous sends to complete before reusing the buffer.
+     */
+    class MessagePassingVolumeSender : public VolumeSender {
+        // outstanding sends per volume
+        std::map<int, std::vector<MPI_Request>> pending;
+        std::map<int, std::vector<char>> sendBuffers;
+
+        void waitPending(int volumeID);
+
+        void sendData(int volumeID, const char *data, long size);
+
+    public:
+        MessagePassingVolumeSender(MPI_Comm comm, int destination, int sourceRank)
+            : VolumeSender(comm, destination, sourceRank) {}
+
+        ~MessagePassingVolumeSender() override;
+
+        void updateVolume(int volumeID, const char *data, long size) override;
+
+        void updateVolumeBricks(int volumeID, const std::vector<int>& offsets, const std::vector<int>& extents,
+                                const char *data, long size) override;
+
+        void removeVolume(int volumeID) override;
+
+        void finish() override;
+    };
+
+    class MessagePassingVolumeReceiver : public VolumeReceiver {
+        // two buffers per volume for full updates, so that data is never received into the buffer the renderer was
+        // last given, and one for brick updates, which the renderer consumes right away
+        struct VolumeBuffers {
+            std::vector<char> buffers[2];
+            int current = 0;
+            std::vector<char> bricks;
+        };
+
+        std::map<int, VolumeBuffers> volumes;
+
+    protected:
+        const char *receiveData(const ForwardedMessage& message, int source) override;
+
+        void handleTransportMessage(const ForwardedMessage& message, int source) override;
+
+    public:
+        MessagePassingVolumeReceiver(MPI_Comm comm, int numSenders, std::function<RenderingManager *()> renderer)
+            : VolumeReceiver(comm, numSenders, std::move(renderer)) {}
+
+        ~MessagePassingVolumeReceiver() override;
+    };
+
+    /**
+     * Forwards volumes to a visualization rank by putting them into a ring of staging slots in a window exposed by
+     * the visualization rank. Updates are copied into a staging buffer of the slot and return once the put is issued,
+     * so the caller may reuse its buffer right away. A separate thread completes the puts and announces them.
+     *
+     * The renderer reads a full update straight from its slot, which is only released once the next full update of
+     * the volume has been handed over, while brick updates are released right after the renderer consumed them. The
+     * ring therefore has at least one slot more than the sender has volumes, and the sender only waits when all slots
+     * are still held. Growing the ring moves the slots the renderer holds into the new ring. The ring is only freed
+     * once rendering has stopped, so finish blocks until the visualization rank shuts down.
+     */
+    class OneSidedVolumeSender : public VolumeSender {
+        MPI_Comm pairComm = MPI_COMM_NULL;
+        MPI_Win window = MPI_WIN_NULL;
+        int minSlots;
+        int numSlots = 0;
+        long long slotSize = 0;
+        // per slot, the buffer the data is put from and whether the visualization rank may still read the slot
+        std::vector<std::vector<char>> staging;
+        std::vector<char> slotsInUse;
+        int nextSlot = 0;
+        // the slot of the full update the renderer was last given, per volume
+        std::map<int, int> currentSlots;
+
+        // messages of issued puts, announced in order by the notifier once the puts have completed
+        std::deque<std::pair<ForwardedMessage, std::vector<int>>> announcements;
+        bool announcing = false;
+        bool stopping = false;
+        std::mutex mutex;
+        std::condition_variable changed;
+        std::thread notifier;
+
+        void announce();
+
+        // waits until all issued puts have been announced
+        void drain();
+
+        // marks the slots released by the visualization rank as free, returns whether any were
+        bool refreshSlots();
+
+        // grows the ring to hold size bytes per slot and a free slot besides those of the given volume and all others
+        void ensureRing(long long size, int volumeID);
+
+        int put(const char *data, long size);
+
+        void enqueue(const ForwardedMessage& message, std::vector<int> ints);
+
+    protected:
+        float send(ForwardedMessage& message, const std::vector<int>& ints = {}) override;
+
+    public:
+        // collective over comm together with the OneSidedVolumeReceiver on the destination rank
+        OneSidedVolumeSender(MPI_Comm comm, int destination, int sourceRank, int numSlots);
+
+        ~OneSidedVolumeSender() override;
+
+        void updateVolume(int volumeID, const char *data, long size) override;
+
+        void updateVolumeBricks(int volumeID, const std::vector<int>& offsets, const std::vector<int>& extents,
+                                const char *data, long size) override;
+
+        void removeVolume(int volumeID) override;
+
+        void finish() override;
+    };
+
+    class OneSidedVolumeReceiver : public VolumeReceiver {
+        struct HeldVolume {
+            int slot;
+            long long size;
+        };
+
+        struct StagingRing {
+            MPI_Comm pairComm = MPI_COMM_NULL;
+            MPI_Win window = MPI_WIN_NULL;
+            char *base = nullptr;
+            long long slotSize = 0;
+            int numSlots = 0;
+            // the slot of the full update the renderer was last given, per volume of the sender
+            std::map<int, HeldVolume> held;
+        };
+
+        std::map<int, StagingRing> rings;
+
+        void allocate(StagingRing& ring, long long slotSize, int numSlots);
+
+        void resize(StagingRing& ring, const ForwardedMessage& message);
+
+        void releaseSlot(StagingRing& ring, int slot);
+
+    protected:
+        const char *receiveData(const ForwardedMessage& message, int source) override;
+
+        void handleTransportMessage(const ForwardedMessage& message, int source) override;
+
+        void release(const ForwardedMessage& message, int source) override;
+
+    public:
+        OneSidedVolumeReceiver(MPI_Comm comm, const std::vector<int>& senders, std::function<RenderingManager *()> renderer);
+
+        ~OneSidedVolumeReceiver() override;
+
+        void releaseBuffers() override;
+    };
+}
+
+#endif //VOLUMEFORWARDING_H
@@ -5,12 +5,37 @@
 #include<iostream>
 #include <jni.h>
 #include <dirent.h>
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <filesystem>
+#include <functional>
+#include <future>
+#include <limits>
+#include <map>
+#include <memory>
+#include <optional>
+#include <string>
+#include <thread>
+#include <type_traits>
+#include <vector>
 
 #include "JVMData.h"
 #include "MPIBuffers.h"
 #include "MPINatives.h"
 #include "ManageRendering.h"
+#include "VolumeForwarding.h"
+#include "utils/JVMConfiguration.h"
 #include "utils/JVMUtils.h"
+#include "utils/NativeLibraryCache.h"
+#include "utils/Quantization.h"
+#include "utils/Bricking.h"
+#include "utils/BrickStatistics.h"
+#include "utils/LevelOfDetail.h"
+#include "utils/LoadBalancing.h"
+#include "utils/ParallelUtils.h"
+#include "utils/HaloExchange.h"
+#include "utils/TimestepPrefetcher.h"
 
 #define NUM_SUPERSEGMENTS 20
 #define DEFAULT_WIDTH 1280
@@ -18,67 +43,317 @@
 
 namespace liv {
 
+    template <typename T>
+    class Volume;
+
+    template <typename T>
+    class BalancedBricks;
+
+    struct QuantizationOptions;
+
     class LiVEngine {
     private:
+        struct StartedRenderer {
+            JVMData* jvmData;
+            RenderingManager* renderingManager;
+        };
+
+        struct PendingVolume {
+            int volumeID;
+            std::vector<int> dimensions;
+            std::vector<float> position;
+            bool is16BitData;
+        };
+
+        bool asynchronousStartup = false;
+        RenderingMode renderingMode = RenderingMode::PerRank;
+        // whether this rank runs a JVM and renderer, otherwise its volumes are forwarded to a rank that does
+        bool renderingRank = true;
+        // number of dedicated visualization ranks in in-transit mode
+        int numVisualizationRanks = 0;
+        // rank of MPI_COMM_WORLD that renders the volumes of this rank
+        int rendererRank = 0;
+        MPI_Comm forwardingComm = MPI_COMM_NULL;
+        std::shared_ptr<VolumeSender> volumeSender;
+        std::shared_ptr<VolumeReceiver> volumeReceiver;
+        std::chrono::steady_clock::time_point startupBegin;
+        std::shared_future<StartedRenderer> startup;
+        mutable std::vector<PendingVolume> pendingVolumes;
+        mutable StartupTimings startupTimings;
+        // directory of the native libraries this rank extracts, recorded once the renderer has loaded all of them
+        mutable std::string unrecordedNativeLibraries;
+        // on a node without valid native libraries, the other rendering ranks of the node, which start their JVMs only
+        // once the first has recorded the libraries, see recordNativeLibraries and startDeferredJVM
+        mutable MPI_Comm nativeLibraryComm = MPI_COMM_NULL;
+        mutable MPI_Request nativeLibraryRequest = MPI_REQUEST_NULL;
+        mutable int nativeLibrariesRecorded = 0;
+        mutable std::function<void()> deferredStartup;
+
         MPI_Comm setupCommunicators();
 
-        template <typename T>
-        void createVolume(float * position, int * dimensions, int volumeID) const;
+        [[nodiscard]] bool forwardsVolumes() const {
+            return volumeSender != nullptr;
+        }
+
+        [[nodiscard]] bool startupComplete() const;
+
+        // the rendering manager, waiting for an asynchronous start-up to complete if required
+        RenderingManager* renderer() const;
+
+        void waitRendererReady() const;
+
+        // writes the manifest of the extracted native libraries, if this rank extracted them, and lets the other ranks
+        // of the node start their JVMs
+        void recordNativeLibraries() const;
+
+        // waits for the first rank of the node to record the native libraries, then starts the JVM of this rank
+        void startDeferredJVM() const;
+
+        // registers the volumes queued during an asynchronous start-up with the renderer
+        void registerPendingVolumes() const;
+
+        void createVolume(float * position, int * dimensions, int volumeID, bool is16BitData) const;
 
         template <typename T>
         void updateVolume(T * buffer, long int buffer_size, int volumeID) const;
+
+        void updateVolumeBricks(const std::vector<int>& offsets, const std::vector<int>& extents,
+                                char * brickBuffer, long int buffer_size, int volumeID) const;
+
+        void updateBrickStatistics(const int * brickSize, const BrickStatistics& statistics, int volumeID) const;
+
+        void updateVolumeLevels(std::vector<VolumeLevel>& levels, int volumeID) const;
+
+        void createVolumeFields(float * position, int * dimensions, int volumeID, bool is16BitData,
+                                const std::vector<std::string>& fieldNames) const;
+
+        void updateVolumeFields(std::vector<char *>& fieldBuffers, const std::vector<long>& bufferSizes, int volumeID) const;
+
+        void removeVolume(int volumeID) const;
+
+        // render time of each volume in the last frame, or empty if the renderer does not measure it
+        std::vector<float> getVolumeRenderTimes(const std::vector<int>& volumeIDs) const;
         int wWidth;
         int wHeight;
     public:
         JVMData* jvmData;
         RenderingManager* renderingManager;
         MPIBuffers mpiBuffers{};
+        // the rendering ranks, used for compositing
         MPI_Comm livComm;
+        // the ranks running the application, MPI_COMM_NULL on the visualization ranks of in-transit mode
         MPI_Comm applicationComm;
+        // the ranks sharing this rank's node
+        MPI_Comm nodeComm;
 
         LiVEngine() = delete;
 
-        LiVEngine(int windowWidth, int windowHeight, const std::string& className);
+        /**
+         * With asynchronousStartup, the JVM and the renderer are brought up on a background thread and the
+         * constructor returns immediately. Volumes created before the renderer is ready are queued and registered
+         * with the renderer on their first update. Other calls that need the renderer block until it is started.
+         * jvmData and renderingManager are only set once waitForStartup has returned.
+         */
+        LiVEngine(int windowWidth, int windowHeight, const std::string& className, bool asynchronousStartup = false);
 
         static LiVEngine initialize(
             int windowWidth,
             int windowHeight,
-            const std::string& className
+            const std::string& className,
+            bool asynchronousStartup = false
         );
 
+        /**
+         * Block until the JVM and the renderer object have been created.
+         */
+        void waitForStartup();
+
+        /**
+         * Stop the renderer and unload the JVM. Call after doRender has returned. If this rank records the
+         * class-data-sharing archive (see LIV_CDS_ARCHIVE_DIR), the archive is written here. On ranks that forward
+         * their volumes, this tells the rendering rank that no more volumes follow, and it must be called on all ranks.
+         */
+        void shutdown();
+
+        /**
+         * Whether this rank runs a renderer. Depends on the rendering mode, see LIV_RENDERING_MODE.
+         */
+        [[nodiscard]] bool isRenderingRank() const {
+            return renderingRank;
+        }
+
+        /**
+         * Whether this rank runs the application. Only the visualization ranks of in-transit mode do not: they hold
+         * no volumes of their own and render those of their simulation ranks, so they must skip the simulation and
+         * only call the collectives over MPI_COMM_WORLD, such as addProcessorDataCollective, besides
+         * setSceneConfigured, doRender and shutdown. In the other modes, rendering ranks are also application ranks.
+         */
+        [[nodiscard]] bool isApplicationRank() const {
+            return applicationComm != MPI_COMM_NULL;
+        }
+
+        /**
+         * Run a visualization rank of in-transit mode to completion: render the volumes forwarded by its simulation
+         * ranks until they shut down, then shut down this rank. Pass joinProcessorData if the application ranks call
+         * addProcessorDataCollective, so that this rank takes part with empty data. Call instead of the application
+         * on ranks for which isApplicationRank is false.
+         */
+        void runVisualizationRank(bool joinProcessorData = true);
+
+        /**
+         * Get a buffer of at least size bytes from which the next update of the volume is handed to the rendering rank
+         * without a copy, or nullptr if volumes are not forwarded through shared memory on this rank. Pass the buffer
+         * to Volume::update after writing the volume data into it. Each volume alternates between two buffers, so call
+         * this again before every update.
+         */
+        char* getSharedVolumeBuffer(int volumeID, size_t size) const {
+            return volumeSender ? volumeSender->getSharedBuffer(volumeID, size) : nullptr;
+        }
+
+        /**
+         * Get the durations of the start-up phases measured so far. The JVM phases are only available once start-up
+         * has completed.
+         */
+        [[nodiscard]] StartupTimings getStartupTimings() const;
+
+        void printStartupTimings() const;
+
         void doRender() const;
 
         void setVolumeDimensions(const std::vector<int>& dimensions) const {
-            renderingManager->setVolumeDimensions(dimensions);
+            if(forwardsVolumes()) {
+                volumeSender->setVolumeDimensions(dimensions);
+                return;
+            }
+            renderer()->setVolumeDimensions(dimensions);
         }
 
         [[nodiscard]] float getVolumeScaling() const {
-            return renderingManager->getVolumeScaling();
+            if(forwardsVolumes()) {
+                return volumeSender->getVolumeScaling();
+            }
+            return renderer()->getVolumeScaling();
         }
 
+        /**
+         * Register the box of a processor of livComm with the renderer. Ignored on ranks that do not render.
+         */
         void addProcessorData(int processorID, const std::vector<float>& origin, const std::vector<float>& dimensions) const {
-            renderingManager->addProcessorData(processorID, origin, dimensions);
+            if(!renderingRank) {
+                return;
+            }
+            renderer()->addProcessorData(processorID, origin, dimensions);
         }
 
+        /**
+         * Register the boxes of several processors with the renderer in a single call. origins and dimensions
+         * contain 3 values per processor, in the order of processorIDs.
+         */
+        void addProcessorDataBatch(const std::vector<int>& processorIDs, const std::vector<float>& origins,
+                                   const std::vector<float>& dimensions) const {
+            if(!renderingRank) {
+                return;
+            }
+            renderer()->addProcessorDataBatch(processorIDs, origins, dimensions);
+        }
+
+        /**
+         * Share the box of this rank with all ranks and register the boxes of all processors of livComm in a single
+         * batch, so that no rank needs to read the metadata of other ranks. The box of a rendering rank encloses the
+         * boxes of all ranks whose volumes it renders. Ranks without data pass empty vectors. Collective over
+         * MPI_COMM_WORLD.
+         */
+        void addProcessorDataCollective(const std::vector<float>& origin, const std::vector<float>& dimensions) const;
+
+        /**
+         * Create several volumes and register them with the renderer in a single call. positions and dimensions
+         * contain 3 values per volume.
+         */
+        template <typename T>
+        std::vector<Volume<T>> createVolumes(const std::vector<float>& positions, const std::vector<int>& dimensions,
+                                             const QuantizationOptions& quantizationOptions);
+
+        template <typename T>
+        std::vector<Volume<T>> createVolumes(const std::vector<float>& positions, const std::vector<int>& dimensions);
+
+        /**
+         * Update several volumes, transferring all of them to the renderer in a single call. Volumes with change
+         * detection enabled transfer their changed bricks separately.
+         *
+         * Floating-point volumes without a fixed range are all quantized with one range, reduced over all of their
+         * buffers on all application ranks in a single collective, so that ranks may hold different numbers of volumes.
+         * Every application rank must therefore call this, even with no volumes.
+         */
+        template <typename T>
+        void updateVolumes(std::vector<Volume<T>>& volumes, const std::vector<T *>& buffers, const std::vector<long int>& bufferSizes);
+
         void setSceneConfigured() {
-            renderingManager->setSceneConfigured();
+            if(!renderingRank) {
+                return;
+            }
+            registerPendingVolumes();
+            renderer()->setSceneConfigured();
         }
 
         template <typename T>
         friend class Volume;
+
+        template <typename T>
+        friend class MultiFieldVolume;
+
+        template <typename T>
+        friend class BalancedBricks;
     };
 
     inline MPI_Comm LiVEngine::setupCommunicators() {
-        //TODO: insert logic for splitting the proccesses into different communicators
         applicationComm = MPI_COMM_WORLD;
-        return MPI_COMM_WORLD;
+
+        int rank;
+        MPI_Comm_rank(MPI_COMM_WORLD, &rank);
+        rendererRank = rank;
+
+        if(renderingMode == RenderingMode::PerRank) {
+            renderingRank = true;
+            return MPI_COMM_WORLD;
+        }
+
+        int numRanks;
+        MPI_Comm_size(MPI_COMM_WORLD, &numRanks);
+
+        if(renderingMode == RenderingMode::InTransit) {
+            if(numRanks < 2) {
+                std::cerr << "ERROR: In-transit rendering needs at least two ranks, rendering on every rank" << std::endl;
+                renderingMode = RenderingMode::PerRank;
+                renderingRank = true;
+                return MPI_COMM_WORLD;
+            }
+
+            // visualization ranks do not take part in the simulation, applicationComm is MPI_COMM_NULL on them
+            numVisualizationRanks = numVisualizationRanksFromEnvironment(numRanks);
+            rendererRank = visualizationRankOf(rank, numRanks, numVisualizationRanks);
+            renderingRank = rendererRank == rank;
+            MPI_Comm_split(MPI_COMM_WORLD, renderingRank ? MPI_UNDEFINED : 0, rank, &applicationComm);
+        } else {
+            // only the first rank of each node renders
+            int nodeRank;
+            MPI_Comm_rank(nodeComm, &nodeRank);
+            renderingRank = nodeRank == 0;
+            MPI_Bcast(&rendererRank, 1, MPI_INT, 0, nodeComm);
+        }
+
+        // livComm connects the rendering ranks for compositing
+        MPI_Comm comm;
+        MPI_Comm_split(MPI_COMM_WORLD, renderingRank ? 0 : MPI_UNDEFINED, rank, &comm);
+        return comm;
     }
 
     inline LiVEngine::LiVEngine(
         int windowWidth,
         int windowHeight,
-        const std::string& className
-    ) : wWidth(windowWidth), wHeight(windowHeight) {
+        const std::string& className,
+        bool asynchronousStartup
+    ) : asynchronousStartup(asynchronousStartup), startupBegin(std::chrono::steady_clock::now()),
+        wWidth(windowWidth), wHeight(windowHeight) {
         std::cout << "Entering LiVEngine constructor" << std::endl;
 
         int rank;
@@ -87,52 +362,375 @@ namespace liv {
         int num_processes;
         MPI_Comm_size(MPI_COMM_WORLD, &num_processes);
 
-        MPI_Comm nodeComm;
         MPI_Comm_split_type( MPI_COMM_WORLD, MPI_COMM_TYPE_SHARED, rank,
                              MPI_INFO_NULL, &nodeComm );
 
-        int node_rank;
-        MPI_Comm_rank(nodeComm,&node_rank);
+        renderingMode = renderingModeFromEnvironment();
+        livComm = setupCommunicators();
 
-        jvmData = new JVMData(windowWidth, windowHeight, rank, num_processes, node_rank, className);
-        renderingManager = new RenderingManager(jvmData);
-        std::cout << "Initialized jvmData" << std::endl;
+        // the ranks of this node that run a renderer
+        MPI_Comm rendererNodeComm;
+        MPI_Comm_split(nodeComm, renderingRank ? 0 : MPI_UNDEFINED, rank, &rendererNodeComm);
+
+        if(renderingMode == RenderingMode::PerNode) {
+            MPI_Comm_dup(nodeComm, &forwardingComm);
+        } else if(renderingMode == RenderingMode::InTransit) {
+            MPI_Comm_dup(MPI_COMM_WORLD, &forwardingComm);
+        }
+
+        if(!renderingRank && renderingMode == RenderingMode::PerNode) {
+            jvmData = nullptr;
+            renderingManager = nullptr;
+            volumeSender = std::make_shared<SharedMemoryVolumeSender>(forwardingComm, rank);
+            std::cout << "Rank " << rank << " forwards its volumes to the first rank of its node" << std::endl;
+        } else if(!renderingRank) {
+            jvmData = nullptr;
+            renderingManager = nullptr;
+            const int visualizationRank = visualizationRankOf(rank, num_processes, numVisualizationRanks);
+            if(transitTransportFromEnvironment() == TransitTransport::OneSided) {
+                volumeSender = std::make_shared<OneSidedVolumeSender>(forwardingComm, visualizationRank, rank,
+                                                                      numStagingSlotsFromEnvironment());
+            } else {
+                volumeSender = std::make_shared<MessagePassingVolumeSender>(forwardingComm, visualizationRank, rank);
+            }
+            std::cout << "Rank " << rank << " sends its volumes to visualization rank " << visualizationRank << std::endl;
+        } else {
+            // the ranks that send their volumes to this one in in-transit mode
+            std::vector<int> senders;
+            for(int r = 0; r < num_processes && renderingMode == RenderingMode::InTransit; r++) {
+                if(r != rank && visualizationRankOf(r, num_processes, numVisualizationRanks) == rank) {
+                    senders.push_back(r);
+                }
+            }
+
+            // the renderer sees the ranks of livComm only
+            MPI_Comm_rank(livComm, &rank);
+            MPI_Comm_size(livComm, &num_processes);
+
+            int node_rank;
+            MPI_Comm_rank(rendererNodeComm, &node_rank);
+
+            // one rank scans the class path and reads the options file, all others receive the result
+            const auto configurationBegin = std::chrono::steady_clock::now();
+            JVMConfiguration configuration;
+            if(!broadcastJVMConfiguration(configuration, 0, livComm)) {
+                std::cerr << "ERROR: Could not resolve the JVM configuration" << std::endl;
+                std::exit(EXIT_FAILURE);
+            }
+            startupTimings.configuration = secondsSince(configurationBegin);
+
+            // LWJGL extracts its native libraries into a directory shared by the node. If the node has no valid copy
+            // yet, the first rank on the node starts its JVM first. It records the libraries once the renderer has
+            // loaded all of them, so that later runs on the node reuse them. The other ranks only start their JVMs
+            // after that, when they first need the renderer.
+            JVMNodeOptions nodeOptions;
+            nodeOptions.nativeLibraryDirectory = nativeLibraryDirectory(configuration);
+            const auto& nativeDirectory = nodeOptions.nativeLibraryDirectory;
+
+            // With a class-data-sharing directory configured, all ranks on the node map the same archive. Only the first
+            // rank on the node records it, which the JVM does on exit if the archive is missing or stale.
+            if(!configuration.classDataArchiveDirectory.empty()) {
+                char nodeName[MPI_MAX_PROCESSOR_NAME];
+                int nodeNameLength;
+                MPI_Get_processor_name(nodeName, &nodeNameLength);
+                const auto archive = classDataArchivePath(configuration, std::string(nodeName, nodeNameLength));
+
+                int archiveExists = 0;
+                if(node_rank == 0) {
+                    std::error_code error;
+                    std::filesystem::create_directories(configuration.classDataArchiveDirectory, error);
+                    archiveExists = std::filesystem::exists(archive, error);
+                }
+                MPI_Bcast(&archiveExists, 1, MPI_INT, 0, rendererNodeComm);
+
+                if(node_rank == 0) {
+                    nodeOptions.classDataArchive = archive;
+                    nodeOptions.recordClassDataArchive = true;
+                } else if(archiveExists) {
+                    nodeOptions.classDataArchive = archive;
+                }
+
+                std::cout << (archiveExists ? "Using class-data-sharing archive " : "No class-data-sharing archive yet at ")
+                          << archive << std::endl;
+            }
+
+            bool started = false;
+            bool deferred = false;
+            if(!isNativeLibraryCacheValidOnNode(nativeDirectory, rendererNodeComm)) {
+                MPI_Comm_dup(rendererNodeComm, &nativeLibraryComm);
+                if(node_rank == 0) {
+                    std::cout << "Extracting native libraries to " << nativeDirectory << std::endl;
+                    jvmData = new JVMData(windowWidth, windowHeight, rank, num_processes, node_rank, className, configuration, nodeOptions);
+                    renderingManager = new RenderingManager(jvmData);
+                    // LWJGL extracts the libraries lazily during renderer initialization, see recordNativeLibraries
+                    unrecordedNativeLibraries = nativeDirectory;
+                    started = true;
+                } else {
+                    deferred = true;
+                }
+            } else {
+                std::cout << "Reusing native libraries in " << nativeDirectory << std::endl;
+            }
+
+            if(started) {
+                std::cout << "Initialized jvmData" << std::endl;
+            } else if(deferred) {
+                jvmData = nullptr;
+                renderingManager = nullptr;
+
+                // created on the application thread, which waits for the first rank on the node with MPI
+                auto promise = std::make_shared<std::promise<StartedRenderer>>();
+                startup = promise->get_future().share();
+                deferredStartup = [=]() {
+                    auto data = new JVMData(windowWidth, windowHeight, rank, num_processes, node_rank, className, configuration, nodeOptions);
+                    promise->set_value(StartedRenderer{data, new RenderingManager(data)});
+                };
+                std::cout << "Deferring JVM initialization until the native libraries in " << nativeDirectory
+                          << " are recorded" << std::endl;
+            } else if(asynchronousStartup) {
+                jvmData = nullptr;
+                renderingManager = nullptr;
+
+                // all MPI calls stay on the application thread, the background thread only talks to the JVM
+                startup = std::async(std::launch::async, [=]() {
+                    auto data = new JVMData(windowWidth, windowHeight, rank, num_processes, node_rank, className, configuration, nodeOptions);
+                    // the JVM was created on this thread, which is about to exit
+                    data->jvm->DetachCurrentThread();
+                    return StartedRenderer{data, new RenderingManager(data)};
+                }).share();
+                std::cout << "Started JVM initialization in the background" << std::endl;
+            } else {
+                jvmData = new JVMData(windowWidth, windowHeight, rank, num_processes, node_rank, className, configuration, nodeOptions);
+                renderingManager = new RenderingManager(jvmData);
+                std::cout << "Initialized jvmData" << std::endl;
+            }
+
+            setVisualizationCommunicator(livComm);
+
+            // forwarded volumes are received on a separate thread, which waits for the renderer on its own
+            auto startupFuture = startup;
+            auto manager = renderingManager;
+            auto provider = [startupFuture, manager]() {
+                return startupFuture.valid() ? startupFuture.get().renderingManager : manager;
+            };
+            if(renderingMode == RenderingMode::PerNode) {
+                volumeReceiver = std::make_shared<SharedMemoryVolumeReceiver>(forwardingComm, provider);
+            } else if(renderingMode == RenderingMode::InTransit && transitTransportFromEnvironment() == TransitTransport::OneSided) {
+                volumeReceiver = std::make_shared<OneSidedVolumeReceiver>(forwardingComm, senders, provider);
+            } else if(renderingMode == RenderingMode::InTransit) {
+                volumeReceiver = std::make_shared<MessagePassingVolumeReceiver>(forwardingComm, static_cast<int>(senders.size()), provider);
+            }
+            if(volumeReceiver) {
+                volumeReceiver->start();
+            }
+            MPI_Comm_free(&rendererNodeComm);
+        }
         mpiBuffers = MPIBuffers();
         std::cout << "Initialized mpiBuffers" << std::endl;
-        livComm = nullptr;
-        applicationComm = MPI_COMM_WORLD;
         std::cout << "Exiting LiVEngine constructor" << std::endl;
     }
 
     inline LiVEngine LiVEngine::initialize(
         int windowWidth,
         int windowHeight,
-        const std::string& className
+        const std::string& className,
+        bool asynchronousStartup
     ) {
 
+        // forwarded volumes are received on a separate thread, which needs full thread support
+        const int required = renderingModeFromEnvironment() == RenderingMode::PerRank ? MPI_THREAD_SERIALIZED : MPI_THREAD_MULTIPLE;
+
         int provided;
-        MPI_Init_thread(NULL, NULL, MPI_THREAD_SERIALIZED, &provided);
+        MPI_Init_thread(NULL, NULL, required, &provided);
 
         std::cout << "Got MPI thread level: " << provided << std::endl;
 
-        auto liv = LiVEngine(windowWidth, windowHeight, className);
+        if(required == MPI_THREAD_MULTIPLE && provided < MPI_THREAD_MULTIPLE) {
+            std::cerr << "ERROR: The rendering mode requires MPI_THREAD_MULTIPLE support" << std::endl;
+            MPI_Abort(MPI_COMM_WORLD, EXIT_FAILURE);
+        }
 
-        liv.livComm = liv.setupCommunicators();
+        auto liv = LiVEngine(windowWidth, windowHeight, className, asynchronousStartup);
 
         return liv;
     }
 
 
-    template<typename T>
-    void LiVEngine::createVolume(float *position, int *dimensions, int volumeID) const {
+    inline bool LiVEngine::startupComplete() const {
+        return !startup.valid() || startup.wait_for(std::chrono::seconds(0)) == std::future_status::ready;
+    }
+
+    inline RenderingManager* LiVEngine::renderer() const {
+        if(!startup.valid()) {
+            return renderingManager;
+        }
+
+        startDeferredJVM();
+
+        if(!startupComplete()) {
+            std::cout << "Waiting for JVM initialization to complete" << std::endl;
+            const auto begin = std::chrono::steady_clock::now();
+            startup.wait();
+            startupTimings.blocked += secondsSince(begin);
+        }
+
+        return startup.get().renderingManager;
+    }
+
+    inline void LiVEngine::waitForStartup() {
+        auto manager = renderer();
+        if(startup.valid()) {
+            jvmData = startup.get().jvmData;
+            renderingManager = manager;
+        }
+    }
+
+    inline void LiVEngine::shutdown() {
+        if(forwardsVolumes()) {
+            volumeSender->finish();
+            return;
+        }
+
+        if(volumeReceiver) {
+            volumeReceiver->join();
+        }
+
+        waitForStartup();
+
+        recordNativeLibraries();
+        renderingManager->stopRendering();
+
+        // forwarded volume data may only be freed once the renderer no longer reads it
+        if(volumeReceiver) {
+            volumeReceiver->releaseBuffers();
+        }
+
+        const auto begin = std::chrono::steady_clock::now();
+        jvmData->jvm->DestroyJavaVM();
+        std::cout << "Unloaded JVM in " << secondsSince(begin) << " s" << std::endl;
+
+        // the other ranks of the node have taken part by the time they shut down
+        if(nativeLibraryComm != MPI_COMM_NULL) {
+            MPI_Wait(&nativeLibraryRequest, MPI_STATUS_IGNORE);
+            MPI_Comm_free(&nativeLibraryComm);
+        }
+    }
+
+    inline StartupTimings LiVEngine::getStartupTimings() const {
+        StartupTimings timings = startupTimings;
+        if(renderingRank && startupComplete()) {
+            const StartupTimings& jvmTimings = startup.valid() ? startup.get().jvmData->timings : jvmData->timings;
+            timings.vmCreation = jvmTimings.vmCreation;
+            timings.classLookup = jvmTimings.classLookup;
+            timings.rendererConstruction = jvmTimings.rendererConstruction;
+        }
+        return timings;
+    }
+
+    inline void LiVEngine::printStartupTimings() const {
+        const auto timings = getStartupTimings();
+        std::cout << "Start-up timings (s): configuration " << timings.configuration
+                  << ", JVM creation " << timings.vmCreation
+                  << ", class lookup " << timings.classLookup
+                  << ", renderer construction " << timings.rendererConstruction
+                  << ", renderer ready after " << timings.rendererReady
+                  << ", application blocked " << timings.blocked << std::endl;
+    }
+
+    inline void LiVEngine::waitRendererReady() const {
+        auto manager = renderer();
+        if(manager->isRendererConfigured()) {
+            return;
+        }
+
+        std::cout << "Waiting for renderer to be configured" << std::endl;
+        const auto begin = std::chrono::steady_clock::now();
+        manager->waitRendererConfigured();
+        startupTimings.blocked += secondsSince(begin);
+        startupTimings.rendererReady = secondsSince(startupBegin);
+
+        printStartupTimings();
+        recordNativeLibraries();
+    }
+
+    inline void LiVEngine::recordNativeLibraries() const {
+        if(unrecordedNativeLibraries.empty()) {
+            return;
+        }
+
+        recordNativeLibraryCacheOnNode(unrecordedNativeLibraries, nativeLibraryComm, nativeLibrariesRecorded, nativeLibraryRequest);
+        if(!nativeLibrariesRecorded) {
+            std::cerr << "ERROR: Could not record the extracted native libraries, they will be extracted again" << std::endl;
+        }
+        unrecordedNativeLibraries.clear();
+    }
+
+    inline void LiVEngine::startDeferredJVM() const {
+        if(!deferredStartup) {
+            return;
+        }
+
+        std::cout << "Waiting for the first rank on the node to record the native libraries" << std::endl;
+        const auto begin = std::chrono::steady_clock::now();
+        if(!waitForNativeLibraryCacheOnNode(nativeLibraryComm)) {
+            std::cerr << "ERROR: The first rank on the node could not record the native libraries, extracting them again" << std::endl;
+        }
+        MPI_Comm_free(&nativeLibraryComm);
+        startupTimings.blocked += secondsSince(begin);
+
+        auto start = std::move(deferredStartup);
+        deferredStartup = nullptr;
+        start();
+        std::cout << "Initialized jvmData" << std::endl;
+    }
+
+    inline void LiVEngine::registerPendingVolumes() const {
+        if(pendingVolumes.empty()) {
+            return;
+        }
+
+        waitRendererReady();
+
+        // one registration call per data type
+        for(bool is16BitData : {false, true}) {
+            std::vector<int> volumeIDs;
+            std::vector<int> dimensions;
+            std::vector<float> positions;
+            for(const auto& volume : pendingVolumes) {
+                if(volume.is16BitData == is16BitData) {
+                    volumeIDs.push_back(volume.volumeID);
+                    dimensions.insert(dimensions.end(), volume.dimensions.begin(), volume.dimensions.end());
+                    positions.insert(positions.end(), volume.position.begin(), volume.position.end());
+                }
+            }
+            if(!volumeIDs.empty()) {
+                std::cout << "Registering " << volumeIDs.size() << " queued volumes" << std::endl;
+                renderer()->addVolumes(volumeIDs, dimensions, positions, is16BitData);
+            }
+        }
+
+        pendingVolumes.clear();
+    }
+
+    inline void LiVEngine::createVolume(float *position, int *dimensions, int volumeID, bool is16BitData) const {
+
+        if(forwardsVolumes()) {
+            volumeSender->addVolume(volumeID, dimensions, position, is16BitData);
+            return;
+        }
 
-        if(!renderingManager->isRendererConfigured()) {
-            std::cout << "Waiting for renderer to be configured" << std::endl;
-            renderingManager->waitRendererConfigured();
+        if(asynchronousStartup && !(startupComplete() && renderer()->isRendererConfigured())) {
+            std::cout << "Renderer not ready yet, queueing registration of volume " << volumeID << std::endl;
+            pendingVolumes.push_back({volumeID, {dimensions[0], dimensions[1], dimensions[2]},
+                                      {position[0], position[1], position[2]}, is16BitData});
+            return;
         }
 
-        renderingManager->addVolume(volumeID, {dimensions[0], dimensions[1], dimensions[2]},
-            {position[0], position[1], position[2]}, sizeof(T) == 2);
+        registerPendingVolumes();
+        waitRendererReady();
+
+        renderer()->addVolume(volumeID, {dimensions[0], dimensions[1], dimensions[2]},
+            {position[0], position[1], position[2]}, is16BitData);
     }
 
 
@@ -140,22 +738,234 @@ namespace liv {
     void LiVEngine::updateVolume(T * buffer, long int buffer_size, int volumeID) const {
         std::cout << "volume id is: " << volumeID << std::endl;
 
-        renderingManager->updateVolume(volumeID, reinterpret_cast<char *>(buffer), buffer_size);
+        if(forwardsVolumes()) {
+            volumeSender->updateVolume(volumeID, reinterpret_cast<const char *>(buffer), buffer_size);
+            return;
+        }
+
+        registerPendingVolumes();
+        renderer()->updateVolume(volumeID, reinterpret_cast<char *>(buffer), buffer_size);
+    }
+
+    inline void LiVEngine::updateVolumeBricks(const std::vector<int>& offsets, const std::vector<int>& extents,
+                                              char * brickBuffer, long int buffer_size, int volumeID) const {
+        std::cout << "volume id is: " << volumeID << ", updating " << offsets.size() / 3 << " bricks" << std::endl;
+
+        if(forwardsVolumes()) {
+            volumeSender->updateVolumeBricks(volumeID, offsets, extents, brickBuffer, buffer_size);
+            return;
+        }
+
+        registerPendingVolumes();
+        renderer()->updateVolumeBricks(volumeID, offsets, extents, brickBuffer, buffer_size);
+    }
+
+    inline void LiVEngine::updateBrickStatistics(const int * brickSize, const BrickStatistics& statistics, int volumeID) const {
+        if(forwardsVolumes()) {
+            volumeSender->updateBrickStatistics(volumeID, {brickSize[0], brickSize[1], brickSize[2]},
+                                                statistics.minMax, statistics.histogram);
+            return;
+        }
+
+        registerPendingVolumes();
+        renderer()->updateBrickStatistics(volumeID, {brickSize[0], brickSize[1], brickSize[2]},
+                                                statistics.minMax, statistics.histogram);
+    }
+
+    inline void LiVEngine::updateVolumeLevels(std::vector<VolumeLevel>& levels, int volumeID) const {
+        if(forwardsVolumes()) {
+            std::cerr << "ERROR: Levels of detail are not supported for forwarded volumes" << std::endl;
+            return;
+        }
+
+        std::vector<int> dimensions;
+        std::vector<char *> buffers;
+        std::vector<long> sizes;
+
+        for(auto& level : levels) {
+            dimensions.insert(dimensions.end(), level.dimensions, level.dimensions + 3);
+            buffers.push_back(level.data.data());
+            sizes.push_back(static_cast<long>(level.data.size()));
+        }
+
+        registerPendingVolumes();
+        renderer()->updateVolumeLevels(volumeID, dimensions, buffers, sizes);
+    }
+
+    inline void LiVEngine::createVolumeFields(float *position, int *dimensions, int volumeID, bool is16BitData,
+                                              const std::vector<std::string>& fieldNames) const {
+
+        if(forwardsVolumes()) {
+            std::cerr << "ERROR: Multi-field volumes are not supported for forwarded volumes" << std::endl;
+            return;
+        }
+
+        registerPendingVolumes();
+        waitRendererReady();
+
+        renderer()->addVolumeFields(volumeID, {dimensions[0], dimensions[1], dimensions[2]},
+            {position[0], position[1], position[2]}, is16BitData, fieldNames);
+    }
+
+    inline void LiVEngine::updateVolumeFields(std::vector<char *>& fieldBuffers, const std::vector<long>& bufferSizes, int volumeID) const {
+        std::cout << "volume id is: " << volumeID << ", updating " << fieldBuffers.size() << " fields" << std::endl;
+
+        if(forwardsVolumes()) {
+            std::cerr << "ERROR: Multi-field volumes are not supported for forwarded volumes" << std::endl;
+            return;
+        }
+
+        renderer()->updateVolumeFields(volumeID, fieldBuffers, bufferSizes);
+    }
+
+    inline void LiVEngine::removeVolume(int volumeID) const {
+        if(forwardsVolumes()) {
+            volumeSender->removeVolume(volumeID);
+            return;
+        }
+
+        registerPendingVolumes();
+        renderer()->removeVolume(volumeID);
+    }
+
+    inline std::vector<float> LiVEngine::getVolumeRenderTimes(const std::vector<int>& volumeIDs) const {
+        if(forwardsVolumes() || volumeIDs.empty()) {
+            return {};
+        }
+        return renderer()->getVolumeRenderTimes(volumeIDs);
+    }
+
+    inline void LiVEngine::addProcessorDataCollective(const std::vector<float>& origin,
+                                                      const std::vector<float>& dimensions) const {
+        struct ProcessorBox {
+            float lower[3];
+            float upper[3];
+            int rendererRank;
+            int renderingRank;
+            int hasBox;
+        };
+
+        ProcessorBox local{{}, {}, rendererRank, renderingRank ? 1 : 0, origin.size() == 3 && dimensions.size() == 3};
+        for(int d = 0; local.hasBox && d < 3; d++) {
+            local.lower[d] = origin[d];
+            local.upper[d] = origin[d] + dimensions[d];
+        }
+
+        int numRanks;
+        MPI_Comm_size(MPI_COMM_WORLD, &numRanks);
+        std::vector<ProcessorBox> boxes(numRanks);
+        MPI_Allgather(&local, sizeof(ProcessorBox), MPI_BYTE, boxes.data(), sizeof(ProcessorBox), MPI_BYTE, MPI_COMM_WORLD);
+
+        if(!renderingRank) {
+            return;
+        }
+
+        // livComm orders the rendering ranks as MPI_COMM_WORLD does
+        std::vector<int> livRanks(numRanks, -1);
+        int numRenderingRanks = 0;
+        for(int r = 0; r < numRanks; r++) {
+            if(boxes[r].renderingRank) {
+                livRanks[r] = numRenderingRanks++;
+            }
+        }
+
+        std::vector<float> lower(3 * numRenderingRanks, std::numeric_limits<float>::max());
+        std::vector<float> upper(3 * numRenderingRanks, std::numeric_limits<float>::lowest());
+        for(const auto& box : boxes) {
+            const int processor = livRanks[box.rendererRank];
+            if(!box.hasBox || processor < 0) {
+                continue;
+            }
+            for(int d = 0; d < 3; d++) {
+                lower[3 * processor + d] = std::min(lower[3 * processor + d], box.lower[d]);
+                upper[3 * processor + d] = std::max(upper[3 * processor + d], box.upper[d]);
+            }
+        }
+
+        std::vector<int> processorIDs;
+        std::vector<float> origins;
+        std::vector<float> extents;
+        for(int p = 0; p < numRenderingRanks; p++) {
+            if(lower[3 * p] > upper[3 * p]) {
+                continue;
+            }
+            processorIDs.push_back(p);
+            for(int d = 0; d < 3; d++) {
+                origins.push_back(lower[3 * p + d]);
+                extents.push_back(upper[3 * p + d] - lower[3 * p + d]);
+            }
+        }
+        addProcessorDataBatch(processorIDs, origins, extents);
     }
 
     inline void LiVEngine::doRender() const {
         std::cout << "In doRender function!" << std::endl;
-        renderingManager->doRender();
+        if(!renderingRank) {
+            std::cout << "Volumes of this rank are rendered by another rank" << std::endl;
+            return;
+        }
+        // called from the render thread, so the wait is not counted as blocking the application
+        auto manager = startup.valid() ? startup.get().renderingManager : renderingManager;
+        manager->doRender();
+    }
+
+    inline void LiVEngine::runVisualizationRank(bool joinProcessorData) {
+        std::thread renderThread([this]() { doRender(); });
+        if(joinProcessorData) {
+            addProcessorDataCollective({}, {});
+        }
+        setSceneConfigured();
+        renderThread.join();
+        shutdown();
+    }
+
+
+
+    /**
+     * Get the ID of the next volume passed to the renderer. Volumes of all element types and multi-field volumes
+     * share one sequence, as the renderer identifies volumes by their ID alone.
+     */
+    inline int nextVolumeID() {
+        static std::atomic<int> currentID{0};
+        return currentID++;
     }
 
+    /**
+     * Volume element types that are quantized to 8 or 16 bit on the native side before being passed to the renderer.
+     */
+    template <typename T>
+    struct isQuantizedVolumeType : std::integral_constant<bool,
+        std::is_same<T, float>::value || std::is_same<T, double>::value || std::is_same<T, half>::value> {};
+
+    /**
+     * Options controlling how volumes of floating-point type are converted to the integer formats of the renderer.
+     */
+    struct QuantizationOptions {
+        // number of bits of the quantized data, either 8 or 16
+        int bits = 16;
+
+        // values mapped onto the quantized range. If not set, the range is recomputed on every update by
+        // reducing the minimum and maximum over the application communicator, which makes update collective.
+        std::optional<ValueRange> range;
+    };
 
+    /**
+     * Bricks transferred to the renderer by the last update of a volume with change detection enabled.
+     */
+    struct UpdateStatistics {
+        int bricksTotal = 0;
+        int bricksTransferred = 0;
 
+        [[nodiscard]] double skippedFraction() const {
+            return bricksTotal == 0 ? 0.0 : 1.0 - static_cast<double>(bricksTransferred) / bricksTotal;
+        }
+    };
 
     template <typename T>
     class Volume {
     private:
-        static_assert(std::is_same<T, unsigned short>::value || std::is_same<T, char>::value,
-                      "Volume can only be instantiated with unsigned short or char types");
+        static_assert(std::is_same<T, unsigned short>::value || std::is_same<T, char>::value || isQuantizedVolumeType<T>::value,
+                      "Volume can only be instantiated with unsigned short, char, float, double or half types");
 
         float position[3]{};
         int dimensions[3]{};
@@ -163,68 +973,1371 @@ namespace liv {
         LiVEngine* livEngine;
         int id;
 
-    public:
+        QuantizationOptions quantization;
+        ValueRange lastRange{0.0, 0.0};
 
-        static int currentID;
+        // holds the data in the format passed to the renderer. Volumes that need no quantization pass full updates to
+        // the renderer in place, and only mirror them here once updateRegion has been used, so that region updates
+        // can transfer whole bricks from here.
+        std::vector<char> stagingBuffer;
+        const char * lastFullUpdate = nullptr;
 
-        // we don't want to allow default constructor
-        Volume() = delete;
+        // bricks touched by updateRegion since the last flushDirtyBricks
+        BrickGrid brickGrid;
+        std::vector<unsigned char> dirtyBricks;
+        std::vector<char> brickBuffer;
 
-        Volume(const float *pos, const int *dims, LiVEngine* _livEngine);
-        void update(T * buffer, long int buffer_size) const;
+        // per-brick hashes of the data last passed to the renderer, used for change detection
+        bool changeDetection = false;
+        std::vector<uint64_t> brickHashes;
+        UpdateStatistics lastUpdateStatistics;
 
-        [[nodiscard]] int getId() const {
-            return id;
-        }
-    };
+        // per-brick value ranges and value histogram passed to the renderer for empty-space skipping
+        bool computeStatistics = false;
+        int histogramBins = 256;
+        BrickStatistics brickStatistics;
 
-    template <typename T>
-    int Volume<T>::currentID = 0;
+        // coarse levels of the multiresolution pyramid, kept in native memory and shared with the renderer
+        int numCoarseLevels = 0;
+        DownsamplingFilter downsamplingFilter = DownsamplingFilter::Box;
+        std::vector<VolumeLevel> levels;
 
-    template <typename T>
-    Volume<T>::Volume(const float *pos, const int *dims, LiVEngine* _livEngine): livEngine(_livEngine){
-        position[0] = pos[0];
-        position[1] = pos[1];
-        position[2] = pos[2];
+        static constexpr int defaultBrickSize = 64;
 
-        dimensions[0] = dims[0];
-        dimensions[1] = dims[1];
-        dimensions[2] = dims[2];
+        [[nodiscard]] size_t numVoxels() const {
+            return static_cast<size_t>(dimensions[0]) * dimensions[1] * dimensions[2];
+        }
 
-        id = currentID;
+        [[nodiscard]] size_t stagingElementSize() const {
+            return is16BitData() ? 2 : 1;
+        }
 
-        if(livEngine != nullptr) {
-            livEngine->createVolume<T>(position, dimensions, id);
-        } else {
-            std::cerr << __FILE__ << __LINE__ << "ERROR: LiVEngine is not correctly initialized. The volume will "
-                                                 "not be updated in the rendering scenegraph" << std::endl;
+        // allocates the staging buffer, starting from the last full update if it was passed to the renderer in place
+        void ensureStagingBuffer() {
+            if(stagingBuffer.size() == numVoxels() * stagingElementSize()) {
+                return;
+            }
+            stagingBuffer.assign(numVoxels() * stagingElementSize(), 0);
+            if(lastFullUpdate != nullptr) {
+                std::copy(lastFullUpdate, lastFullUpdate + stagingBuffer.size(), stagingBuffer.begin());
+            }
         }
 
-        currentID++;
-    }
+        [[nodiscard]] bool is16BitData() const {
+            if constexpr (isQuantizedVolumeType<T>::value) {
+                return quantization.bits == 16;
+            } else {
+                return sizeof(T) == 2;
+            }
+        }
 
-    template <typename T>
-    void Volume<T>::update(T * buffer, long int buffer_size) const {
+        ValueRange computeQuantizationRange(const T * buffer) const;
 
-        std::cout << "Buffer size is: " << buffer_size << std::endl;
+        Volume(const float *pos, const int *dims, LiVEngine* _livEngine, const QuantizationOptions& quantizationOptions,
+               bool registerWithRenderer);
 
-        if(buffer_size != dimensions[0] * dimensions[1] * dimensions[2] * sizeof(T)) {
-            std::cerr << __FILE__ << __LINE__
-            << "ERROR: Buffer size does not match volume dimensions!" << std::endl;
-            return;
-        }
+        // quantizes or copies the new data into the staging buffer as needed and computes brick statistics.
+        // data then points to the renderer-format data of the whole volume. A given range replaces the reduction of
+        // the range of floating-point volumes without a fixed range.
+        bool stageUpdate(T * buffer, long int buffer_size, char *& data, long int& dataSize,
+                         const ValueRange * range = nullptr);
 
-        if(livEngine != nullptr) {
-            livEngine->updateVolume(buffer, buffer_size, id);
-        } else {
-            std::cerr << __FILE__ << __LINE__ << "ERROR: LiVEngine is not correctly initialized. Please make sure that"
-                                                 "LiVEngine is correctly passed to the createVolume function" << std::endl;
-        }
-    }
+        void update(T * buffer, long int buffer_size, const ValueRange * range);
 
-    template <typename T>
-    Volume<T> createVolume(const float * position, const int * dimensions, LiVEngine* livEngine) {
-        return Volume<T>(position, dimensions, livEngine);
+        // with change detection enabled, transfers only the bricks that changed since the previous update.
+        // Returns false if the whole volume needs to be transferred instead.
+        bool transferChangedBricks(const char * data);
+
+        int transferDirtyBricks(const char * volumeData);
+
+        void publishBrickStatistics() const;
+
+        // rebuilds the levels depending on the given bricks, or all levels if changedBricks is empty
+        void publishLevels(const char * volumeData, const std::vector<int>& changedBricks);
+
+        friend class LiVEngine;
+
+    public:
+
+        // we don't want to allow default constructor
+        Volume() = delete;
+
+        Volume(const float *pos, const int *dims, LiVEngine* _livEngine, const QuantizationOptions& quantizationOptions = {});
+        void update(T * buffer, long int buffer_size);
+
+        /**
+         * Update a box-shaped region of the volume. The region is copied (and quantized, for floating-point volumes)
+         * into the staging buffer and the bricks it touches are marked dirty. Dirty bricks are transferred to the
+         * renderer by flushDirtyBricks, so several regions can be updated before a single transfer.
+         *
+         * Floating-point volumes are quantized with the fixed range from QuantizationOptions, or otherwise with the
+         * range of the last full update.
+         *
+         * Other volumes only keep a staging buffer once this is first called, which starts from the buffer passed to
+         * the last full update. As the renderer reads that buffer in place, it must still hold the data then.
+         *
+         * @param offset voxel coordinates of the origin of the region within the volume
+         * @param extent size of the region in voxels
+         * @param data pointer to the first element of the region
+         * @param strides element strides of data along x, y and z. If nullptr, data is assumed to be packed.
+         */
+        void updateRegion(const int * offset, const int * extent, const T * data, const long int * strides = nullptr);
+
+        /**
+         * Transfer all bricks that were marked dirty by updateRegion to the renderer in a single call.
+         *
+         * @return the number of bricks that were transferred
+         */
+        int flushDirtyBricks();
+
+        /**
+         * Set the size of the bricks used for tracking updated regions and detecting changes. Must not be called
+         * while bricks are dirty.
+         */
+        void setBrickSize(const int * size);
+
+        /**
+         * Enable or disable change detection. When enabled, update hashes every brick of the new data and only
+         * transfers bricks whose hash differs from the previous update. The first update after enabling transfers
+         * the whole volume.
+         */
+        void setChangeDetection(bool enabled) {
+            changeDetection = enabled;
+            brickHashes.clear();
+        }
+
+        /**
+         * Enable or disable the computation of per-brick value ranges and a value histogram on every update. They are
+         * passed to the renderer after the volume data, so that it can skip bricks that are empty under the current
+         * transfer function. Region updates only refresh the ranges of the bricks they touch, the histogram is only
+         * recomputed by full updates.
+         *
+         * @param enabled Whether to compute the statistics.
+         * @param numBins The number of histogram bins, a power of two no larger than 256.
+         */
+        void setBrickStatistics(bool enabled, int numBins = 256) {
+            computeStatistics = enabled;
+            histogramBins = numBins;
+        }
+
+        /**
+         * Enable a multiresolution pyramid for level-of-detail rendering. On every update, up to numLevels coarser
+         * levels are built natively, each halving the resolution of the previous one, and passed to the renderer.
+         * Updates that only change some bricks only recompute the parts of the levels depending on them.
+         *
+         * @param numLevels The number of coarse levels, 0 to disable.
+         * @param filter The filter combining 2x2x2 voxels into one voxel of the next level.
+         */
+        void setLevelOfDetail(int numLevels, DownsamplingFilter filter = DownsamplingFilter::Box) {
+            numCoarseLevels = numLevels;
+            downsamplingFilter = filter;
+            levels.clear();
+        }
+
+        [[nodiscard]] const BrickStatistics& getBrickStatistics() const {
+            return brickStatistics;
+        }
+
+        /**
+         * Statistics of the last update with change detection enabled.
+         */
+        [[nodiscard]] UpdateStatistics getLastUpdateStatistics() const {
+            return lastUpdateStatistics;
+        }
+
+        [[nodiscard]] int getId() const {
+            return id;
+        }
+
+        /**
+         * The range of values that was mapped onto the quantized range in the last update. Only meaningful for
+         * volumes of floating-point type, e.g. for mapping transfer function positions back to data values.
+         */
+        [[nodiscard]] ValueRange getQuantizationRange() const {
+            return lastRange;
+        }
+    };
+
+    template <typename T>
+    Volume<T>::Volume(const float *pos, const int *dims, LiVEngine* _livEngine, const QuantizationOptions& quantizationOptions)
+        : Volume(pos, dims, _livEngine, quantizationOptions, true) {}
+
+    template <typename T>
+    Volume<T>::Volume(const float *pos, const int *dims, LiVEngine* _livEngine, const QuantizationOptions& quantizationOptions,
+                      bool registerWithRenderer)
+        : livEngine(_livEngine), quantization(quantizationOptions) {
+        position[0] = pos[0];
+        position[1] = pos[1];
+        position[2] = pos[2];
+
+        dimensions[0] = dims[0];
+        dimensions[1] = dims[1];
+        dimensions[2] = dims[2];
+
+        if(quantization.bits != 8 && quantization.bits != 16) {
+            std::cerr << __FILE__ << __LINE__ << "ERROR: Volumes can only be quantized to 8 or 16 bits. "
+                                                 "Using 16 bits." << std::endl;
+            quantization.bits = 16;
+        }
+
+        const int brickSize[3] = {defaultBrickSize, defaultBrickSize, defaultBrickSize};
+        setBrickSize(brickSize);
+
+        id = nextVolumeID();
+
+        if(livEngine != nullptr) {
+            if(registerWithRenderer) {
+                livEngine->createVolume(position, dimensions, id, is16BitData());
+            }
+        } else {
+            std::cerr << __FILE__ << __LINE__ << "ERROR: LiVEngine is not correctly initialized. The volume will "
+                                                 "not be updated in the rendering scenegraph" << std::endl;
+        }
+    }
+
+    template <typename T>
+    ValueRange Volume<T>::computeQuantizationRange(const T * buffer) const {
+        if(quantization.range) {
+            return *quantization.range;
+        }
+
+        ValueRange range = computeValueRange(buffer, numVoxels());
+
+        if(livEngine != nullptr && livEngine->isApplicationRank()) {
+            // reduce the minimum as a negated maximum so that a single reduction suffices
+            double minMax[2] = {-range.min, range.max};
+            MPI_Allreduce(MPI_IN_PLACE, minMax, 2, MPI_DOUBLE, MPI_MAX, livEngine->applicationComm);
+            range = {-minMax[0], minMax[1]};
+        }
+
+        return range;
+    }
+
+    template <typename T>
+    bool Volume<T>::stageUpdate(T * buffer, long int buffer_size, char *& data, long int& dataSize,
+                                const ValueRange * range) {
+
+        std::cout << "Buffer size is: " << buffer_size << std::endl;
+
+        if(static_cast<size_t>(buffer_size) != numVoxels() * sizeof(T)) {
+            std::cerr << __FILE__ << __LINE__
+            << "ERROR: Buffer size does not match volume dimensions!" << std::endl;
+            return false;
+        }
+
+        data = reinterpret_cast<char *>(buffer);
+        dataSize = buffer_size;
+
+        if constexpr (isQuantizedVolumeType<T>::value) {
+            lastRange = range != nullptr && !quantization.range ? *range : computeQuantizationRange(buffer);
+
+            stagingBuffer.resize(numVoxels() * (quantization.bits / 8));
+            if(quantization.bits == 8) {
+                quantize(buffer, numVoxels(), lastRange, stagingBuffer.data());
+            } else {
+                quantize(buffer, numVoxels(), lastRange, reinterpret_cast<unsigned short *>(stagingBuffer.data()));
+            }
+
+            data = stagingBuffer.data();
+            dataSize = static_cast<long int>(stagingBuffer.size());
+        } else {
+            lastFullUpdate = data;
+            // once region updates are used, they transfer the voxels around them from the staging buffer
+            if(!stagingBuffer.empty()) {
+                const size_t strides[3] = {sizeof(T), sizeof(T) * dimensions[0], sizeof(T) * dimensions[0] * dimensions[1]};
+                copyBox(data, strides, stagingBuffer.data(), strides, dimensions, sizeof(T));
+            }
+        }
+
+        // the full update supersedes any pending region updates
+        std::fill(dirtyBricks.begin(), dirtyBricks.end(), 0);
+
+        if(computeStatistics) {
+            computeBrickStatistics(data, brickGrid, dimensions, is16BitData(), histogramBins, brickStatistics);
+        }
+
+        return true;
+    }
+
+    template <typename T>
+    bool Volume<T>::transferChangedBricks(const char * data) {
+        if(!changeDetection) {
+            return false;
+        }
+
+        auto hashes = hashBricks(data, brickGrid, dimensions, stagingElementSize());
+        const bool firstUpdate = brickHashes.size() != hashes.size();
+
+        lastUpdateStatistics.bricksTotal = brickGrid.numBricks();
+
+        if(firstUpdate) {
+            brickHashes = std::move(hashes);
+            lastUpdateStatistics.bricksTransferred = lastUpdateStatistics.bricksTotal;
+            return false;
+        }
+
+        std::vector<int> changedBricks;
+        for(size_t brick = 0; brick < hashes.size(); brick++) {
+            dirtyBricks[brick] = hashes[brick] != brickHashes[brick];
+            if(dirtyBricks[brick]) {
+                changedBricks.push_back(static_cast<int>(brick));
+            }
+        }
+        brickHashes = std::move(hashes);
+
+        lastUpdateStatistics.bricksTransferred = transferDirtyBricks(data);
+
+        std::cout << "Volume " << id << ": skipped " << lastUpdateStatistics.bricksTotal - lastUpdateStatistics.bricksTransferred
+                  << " of " << lastUpdateStatistics.bricksTotal << " unchanged bricks ("
+                  << 100.0 * lastUpdateStatistics.skippedFraction() << "%)" << std::endl;
+
+        publishBrickStatistics();
+        if(!changedBricks.empty()) {
+            publishLevels(data, changedBricks);
+        }
+        return true;
+    }
+
+    template <typename T>
+    void Volume<T>::update(T * buffer, long int buffer_size) {
+        update(buffer, buffer_size, nullptr);
+    }
+
+    template <typename T>
+    void Volume<T>::update(T * buffer, long int buffer_size, const ValueRange * range) {
+        char * data;
+        long int dataSize;
+
+        if(!stageUpdate(buffer, buffer_size, data, dataSize, range)) {
+            return;
+        }
+
+        if(transferChangedBricks(data)) {
+            return;
+        }
+
+        if(livEngine != nullptr) {
+            livEngine->updateVolume(data, dataSize, id);
+        } else {
+            std::cerr << __FILE__ << __LINE__ << "ERROR: LiVEngine is not correctly initialized. Please make sure that"
+                                                 "LiVEngine is correctly passed to the createVolume function" << std::endl;
+        }
+
+        publishBrickStatistics();
+        publishLevels(data, {});
+    }
+
+    template <typename T>
+    void Volume<T>::setBrickSize(const int * size) {
+        brickGrid = BrickGrid(dimensions, size);
+        dirtyBricks.assign(brickGrid.numBricks(), 0);
+        // the hashes of the previous bricks cannot be compared with the new ones
+        brickHashes.clear();
+    }
+
+    template <typename T>
+    void Volume<T>::updateRegion(const int * offset, const int * extent, const T * data, const long int * strides) {
+        for(int d = 0; d < 3; d++) {
+            if(offset[d] < 0 || extent[d] < 0 || offset[d] + extent[d] > dimensions[d]) {
+                std::cerr << __FILE__ << __LINE__ << "ERROR: Region exceeds the volume dimensions!" << std::endl;
+                return;
+            }
+        }
+
+        const long int packedStrides[3] = {1, extent[0], static_cast<long int>(extent[0]) * extent[1]};
+        if(strides == nullptr) {
+            strides = packedStrides;
+        }
+
+        ensureStagingBuffer();
+
+        const size_t elementSize = stagingElementSize();
+        const size_t dstStrides[3] = {elementSize, elementSize * dimensions[0], elementSize * dimensions[0] * dimensions[1]};
+        char * dst = stagingBuffer.data() + offset[0] * dstStrides[0] + offset[1] * dstStrides[1] + offset[2] * dstStrides[2];
+
+        if constexpr (isQuantizedVolumeType<T>::value) {
+            const ValueRange range = quantization.range ? *quantization.range : lastRange;
+            if(!(range.max > range.min)) {
+                std::cerr << __FILE__ << __LINE__ << "ERROR: No quantization range available for the region update. "
+                                                     "Please update the full volume first or set a fixed range." << std::endl;
+                return;
+            }
+
+            const size_t numRows = static_cast<size_t>(extent[1]) * extent[2];
+            parallelFor(0, numRows, [&](size_t begin, size_t end, size_t) {
+                for(size_t r = begin; r < end; r++) {
+                    const size_t y = r % extent[1];
+                    const size_t z = r / extent[1];
+                    const T * srcRow = data + y * strides[1] + z * strides[2];
+                    char * dstRow = dst + y * dstStrides[1] + z * dstStrides[2];
+
+                    if(quantization.bits == 8) {
+                        quantize(srcRow, extent[0], range, dstRow, strides[0]);
+                    } else {
+                        quantize(srcRow, extent[0], range, reinterpret_cast<unsigned short *>(dstRow), strides[0]);
+                    }
+                }
+            }, 64);
+        } else {
+            const size_t srcStrides[3] = {strides[0] * sizeof(T), strides[1] * sizeof(T), strides[2] * sizeof(T)};
+            copyBox(reinterpret_cast<const char *>(data), srcStrides, dst, dstStrides, extent, sizeof(T));
+        }
+
+        for(int brick : brickGrid.bricksIntersecting(offset, extent)) {
+            dirtyBricks[brick] = 1;
+        }
+    }
+
+    template <typename T>
+    int Volume<T>::flushDirtyBricks() {
+        if(stagingBuffer.empty()) {
+            return 0;
+        }
+
+        std::vector<int> bricks;
+        for(int brick = 0; brick < brickGrid.numBricks(); brick++) {
+            if(dirtyBricks[brick]) {
+                bricks.push_back(brick);
+            }
+        }
+
+        const int numTransferred = transferDirtyBricks(stagingBuffer.data());
+
+        if(!bricks.empty() && computeStatistics && !brickStatistics.minMax.empty()) {
+            updateBrickRanges(stagingBuffer.data(), brickGrid, dimensions, is16BitData(), bricks, brickStatistics);
+            publishBrickStatistics();
+        }
+
+        if(!bricks.empty()) {
+            publishLevels(stagingBuffer.data(), bricks);
+        }
+
+        if(!brickHashes.empty()) {
+            // the renderer now holds data that the hashes of the last full update do not describe
+            brickHashes.clear();
+        }
+
+        return numTransferred;
+    }
+
+    template <typename T>
+    int Volume<T>::transferDirtyBricks(const char * volumeData) {
+        std::vector<int> offsets;
+        std::vector<int> extents;
+        size_t totalSize = 0;
+
+        for(int brick = 0; brick < brickGrid.numBricks(); brick++) {
+            if(dirtyBricks[brick]) {
+                const Box box = brickGrid.brickBox(brick);
+                offsets.insert(offsets.end(), box.offset, box.offset + 3);
+                extents.insert(extents.end(), box.extent, box.extent + 3);
+                totalSize += box.numVoxels() * stagingElementSize();
+            }
+        }
+
+        const int numDirty = static_cast<int>(offsets.size() / 3);
+        if(numDirty == 0) {
+            return 0;
+        }
+
+        brickBuffer.resize(totalSize);
+
+        const size_t elementSize = stagingElementSize();
+        const size_t srcStrides[3] = {elementSize, elementSize * dimensions[0], elementSize * dimensions[0] * dimensions[1]};
+        size_t packedOffset = 0;
+
+        for(int i = 0; i < numDirty; i++) {
+            const int * brickOffset = &offsets[3 * i];
+            const int * brickExtent = &extents[3 * i];
+            const size_t dstStrides[3] = {elementSize, elementSize * brickExtent[0], elementSize * brickExtent[0] * brickExtent[1]};
+
+            const char * src = volumeData + brickOffset[0] * srcStrides[0] + brickOffset[1] * srcStrides[1]
+                               + brickOffset[2] * srcStrides[2];
+            copyBox(src, srcStrides, brickBuffer.data() + packedOffset, dstStrides, brickExtent, elementSize);
+
+            packedOffset += static_cast<size_t>(brickExtent[0]) * brickExtent[1] * brickExtent[2] * elementSize;
+        }
+
+        std::fill(dirtyBricks.begin(), dirtyBricks.end(), 0);
+
+        if(livEngine != nullptr) {
+            livEngine->updateVolumeBricks(offsets, extents, brickBuffer.data(), static_cast<long int>(brickBuffer.size()), id);
+        } else {
+            std::cerr << __FILE__ << __LINE__ << "ERROR: LiVEngine is not correctly initialized. Please make sure that"
+                                                 "LiVEngine is correctly passed to the createVolume function" << std::endl;
+        }
+
+        return numDirty;
+    }
+
+    template <typename T>
+    void Volume<T>::publishBrickStatistics() const {
+        if(!computeStatistics || livEngine == nullptr) {
+            return;
+        }
+
+        livEngine->updateBrickStatistics(brickGrid.getBrickSize(), brickStatistics, id);
+    }
+
+    template <typename T>
+    void Volume<T>::publishLevels(const char * volumeData, const std::vector<int>& changedBricks) {
+        if(numCoarseLevels <= 0) {
+            return;
+        }
+
+        if(levels.empty() || changedBricks.empty()) {
+            buildLevels(volumeData, dimensions, is16BitData(), numCoarseLevels, downsamplingFilter, levels);
+        } else {
+            for(int brick : changedBricks) {
+                updateLevels(volumeData, dimensions, is16BitData(), brickGrid.brickBox(brick), downsamplingFilter, levels);
+            }
+        }
+
+        if(livEngine != nullptr) {
+            livEngine->updateVolumeLevels(levels, id);
+        }
+    }
+
+    template <typename T>
+    Volume<T> createVolume(const float * position, const int * dimensions, LiVEngine* livEngine,
+                           const QuantizationOptions& quantizationOptions = {}) {
+        return Volume<T>(position, dimensions, livEngine, quantizationOptions);
+    }
+
+    /**
+     * A field of an interleaved (array-of-structures) volume, given by its name and byte offset within a cell.
+     */
+    struct VolumeField {
+        std::string name;
+        size_t offset;
+    };
+
+    /**
+     * A volume holding several fields on the same grid, e.g. density, pressure and temperature of a simulation.
+     *
+     * The input is a single interleaved array of cells, each containing all fields as values of type T. On update,
+     * the fields are deinterleaved into one contiguous array per field (and quantized, for floating-point T), and
+     * all of them are passed to the renderer in one call. Switching the rendered field therefore does not require
+     * another transfer.
+     */
+    template <typename T>
+    class MultiFieldVolume {
+    private:
+        static_assert(std::is_same<T, unsigned short>::value || std::is_same<T, char>::value || isQuantizedVolumeType<T>::value,
+                      "MultiFieldVolume can only be instantiated with unsigned short, char, float, double or half types");
+
+        float position[3]{};
+        int dimensions[3]{};
+
+        LiVEngine* livEngine;
+        int id;
+
+        std::vector<VolumeField> fields;
+        size_t cellSize;
+
+        QuantizationOptions quantization;
+        std::vector<ValueRange> lastRanges;
+
+        // deinterleaved data in the renderer format, one contiguous block per field
+        std::vector<char> stagingBuffer;
+
+        [[nodiscard]] size_t numVoxels() const {
+            return static_cast<size_t>(dimensions[0]) * dimensions[1] * dimensions[2];
+        }
+
+        [[nodiscard]] bool is16BitData() const {
+            if constexpr (isQuantizedVolumeType<T>::value) {
+                return quantization.bits == 16;
+            } else {
+                return sizeof(T) == 2;
+            }
+        }
+
+        [[nodiscard]] size_t fieldSize() const {
+            return numVoxels() * (is16BitData() ? 2 : 1);
+        }
+
+    public:
+        MultiFieldVolume() = delete;
+
+        /**
+         * @param pos position of the volume
+         * @param dims dimensions of the volume in cells
+         * @param volumeFields name and byte offset within a cell of every field
+         * @param cellBytes size of a cell in bytes, i.e. the distance between consecutive cells in the input
+         * @param _livEngine the engine the volume is rendered by
+         * @param quantizationOptions quantization of floating-point fields, the range applies to every field
+         */
+        MultiFieldVolume(const float *pos, const int *dims, const std::vector<VolumeField>& volumeFields, size_t cellBytes,
+                         LiVEngine* _livEngine, const QuantizationOptions& quantizationOptions = {});
+
+        /**
+         * Deinterleave and transfer all fields. If no fixed quantization range is given, the global range of every
+         * field is reduced over the application communicator in a single collective call.
+         *
+         * @param cells pointer to the first cell of the interleaved input
+         */
+        void update(const void * cells);
+
+        /**
+         * Select the field shown by the renderer. Does not transfer any data.
+         */
+        void setActiveField(int field) const;
+
+        [[nodiscard]] int getId() const {
+            return id;
+        }
+
+        [[nodiscard]] int getNumFields() const {
+            return static_cast<int>(fields.size());
+        }
+
+        /**
+         * The range of values of the given field that was mapped onto the quantized range in the last update.
+         */
+        [[nodiscard]] ValueRange getQuantizationRange(int field) const {
+            return lastRanges[field];
+        }
+    };
+
+    template <typename T>
+    MultiFieldVolume<T>::MultiFieldVolume(const float *pos, const int *dims, const std::vector<VolumeField>& volumeFields,
+                                          size_t cellBytes, LiVEngine* _livEngine, const QuantizationOptions& quantizationOptions)
+        : livEngine(_livEngine), fields(volumeFields), cellSize(cellBytes), quantization(quantizationOptions) {
+        for(int d = 0; d < 3; d++) {
+            position[d] = pos[d];
+            dimensions[d] = dims[d];
+        }
+
+        if(quantization.bits != 8 && quantization.bits != 16) {
+            std::cerr << __FILE__ << __LINE__ << "ERROR: Volumes can only be quantized to 8 or 16 bits. "
+                                                 "Using 16 bits." << std::endl;
+            quantization.bits = 16;
+        }
+
+        for(const auto& field : fields) {
+            if(cellSize % sizeof(T) != 0 || field.offset % sizeof(T) != 0 || field.offset + sizeof(T) > cellSize) {
+                std::cerr << __FILE__ << __LINE__ << "ERROR: Field " << field.name << " is not aligned to the field "
+                                                     "type within the cell. The volume will not be rendered." << std::endl;
+                fields.clear();
+                break;
+            }
+        }
+
+        lastRanges.assign(fields.size(), {0.0, 0.0});
+
+        id = nextVolumeID();
+
+        std::vector<std::string> fieldNames;
+        for(const auto& field : fields) {
+            fieldNames.push_back(field.name);
+        }
+
+        if(livEngine != nullptr) {
+            livEngine->createVolumeFields(position, dimensions, id, is16BitData(), fieldNames);
+        } else {
+            std::cerr << __FILE__ << __LINE__ << "ERROR: LiVEngine is not correctly initialized. The volume will "
+                                                 "not be updated in the rendering scenegraph" << std::endl;
+        }
+    }
+
+    template <typename T>
+    void MultiFieldVolume<T>::update(const void * cells) {
+        const auto * base = static_cast<const char *>(cells);
+        const size_t numFields = fields.size();
+        const size_t cellStride = cellSize / sizeof(T);
+
+        stagingBuffer.resize(numFields * fieldSize());
+
+        if constexpr (isQuantizedVolumeType<T>::value) {
+            if(quantization.range) {
+                lastRanges.assign(numFields, *quantization.range);
+            } else {
+                // reduce the minima as negated maxima so that a single reduction covers all fields
+                std::vector<double> minMax(2 * numFields);
+                for(size_t f = 0; f < numFields; f++) {
+                    auto range = computeValueRange(reinterpret_cast<const T *>(base + fields[f].offset), numVoxels(), cellStride);
+                    minMax[2 * f] = -range.min;
+                    minMax[2 * f + 1] = range.max;
+                }
+
+                if(livEngine != nullptr && livEngine->isApplicationRank()) {
+                    MPI_Allreduce(MPI_IN_PLACE, minMax.data(), static_cast<int>(minMax.size()), MPI_DOUBLE, MPI_MAX,
+                                  livEngine->applicationComm);
+                }
+
+                for(size_t f = 0; f < numFields; f++) {
+                    lastRanges[f] = {-minMax[2 * f], minMax[2 * f + 1]};
+                }
+            }
+
+            for(size_t f = 0; f < numFields; f++) {
+                const T * src = reinterpret_cast<const T *>(base + fields[f].offset);
+                char * dst = stagingBuffer.data() + f * fieldSize();
+
+                if(quantization.bits == 8) {
+                    quantize(src, numVoxels(), lastRanges[f], dst, cellStride);
+                } else {
+                    quantize(src, numVoxels(), lastRanges[f], reinterpret_cast<unsigned short *>(dst), cellStride);
+                }
+            }
+        } else {
+            const size_t srcStrides[3] = {cellSize, cellSize * dimensions[0], cellSize * dimensions[0] * dimensions[1]};
+            const size_t dstStrides[3] = {sizeof(T), sizeof(T) * dimensions[0], sizeof(T) * dimensions[0] * dimensions[1]};
+
+            for(size_t f = 0; f < numFields; f++) {
+                copyBox(base + fields[f].offset, srcStrides, stagingBuffer.data() + f * fieldSize(), dstStrides,
+                        dimensions, sizeof(T));
+            }
+        }
+
+        std::vector<char *> fieldBuffers;
+        std::vector<long> bufferSizes;
+        for(size_t f = 0; f < numFields; f++) {
+            fieldBuffers.push_back(stagingBuffer.data() + f * fieldSize());
+            bufferSizes.push_back(static_cast<long>(fieldSize()));
+        }
+
+        if(livEngine != nullptr) {
+            livEngine->updateVolumeFields(fieldBuffers, bufferSizes, id);
+        } else {
+            std::cerr << __FILE__ << __LINE__ << "ERROR: LiVEngine is not correctly initialized. Please make sure that"
+                                                 "LiVEngine is correctly passed to the createMultiFieldVolume function" << std::endl;
+        }
+    }
+
+    template <typename T>
+    void MultiFieldVolume<T>::setActiveField(int field) const {
+        if(field < 0 || field >= getNumFields()) {
+            std::cerr << __FILE__ << __LINE__ << "ERROR: Field index " << field << " is out of range!" << std::endl;
+            return;
+        }
+
+        if(livEngine != nullptr) {
+            if(!livEngine->forwardsVolumes()) {
+                livEngine->renderer()->setActiveVolumeField(id, field);
+            }
+        }
+    }
+
+    template <typename T>
+    MultiFieldVolume<T> createMultiFieldVolume(const float * position, const int * dimensions,
+                                               const std::vector<VolumeField>& fields, size_t cellSize,
+                                               LiVEngine* livEngine, const QuantizationOptions& quantizationOptions = {}) {
+        return MultiFieldVolume<T>(position, dimensions, fields, cellSize, livEngine, quantizationOptions);
+    }
+
+    /**
+     * The bricks of a distributed volume, whose ownership moves between the rendering ranks to even out their render
+     * times.
+     *
+     * Every brick is registered with the renderer as a volume of its own on the rank that owns it. rebalance measures
+     * the render time of each local brick, gathers the times of all bricks, and moves bricks from the ranks that take
+     * longest to the ranks that are fastest. Bricks are only moved where the box enclosing the bricks of each rank
+     * overlaps no brick of another rank. Afterwards, the box of every rank is re-registered with addProcessorData.
+     *
+     * Ranks own different numbers of bricks, so floating-point bricks need a fixed range in QuantizationOptions, as the
+     * reduction of the range of every update would not be matched across ranks.
+     */
+    template <typename T>
+    class BalancedBricks {
+    private:
+        // what all ranks learn about a brick when rebalancing
+        struct BrickRecord {
+            int id;
+            int owner;
+            double cost;
+            float position[3];
+            float origin[3];
+            int dimensions[3];
+        };
+
+        struct Brick {
+            float position[3];
+            float origin[3];
+            int dimensions[3];
+            std::vector<T> data;
+            std::optional<Volume<T>> volume;
+            // smoothed render time, negative until measured
+            double cost = -1.0;
+            // render time reported with recordCost since the last rebalance, negative if none
+            double recordedCost = -1.0;
+        };
+
+        LiVEngine* livEngine;
+        QuantizationOptions quantization;
+        std::map<int, Brick> bricks;
+        double smoothing = 0.5;
+
+        static constexpr int migrationTag = 7401;
+        // larger bricks are sent in several messages, as MPI counts are ints
+        static constexpr size_t maxMessageBytes = size_t(1) << 30;
+
+        void measureCosts();
+
+    public:
+        explicit BalancedBricks(LiVEngine* livEngine, const QuantizationOptions& quantizationOptions = {})
+            : livEngine(livEngine), quantization(quantizationOptions) {}
+
+        /**
+         * Take ownership of a brick on this rank and pass it to the renderer.
+         *
+         * @param brickID ID of the brick, unique across all ranks
+         * @param position position of the brick in world coordinates, as for Volume
+         * @param origin origin of the brick in the coordinates passed to addProcessorData
+         * @param dimensions size of the brick in voxels
+         * @param data the voxels of the brick
+         */
+        void addBrick(int brickID, const float * position, const float * origin, const int * dimensions, std::vector<T> data);
+
+        /**
+         * Replace the data of a brick owned by this rank.
+         */
+        void updateBrick(int brickID, const T * data);
+
+        /**
+         * Report the render time of a brick owned by this rank, for renderers that do not measure per-volume times.
+         * Without any measurement, the cost of a brick is estimated from its number of voxels.
+         */
+        void recordCost(int brickID, double seconds) {
+            auto brick = bricks.find(brickID);
+            if(brick != bricks.end()) {
+                brick->second.recordedCost = seconds;
+            }
+        }
+
+        /**
+         * Set the weight of a new measurement in the smoothed cost of a brick, between 0 and 1.
+         */
+        void setSmoothing(double weight) {
+            smoothing = weight;
+        }
+
+        /**
+         * Move bricks between ranks to even out their render times. Collective over livComm, and meant to be called
+         * periodically, e.g. every few time steps.
+         *
+         * @param tolerance the allowed relative excess of the slowest rank over the mean render time
+         * @param maxMigrations the maximum number of bricks moved in this call
+         * @return the number of bricks moved between any ranks
+         */
+        int rebalance(double tolerance = 0.1, int maxMigrations = 16);
+
+        [[nodiscard]] std::vector<int> getOwnedBricks() const {
+            std::vector<int> ids;
+            for(const auto& brick : bricks) {
+                ids.push_back(brick.first);
+            }
+            return ids;
+        }
+
+        [[nodiscard]] const std::vector<T>& getBrickData(int brickID) const {
+            return bricks.at(brickID).data;
+        }
+    };
+
+    template <typename T>
+    void BalancedBricks<T>::addBrick(int brickID, const float * position, const float * origin, const int * dimensions,
+                                     std::vector<T> data) {
+        if constexpr (isQuantizedVolumeType<T>::value) {
+            if(!quantization.range) {
+                std::cerr << "ERROR: Floating-point bricks need a fixed quantization range" << std::endl;
+                return;
+            }
+        }
+
+        auto& brick = bricks[brickID];
+        std::copy(position, position + 3, brick.position);
+        std::copy(origin, origin + 3, brick.origin);
+        std::copy(dimensions, dimensions + 3, brick.dimensions);
+        brick.data = std::move(data);
+
+        brick.volume.emplace(brick.position, brick.dimensions, livEngine, quantization);
+        brick.volume->update(brick.data.data(), static_cast<long int>(brick.data.size() * sizeof(T)));
+    }
+
+    template <typename T>
+    void BalancedBricks<T>::updateBrick(int brickID, const T * data) {
+        auto brick = bricks.find(brickID);
+        if(brick == bricks.end()) {
+            std::cerr << "ERROR: Brick " << brickID << " is not owned by this rank" << std::endl;
+            return;
+        }
+
+        auto& owned = brick->second;
+        std::copy(data, data + owned.data.size(), owned.data.begin());
+        owned.volume->update(owned.data.data(), static_cast<long int>(owned.data.size() * sizeof(T)));
+    }
+
+    template <typename T>
+    void BalancedBricks<T>::measureCosts() {
+        std::vector<int> volumeIDs;
+        for(const auto& brick : bricks) {
+            volumeIDs.push_back(brick.second.volume->getId());
+        }
+        const auto renderTimes = livEngine->getVolumeRenderTimes(volumeIDs);
+
+        size_t index = 0;
+        for(auto& brick : bricks) {
+            auto& owned = brick.second;
+
+            double measured;
+            if(owned.recordedCost >= 0.0) {
+                measured = owned.recordedCost;
+            } else if(!renderTimes.empty()) {
+                measured = renderTimes[index];
+            } else {
+                measured = static_cast<double>(owned.data.size()) * 1e-9;
+            }
+
+            owned.cost = smoothCost(owned.cost, measured, smoothing);
+            owned.recordedCost = -1.0;
+            index++;
+        }
+    }
+
+    template <typename T>
+    int BalancedBricks<T>::rebalance(double tolerance, int maxMigrations) {
+        if(!livEngine->isRenderingRank()) {
+            std::cerr << "ERROR: Bricks can only be balanced between rendering ranks" << std::endl;
+            return 0;
+        }
+
+        MPI_Comm comm = livEngine->livComm;
+        int rank;
+        int numRanks;
+        MPI_Comm_rank(comm, &rank);
+        MPI_Comm_size(comm, &numRanks);
+
+        measureCosts();
+
+        std::vector<BrickRecord> localRecords;
+        for(const auto& brick : bricks) {
+            BrickRecord record{brick.first, rank, brick.second.cost, {}, {}, {}};
+            std::copy(brick.second.position, brick.second.position + 3, record.position);
+            std::copy(brick.second.origin, brick.second.origin + 3, record.origin);
+            std::copy(brick.second.dimensions, brick.second.dimensions + 3, record.dimensions);
+            localRecords.push_back(record);
+        }
+
+        MPI_Datatype recordType;
+        MPI_Type_contiguous(sizeof(BrickRecord), MPI_BYTE, &recordType);
+        MPI_Type_commit(&recordType);
+
+        const int localCount = static_cast<int>(localRecords.size());
+        std::vector<int> counts(numRanks);
+        MPI_Allgather(&localCount, 1, MPI_INT, counts.data(), 1, MPI_INT, comm);
+
+        std::vector<int> displacements(numRanks, 0);
+        for(int r = 1; r < numRanks; r++) {
+            displacements[r] = displacements[r - 1] + counts[r - 1];
+        }
+
+        std::vector<BrickRecord> records(displacements.back() + counts.back());
+        MPI_Allgatherv(localRecords.data(), localCount, recordType, records.data(), counts.data(), displacements.data(),
+                       recordType, comm);
+        MPI_Type_free(&recordType);
+
+        // the planner indexes bricks densely, in an order all ranks agree on
+        std::sort(records.begin(), records.end(), [](const BrickRecord& a, const BrickRecord& b) { return a.id < b.id; });
+
+        std::vector<double> costs;
+        std::vector<int> owners;
+        std::vector<BrickBounds> bounds;
+        for(const auto& record : records) {
+            costs.push_back(record.cost);
+            owners.push_back(record.owner);
+            BrickBounds brickBounds{};
+            for(int d = 0; d < 3; d++) {
+                brickBounds.lower[d] = record.origin[d];
+                brickBounds.upper[d] = record.origin[d] + static_cast<float>(record.dimensions[d]);
+            }
+            bounds.push_back(brickBounds);
+        }
+
+        const auto migrations = planBrickMigrations(costs, owners, numRanks, tolerance, maxMigrations, bounds);
+
+        // both sides post the transfers in plan order, which keeps messages between the same ranks matched
+        std::vector<MPI_Request> requests;
+        std::map<int, std::vector<T>> received;
+        for(const auto& migration : migrations) {
+            const auto& record = records[migration.brick];
+            const size_t numVoxels = static_cast<size_t>(record.dimensions[0]) * record.dimensions[1] * record.dimensions[2];
+            const size_t numBytes = numVoxels * sizeof(T);
+
+            char * data = nullptr;
+            if(migration.to == rank) {
+                received[record.id].resize(numVoxels);
+                data = reinterpret_cast<char *>(received[record.id].data());
+            } else if(migration.from == rank) {
+                data = reinterpret_cast<char *>(bricks[record.id].data.data());
+            } else {
+                continue;
+            }
+
+            for(size_t offset = 0; offset < numBytes; offset += maxMessageBytes) {
+                const int chunkBytes = static_cast<int>(std::min(maxMessageBytes, numBytes - offset));
+                requests.emplace_back();
+                if(migration.to == rank) {
+                    MPI_Irecv(data + offset, chunkBytes, MPI_BYTE, migration.from, migrationTag, comm, &requests.back());
+                } else {
+                    MPI_Isend(data + offset, chunkBytes, MPI_BYTE, migration.to, migrationTag, comm, &requests.back());
+                }
+            }
+        }
+        MPI_Waitall(static_cast<int>(requests.size()), requests.data(), MPI_STATUSES_IGNORE);
+
+        for(const auto& migration : migrations) {
+            const auto& record = records[migration.brick];
+
+            if(migration.from == rank) {
+                livEngine->removeVolume(bricks[record.id].volume->getId());
+                bricks.erase(record.id);
+            } else if(migration.to == rank) {
+                addBrick(record.id, record.position, record.origin, record.dimensions, std::move(received[record.id]));
+                bricks[record.id].cost = record.cost;
+            }
+            owners[migration.brick] = migration.to;
+        }
+
+        // the box of every rank now encloses the bricks it owns after the moves
+        if(!migrations.empty()) {
+            std::vector<float> lower(3 * numRanks, std::numeric_limits<float>::max());
+            std::vector<float> upper(3 * numRanks, std::numeric_limits<float>::lowest());
+            for(size_t b = 0; b < records.size(); b++) {
+                for(int d = 0; d < 3; d++) {
+                    auto& low = lower[3 * owners[b] + d];
+                    auto& high = upper[3 * owners[b] + d];
+                    low = std::min(low, records[b].origin[d]);
+                    high = std::max(high, records[b].origin[d] + static_cast<float>(records[b].dimensions[d]));
+                }
+            }
+
+            std::vector<int> processorIDs;
+            std::vector<float> origins;
+            std::vector<float> dimensions;
+            for(int r = 0; r < numRanks; r++) {
+                if(lower[3 * r] > upper[3 * r]) {
+                    continue;
+                }
+                processorIDs.push_back(r);
+                for(int d = 0; d < 3; d++) {
+                    origins.push_back(lower[3 * r + d]);
+                    dimensions.push_back(upper[3 * r + d] - lower[3 * r + d]);
+                }
+            }
+            livEngine->addProcessorDataBatch(processorIDs, origins, dimensions);
+
+            if(rank == 0) {
+                const auto loads = computeRankLoads(costs, owners, numRanks);
+                std::cout << "Moved " << migrations.size() << " bricks, the slowest rank now takes "
+                          << *std::max_element(loads.begin(), loads.end()) << " s" << std::endl;
+            }
+        }
+
+        return static_cast<int>(migrations.size());
+    }
+
+    /**
+     * What TimeSeriesPlayback measured while playing a time series.
+     */
+    struct PlaybackStatistics {
+        int steps = 0;
+        // steps that were read only after their deadline
+        int lateSteps = 0;
+        double totalWaitSeconds = 0.0;
+        double maxWaitSeconds = 0.0;
+        double meanReadSeconds = 0.0;
+    };
+
+    /**
+     * Plays a sequence of timesteps into a volume at a fixed rate, reading the next steps in the background while the
+     * current one is rendered.
+     *
+     * Every step is read by the loader into a buffer of the prefetcher, and the buffer is kept until the following
+     * step has been passed to update, as the renderer may still use it. If a step is not read by its deadline, playback
+     * waits for it and continues from there without skipping steps, and a warning reports that I/O cannot keep up.
+     * The buffer of the last step played is kept by the playback, which must therefore outlive its use by the volume.
+     */
+    template <typename T>
+    class TimeSeriesPlayback {
+    private:
+        Volume<T>& volume;
+        TimestepPrefetcher::Loader loader;
+        int numSteps;
+        double stepsPerSecond;
+        int prefetchDepth;
+        // holds the buffer of the last step passed to the volume
+        std::unique_ptr<TimestepPrefetcher> prefetcher;
+
+    public:
+        /**
+         * @param volume the volume that receives the timesteps
+         * @param loader reads a step into a buffer of sizeof(T) times the number of voxels of the volume
+         * @param numSteps the number of timesteps
+         * @param stepsPerSecond the target rate, or 0 to play as fast as the steps can be read
+         * @param prefetchDepth the number of steps read ahead of the current one
+         */
+        TimeSeriesPlayback(Volume<T>& volume, TimestepPrefetcher::Loader loader, int numSteps, double stepsPerSecond,
+                           int prefetchDepth = 2)
+            : volume(volume), loader(std::move(loader)), numSteps(numSteps), stepsPerSecond(stepsPerSecond),
+              prefetchDepth(prefetchDepth) {}
+
+        /**
+         * Play the time series, loops times in a row, and return once the last step has been passed to the volume.
+         * Stops early if a step cannot be read.
+         */
+        PlaybackStatistics play(int loops = 1);
+    };
+
+    template <typename T>
+    PlaybackStatistics TimeSeriesPlayback<T>::play(int loops) {
+        using Clock = std::chrono::steady_clock;
+
+        PlaybackStatistics statistics;
+        if(numSteps <= 0 || loops <= 0) {
+            return statistics;
+        }
+
+        // a single prefetcher over all loops, so that the last step of a loop stays valid while the first step of the
+        // next loop is passed to the volume
+        auto playing = std::make_unique<TimestepPrefetcher>([this](int step, std::vector<char>& data) {
+            return loader(step % numSteps, data);
+        }, numSteps * loops, prefetchDepth);
+        TimestepPrefetcher& source = *playing;
+
+        const bool paced = stepsPerSecond > 0.0;
+        const auto interval = std::chrono::duration_cast<Clock::duration>(
+            std::chrono::duration<double>(paced ? 1.0 / stepsPerSecond : 0.0));
+
+        PrefetchedTimestep previous;
+        PrefetchedTimestep current;
+        double totalReadSeconds = 0.0;
+        Clock::time_point deadline;
+
+        while(source.next(current)) {
+            // taken before waiting for the deadline, so that only steps read after it count as late
+            const auto ready = Clock::now();
+
+            statistics.steps++;
+            statistics.totalWaitSeconds += current.waitSeconds;
+            statistics.maxWaitSeconds = std::max(statistics.maxWaitSeconds, current.waitSeconds);
+            totalReadSeconds += current.readSeconds;
+
+            if(paced && statistics.steps == 1) {
+                deadline = ready;
+            } else if(paced && ready > deadline) {
+                if(statistics.lateSteps == 0) {
+                    std::cerr << "WARNING: Timestep " << current.step % numSteps << " was read "
+                              << std::chrono::duration<double>(ready - deadline).count()
+                              << " s after its deadline, I/O cannot keep up with " << stepsPerSecond
+                              << " steps per second (read took " << current.readSeconds << " s)" << std::endl;
+                }
+                statistics.lateSteps++;
+                // continue from the late step without catching up on the time lost
+                deadline = ready;
+            }
+
+            if(paced) {
+                std::this_thread::sleep_until(deadline);
+                deadline += interval;
+            }
+
+            volume.update(reinterpret_cast<T *>(current.data), static_cast<long int>(current.size));
+
+            if(playing) {
+                // the volume no longer uses the last step of a previous play
+                prefetcher = std::move(playing);
+            }
+            source.release(previous);
+            previous = current;
+        }
+
+        statistics.meanReadSeconds = statistics.steps > 0 ? totalReadSeconds / statistics.steps : 0.0;
+        if(statistics.lateSteps > 0) {
+            std::cerr << "WARNING: " << statistics.lateSteps << " of " << statistics.steps
+                      << " timesteps were late, with a mean read time of " << statistics.meanReadSeconds
+                      << " s per step" << std::endl;
+        }
+        return statistics;
+    }
+
+    /**
+     * A volume whose brick is padded with a ghost layer taken from the bricks of neighbouring ranks, so that the
+     * renderer interpolates across brick boundaries without seams.
+     *
+     * The boxes of all application ranks, i.e. the unpadded boxes passed to addProcessorData, are gathered once to find
+     * the neighbours. On every update the ghost layer is exchanged with persistent requests while the brick is copied
+     * into the padded buffer. Two padded buffers alternate between updates, so that the renderer can keep the previous
+     * one until the next update.
+     */
+    template <typename T>
+    class HaloVolume {
+    private:
+        HaloExchange halo;
+        std::vector<T> buffers[2];
+        int current = 0;
+        Volume<T> volume;
+
+    public:
+        /**
+         * Collective over the application ranks.
+         *
+         * @param position position of the padded brick in world coordinates, as for Volume, see paddedBox
+         * @param box the voxels of this rank's brick in the coordinates of the whole volume
+         * @param ghost width of the ghost layer in voxels
+         */
+        HaloVolume(const float * position, const Box& box, int ghost, LiVEngine* livEngine,
+                   const QuantizationOptions& quantizationOptions = {})
+            : halo(box, ghost, sizeof(T), livEngine->isApplicationRank() ? livEngine->applicationComm : MPI_COMM_SELF),
+              volume(position, halo.getPaddedBox().extent, livEngine, quantizationOptions) {
+            for(auto& buffer : buffers) {
+                buffer.resize(halo.getPaddedBox().numVoxels());
+            }
+        }
+
+        /**
+         * Fill the ghost layer from the neighbouring ranks and pass the padded brick to the renderer. Collective over
+         * the application ranks.
+         *
+         * @param data the voxels of the unpadded brick
+         */
+        void update(const T * data);
+
+        [[nodiscard]] Volume<T>& getVolume() { return volume; }
+
+        [[nodiscard]] const Box& getPaddedBox() const { return halo.getPaddedBox(); }
+    };
+
+    template <typename T>
+    void HaloVolume<T>::update(const T * data) {
+        auto& padded = buffers[current];
+        current = 1 - current;
+
+        // ghost cells keep the nearest voxels of the brick if the exchange fails
+        halo.exchange(reinterpret_cast<const char *>(data), reinterpret_cast<char *>(padded.data()));
+
+        volume.update(padded.data(), static_cast<long int>(padded.size() * sizeof(T)));
+    }
+
+    template <typename T>
+    std::vector<Volume<T>> LiVEngine::createVolumes(const std::vector<float>& positions, const std::vector<int>& dimensions,
+                                                    const QuantizationOptions& quantizationOptions) {
+        if(positions.size() != dimensions.size() || positions.size() % 3 != 0) {
+            std::cerr << __FILE__ << __LINE__ << "ERROR: Positions and dimensions must contain 3 values per volume." << std::endl;
+            return {};
+        }
+
+        const size_t numVolumes = positions.size() / 3;
+
+        std::vector<Volume<T>> volumes;
+        volumes.reserve(numVolumes);
+        std::vector<int> volumeIDs;
+
+        // forwarded volumes are registered one by one with the rank that renders them
+        for(size_t v = 0; v < numVolumes; v++) {
+            volumes.push_back(Volume<T>(&positions[3 * v], &dimensions[3 * v], this, quantizationOptions, forwardsVolumes()));
+            volumeIDs.push_back(volumes.back().getId());
+        }
+
+        if(numVolumes == 0 || forwardsVolumes()) {
+            return volumes;
+        }
+
+        if(asynchronousStartup && !(startupComplete() && renderer()->isRendererConfigured())) {
+            std::cout << "Renderer not ready yet, queueing registration of " << numVolumes << " volumes" << std::endl;
+            for(size_t v = 0; v < numVolumes; v++) {
+                pendingVolumes.push_back({volumeIDs[v], {dimensions.begin() + 3 * v, dimensions.begin() + 3 * v + 3},
+                                          {positions.begin() + 3 * v, positions.begin() + 3 * v + 3},
+                                          volumes.front().is16BitData()});
+            }
+            return volumes;
+        }
+
+        registerPendingVolumes();
+        waitRendererReady();
+
+        renderer()->addVolumes(volumeIDs, dimensions, positions, volumes.front().is16BitData());
+
+        return volumes;
+    }
+
+    template <typename T>
+    std::vector<Volume<T>> LiVEngine::createVolumes(const std::vector<float>& positions, const std::vector<int>& dimensions) {
+        return createVolumes<T>(positions, dimensions, QuantizationOptions{});
+    }
+
+    template <typename T>
+    void LiVEngine::updateVolumes(std::vector<Volume<T>>& volumes, const std::vector<T *>& buffers,
+                                  const std::vector<long int>& bufferSizes) {
+        if(volumes.size() != buffers.size() || volumes.size() != bufferSizes.size()) {
+            std::cerr << __FILE__ << __LINE__ << "ERROR: Every volume needs exactly one buffer and buffer size." << std::endl;
+            return;
+        }
+
+        // a single reduction for the whole batch, as a reduction per volume deadlocks once ranks hold different
+        // numbers of volumes
+        const ValueRange * batchRange = nullptr;
+        ValueRange range{std::numeric_limits<double>::max(), std::numeric_limits<double>::lowest()};
+        if constexpr (isQuantizedVolumeType<T>::value) {
+            for(size_t v = 0; v < volumes.size(); v++) {
+                if(volumes[v].quantization.range
+                   || static_cast<size_t>(bufferSizes[v]) != volumes[v].numVoxels() * sizeof(T)) {
+                    continue;
+                }
+                const ValueRange volumeRange = computeValueRange(buffers[v], volumes[v].numVoxels());
+                range.min = std::min(range.min, volumeRange.min);
+                range.max = std::max(range.max, volumeRange.max);
+            }
+
+            if(isApplicationRank()) {
+                double minMax[2] = {-range.min, range.max};
+                MPI_Allreduce(MPI_IN_PLACE, minMax, 2, MPI_DOUBLE, MPI_MAX, applicationComm);
+                range = {-minMax[0], minMax[1]};
+            }
+            batchRange = &range;
+        }
+
+        if(forwardsVolumes()) {
+            for(size_t v = 0; v < volumes.size(); v++) {
+                volumes[v].update(buffers[v], bufferSizes[v], batchRange);
+            }
+            return;
+        }
+
+        std::vector<int> volumeIDs;
+        std::vector<char *> volumeBuffers;
+        std::vector<long> volumeSizes;
+        std::vector<Volume<T> *> transferred;
+
+        for(size_t v = 0; v < volumes.size(); v++) {
+            char * data;
+            long int dataSize;
+
+            if(!volumes[v].stageUpdate(buffers[v], bufferSizes[v], data, dataSize, batchRange)) {
+                continue;
+            }
+
+            if(volumes[v].transferChangedBricks(data)) {
+                continue;
+            }
+
+            volumeIDs.push_back(volumes[v].getId());
+            volumeBuffers.push_back(data);
+            volumeSizes.push_back(dataSize);
+            transferred.push_back(&volumes[v]);
+        }
+
+        if(!volumeIDs.empty()) {
+            std::cout << "Updating " << volumeIDs.size() << " volumes" << std::endl;
+            registerPendingVolumes();
+            renderer()->updateVolumes(volumeIDs, volumeBuffers, volumeSizes);
+        }
+
+        for(size_t v = 0; v < transferred.size(); v++) {
+            transferred[v]->publishBrickStatistics();
+            transferred[v]->publishLevels(volumeBuffers[v], {});
+        }
     }
 } // namespace liv
 
@@ -0,0 +1,104 @@
+/**
+ * @file AMRResampling.h
+ * @brief This file contains the declarations of a resampler that composes the patches of a block-structured AMR
+ * hierarchy into a uniform brick, so that AMR data can be rendered as a Volume<float>.
+ */
+
+#ifndef AMRRESAMPLING_H
+#define AMRRESAMPLING_H
+
+#include <vector>
+
+#include "utils/Bricking.h"
+
+namespace liv {
+
+    /**
+     * @brief A patch of cells at one refinement level of an AMR hierarchy.
+     */
+    struct AMRPatch {
+        // refinement level, 0 being the coarsest
+        int level;
+        // the cells of the patch, in the index space of its level
+        Box box;
+        // box.extent cells in x-fastest order, which must stay valid until the patch is resampled
+        const float *data;
+    };
+
+    /**
+     * @brief Composes AMR patches into a uniform brick at the resolution of a chosen level.
+     *
+     * Every cell of the brick takes the value of the finest patch that covers its center. A patch finer than the
+     * brick contributes the mean of its cells within the brick cell, a coarser patch the value of the cell
+     * containing the brick cell's center. Cells not covered by any patch hold the fill value. Patches of the same
+     * level must not overlap, as in any block-structured AMR hierarchy, and are resampled in parallel.
+     *
+     * To produce several bricks, e.g. one per cluster of patches, use one resampler per brick with the same patches.
+     */
+    class AMRResampler {
+        Box box;
+        int level;
+        int refinementRatio;
+        float fillValue;
+        std::vector<AMRPatch> patches;
+        std::vector<float> brick;
+
+        // the cells of the brick whose centers the patch covers
+        [[nodiscard]] Box coveredCells(const AMRPatch& patch) const;
+
+        void resampleRegion(const Box& region);
+
+        void resamplePatch(const AMRPatch& patch, const Box& region);
+
+    public:
+        /**
+         * @param box The cells of the brick, in the index space of the given level.
+         * @param level The refinement level whose resolution the brick has.
+         * @param refinementRatio The refinement ratio between consecutive levels.
+         * @param fillValue The value of cells not covered by any patch.
+         */
+        AMRResampler(const Box& box, int level, int refinementRatio = 2, float fillValue = 0.0f);
+
+        /**
+         * @brief Add a patch to the hierarchy.
+         *
+         * @return The ID of the patch, for setPatchData and incremental resampling.
+         */
+        int addPatch(const AMRPatch& patch);
+
+        /**
+         * @brief Point a patch to new data, e.g. after the simulation advanced it.
+         */
+        void setPatchData(int patchID, const float *data);
+
+        [[nodiscard]] const std::vector<AMRPatch>& getPatches() const { return patches; }
+
+        /**
+         * @brief Compose all patches into the brick.
+         */
+        void resample();
+
+        /**
+         * @brief Recompose the parts of the brick covered by the given patches, after their data changed.
+         *
+         * Only the patches overlapping these parts are resampled again.
+         *
+         * @return The regions of the brick that were recomposed, in brick coordinates, e.g. for Volume::updateRegion.
+         */
+        std::vector<Box> resample(const std::vector<int>& changedPatches);
+
+        /**
+         * @brief Get the brick, box.extent cells in x-fastest order.
+         */
+        [[nodiscard]] std::vector<float>& getBrick() { return brick; }
+
+        [[nodiscard]] const Box& getBox() const { return box; }
+    };
+
+    /**
+     * @brief Get the bounding box of the given patches in the index space of a level.
+     */
+    Box boundingBox(const std::vector<AMRPatch>& patches, int level, int refinementRatio = 2);
+}
+
+#endif //AMRRESAMPLING_H
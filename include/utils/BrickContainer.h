@@ -0,0 +1,197 @@
+/**
+ * @file BrickContainer.h
+ * @brief This file contains the declarations of a single-file container for bricked volumes, from which blocks of
+ * any decomposition can be read.
+ */
+
+#ifndef BRICKCONTAINER_H
+#define BRICKCONTAINER_H
+
+#include <atomic>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#include "utils/Bricking.h"
+#include "utils/VolumeIO.h"
+
+namespace liv {
+
+    /**
+     * @brief How the data of a brick is stored in a container.
+     */
+    enum class BrickCompression : uint32_t {
+        None = 0,
+        // zlib deflate, only available if LiV was built with zlib
+        Deflate = 1
+    };
+
+    /**
+     * @brief Whether bricks can be written and read with the given compression in this build.
+     */
+    bool isCompressionSupported(BrickCompression compression);
+
+    /**
+     * @brief Header at the start of a container file.
+     *
+     * The file consists of the header, the brick data and the brick table, each starting at a multiple of the
+     * alignment and padded to a multiple of it. Every brick can therefore be mapped or read with O_DIRECT on its own.
+     * Bricks follow the BrickGrid of the volume dimensions and brick size and hold their voxels in x-fastest order.
+     * All values are stored in the byte order of the writing machine.
+     */
+    struct BrickContainerHeader {
+        char magic[8];
+        uint32_t version;
+        uint32_t alignment;
+        int32_t dimensions[3];
+        int32_t bitResolution;
+        int32_t brickSize[3];
+        uint32_t numBricks;
+        uint32_t flags;
+        uint32_t reserved;
+        uint64_t tableOffset;
+    };
+
+    /**
+     * @brief Entry of the brick table, one per brick in brick order.
+     */
+    struct BrickContainerEntry {
+        uint64_t offset;
+        uint64_t storedSize;
+        uint32_t compression;
+        // value range of the brick, valid if the header has kBrickContainerHasMinMax set
+        int32_t minValue;
+        int32_t maxValue;
+        // number of voxels above zero, valid if the header has kBrickContainerHasVoxelCounts set
+        uint32_t nonEmptyVoxels;
+    };
+
+    constexpr uint32_t kBrickContainerVersion = 1;
+    constexpr uint32_t kBrickContainerHasMinMax = 1u << 0;
+    constexpr uint32_t kBrickContainerHasVoxelCounts = 1u << 1;
+    constexpr uint32_t kBrickContainerDefaultAlignment = 4096;
+
+    /**
+     * @brief Writes a volume brick by brick into a container file.
+     *
+     * Bricks may be written in any order and from several threads at once. Compressed bricks are appended in the
+     * order in which they are written, uncompressed bricks have fixed places in the file.
+     */
+    class BrickContainerWriter {
+        int fd = -1;
+        std::string path;
+        BrickContainerHeader header{};
+        BrickGrid grid;
+        BrickCompression compression = BrickCompression::None;
+        std::vector<BrickContainerEntry> entries;
+        std::atomic<uint64_t> end{0};
+
+    public:
+        BrickContainerWriter() = default;
+
+        BrickContainerWriter(const BrickContainerWriter&) = delete;
+
+        BrickContainerWriter& operator=(const BrickContainerWriter&) = delete;
+
+        ~BrickContainerWriter();
+
+        /**
+         * @brief Create the container file, replacing an existing file.
+         *
+         * @return false if the file cannot be created or the compression is not supported in this build.
+         */
+        bool open(const std::string& path, const VolumeDescription& volume, const int *brickSize,
+                  BrickCompression compression = BrickCompression::None,
+                  uint32_t alignment = kBrickContainerDefaultAlignment);
+
+        [[nodiscard]] const BrickGrid& getGrid() const { return grid; }
+
+        /**
+         * @brief Write one brick and record its value range and number of non-empty voxels.
+         *
+         * @param data The voxels of the brick in x-fastest order, grid.brickBox(brickIndex).numVoxels() elements.
+         */
+        bool writeBrick(int brickIndex, const char *data);
+
+        /**
+         * @brief Write the brick table and the header. The container is incomplete until this succeeds.
+         */
+        bool close();
+    };
+
+    /**
+     * @brief Read access to a container file.
+     */
+    class BrickContainer {
+        int fd = -1;
+        bool direct = false;
+        BrickContainerHeader header{};
+        BrickGrid grid;
+        std::vector<BrickContainerEntry> entries;
+
+        bool readStored(const BrickContainerEntry& entry, std::vector<char>& stored) const;
+
+    public:
+        BrickContainer() = default;
+
+        BrickContainer(const BrickContainer&) = delete;
+
+        BrickContainer& operator=(const BrickContainer&) = delete;
+
+        ~BrickContainer();
+
+        /**
+         * @brief Open a container and read its header and brick table.
+         *
+         * @param directIO Read brick data with O_DIRECT, bypassing the page cache. Falls back to buffered reads if
+         * the file system does not support it.
+         * @return false if the file cannot be read or is not a container of a supported version.
+         */
+        bool open(const std::string& path, bool directIO = false);
+
+        void close();
+
+        [[nodiscard]] VolumeDescription getVolume() const;
+
+        [[nodiscard]] const BrickGrid& getGrid() const { return grid; }
+
+        [[nodiscard]] bool hasMinMax() const { return (header.flags & kBrickContainerHasMinMax) != 0; }
+
+        [[nodiscard]] bool hasVoxelCounts() const { return (header.flags & kBrickContainerHasVoxelCounts) != 0; }
+
+        /**
+         * @brief Estimate the number of non-empty voxels in a box from the counts of the bricks it intersects,
+         * assuming that they are spread evenly within each brick.
+         *
+         * @return The number of voxels of the box if the container has no voxel counts.
+         */
+        [[nodiscard]] double estimateNonEmptyVoxels(const Box& box) const;
+
+        [[nodiscard]] const BrickContainerEntry& getEntry(int brickIndex) const { return entries[brickIndex]; }
+
+        /**
+         * @brief Read and decompress one brick.
+         */
+        bool readBrick(int brickIndex, std::vector<char>& data) const;
+
+        /**
+         * @brief Read a box of the volume, assembled from all bricks that intersect it, in x-fastest order.
+         */
+        bool readBox(const Box& box, std::vector<char>& data) const;
+    };
+
+    /**
+     * @brief Get whether the file at the given path starts with the container magic.
+     */
+    bool isBrickContainer(const std::string& path);
+
+    /**
+     * @brief Read the block with the given index of the regular decomposition into numBlocks blocks from a container.
+     *
+     * The decomposition is the same as for loadVolumeBlock and volume_divider, independent of the brick size of the
+     * container, so that any number of ranks can read their blocks from the same file.
+     */
+    bool loadContainerBlock(const std::string& path, int blockIndex, int numBlocks, VolumeBlock& block);
+}
+
+#endif //BRICKCONTAINER_H
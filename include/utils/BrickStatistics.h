@@ -0,0 +1,59 @@
+/**
+ * @file BrickStatistics.h
+ * @brief This file contains the declarations of kernels computing per-brick value ranges and value histograms,
+ * which the renderer uses to skip bricks that are empty under the current transfer function.
+ */
+
+#ifndef BRICKSTATISTICS_H
+#define BRICKSTATISTICS_H
+
+#include <vector>
+
+#include "utils/Bricking.h"
+
+namespace liv {
+
+    /**
+     * @brief Value ranges of the bricks of a volume and a histogram of all its values.
+     *
+     * Values are given in the integer units of the renderer format, i.e. [0, 255] for 8-bit and [0, 65535] for
+     * 16-bit data.
+     */
+    struct BrickStatistics {
+        // minimum and maximum value of every brick, interleaved and indexed by brick
+        std::vector<int> minMax;
+
+        // number of voxels per value bin, with the bins evenly dividing the value range of the renderer format
+        std::vector<int> histogram;
+    };
+
+    /**
+     * @brief Compute the value range of every brick and the value histogram of a packed volume.
+     *
+     * The bricks are distributed across the worker threads, each of which accumulates a private histogram.
+     *
+     * @param volume A pointer to the packed volume data in the renderer format.
+     * @param grid The brick decomposition of the volume.
+     * @param volumeDimensions The dimensions of the volume.
+     * @param is16BitData Whether the data consists of 16-bit (or otherwise 8-bit) unsigned values.
+     * @param numBins The number of histogram bins, a power of two no larger than 256.
+     * @param statistics The statistics to fill in.
+     */
+    void computeBrickStatistics(const char *volume, const BrickGrid& grid, const int *volumeDimensions,
+                                bool is16BitData, int numBins, BrickStatistics& statistics);
+
+    /**
+     * @brief Recompute the value ranges of the given bricks, leaving the other bricks and the histogram unchanged.
+     *
+     * @param volume A pointer to the packed volume data in the renderer format.
+     * @param grid The brick decomposition of the volume.
+     * @param volumeDimensions The dimensions of the volume.
+     * @param is16BitData Whether the data consists of 16-bit (or otherwise 8-bit) unsigned values.
+     * @param bricks The indices of the bricks to update.
+     * @param statistics The statistics to update, previously filled in by computeBrickStatistics.
+     */
+    void updateBrickRanges(const char *volume, const BrickGrid& grid, const int *volumeDimensions, bool is16BitData,
+                           const std::vector<int>& bricks, BrickStatistics& statistics);
+}
+
+#endif //BRICKSTATISTICS_H
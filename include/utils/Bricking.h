@@ -0,0 +1,123 @@
+/**
+ * @file Bricking.h
+ * @brief This file contains the declarations of utilities for splitting volumes into bricks and copying
+ * rectangular regions between volume buffers.
+ */
+
+#ifndef BRICKING_H
+#define BRICKING_H
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+namespace liv {
+
+    /**
+     * @brief Axis-aligned box of voxels, given by the voxel coordinates of its origin and its extent.
+     */
+    struct Box {
+        int offset[3];
+        int extent[3];
+
+        [[nodiscard]] size_t numVoxels() const {
+            return static_cast<size_t>(extent[0]) * extent[1] * extent[2];
+        }
+    };
+
+    /**
+     * @brief Compute the intersection of two boxes.
+     *
+     * @return false if the boxes do not overlap, leaving result unspecified.
+     */
+    bool intersectBoxes(const Box& a, const Box& b, Box& result);
+
+    /**
+     * @brief Get a box grown by the given number of voxels on every side.
+     */
+    Box paddedBox(const Box& box, int ghost);
+
+    /**
+     * @brief Regular decomposition of a volume into bricks of a fixed size.
+     *
+     * Bricks are numbered in x-fastest order. Bricks at the upper boundaries of the volume are truncated if the
+     * volume dimensions are not multiples of the brick size.
+     */
+    class BrickGrid {
+        int volumeDimensions[3]{};
+        int brickSize[3]{};
+        int brickCounts[3]{};
+
+    public:
+        BrickGrid() = default;
+
+        BrickGrid(const int *volumeDimensions, const int *brickSize);
+
+        [[nodiscard]] int numBricks() const {
+            return brickCounts[0] * brickCounts[1] * brickCounts[2];
+        }
+
+        [[nodiscard]] const int *getBrickCounts() const {
+            return brickCounts;
+        }
+
+        [[nodiscard]] const int *getBrickSize() const {
+            return brickSize;
+        }
+
+        /**
+         * @brief Get the box of voxels covered by the brick with the given index.
+         */
+        [[nodiscard]] Box brickBox(int brickIndex) const;
+
+        /**
+         * @brief Get the indices of all bricks that intersect the given region, in ascending order.
+         *
+         * The region is clipped to the volume.
+         */
+        [[nodiscard]] std::vector<int> bricksIntersecting(const int *offset, const int *extent) const;
+    };
+
+    /**
+     * @brief Copy a box of elements between two strided buffers.
+     *
+     * Strides are given in bytes for the x, y and z directions. Rows are copied with memcpy when both buffers are
+     * contiguous along x. Large boxes are copied by several threads.
+     *
+     * @param src A pointer to the first element of the box in the source buffer.
+     * @param srcStrides The byte strides of the source buffer.
+     * @param dst A pointer to the first element of the box in the destination buffer.
+     * @param dstStrides The byte strides of the destination buffer.
+     * @param extent The extent of the box in elements.
+     * @param elementSize The size of an element in bytes.
+     */
+    void copyBox(const char *src, const size_t *srcStrides, char *dst, const size_t *dstStrides,
+                 const int *extent, size_t elementSize);
+
+    /**
+     * @brief Compute a 64-bit hash of a box of elements in a strided buffer.
+     *
+     * The hash is meant for detecting changes between versions of the same data, not for cryptographic use. It
+     * processes 64 bytes at a time in independent 32-bit lanes, which the compiler can vectorize.
+     *
+     * @param src A pointer to the first element of the box.
+     * @param strides The byte strides of the buffer along x, y and z. The buffer must be contiguous along x.
+     * @param extent The extent of the box in elements.
+     * @param elementSize The size of an element in bytes.
+     * @return The hash of the box contents.
+     */
+    uint64_t hashBox(const char *src, const size_t *strides, const int *extent, size_t elementSize);
+
+    /**
+     * @brief Compute the hashes of all bricks of a packed volume, with the bricks distributed across threads.
+     *
+     * @param volume A pointer to the packed volume data.
+     * @param grid The brick decomposition of the volume.
+     * @param volumeDimensions The dimensions of the volume in elements.
+     * @param elementSize The size of an element in bytes.
+     * @return The hash of every brick, indexed by brick.
+     */
+    std::vector<uint64_t> hashBricks(const char *volume, const BrickGrid& grid, const int *volumeDimensions, size_t elementSize);
+}
+
+#endif //BRICKING_H
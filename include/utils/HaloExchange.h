@@ -0,0 +1,99 @@
+/**
+ * @file HaloExchange.h
+ * @brief This file contains the declarations of an exchange of ghost cells between the bricks of neighbouring ranks,
+ * so that bricks can be interpolated across their boundaries without seams.
+ */
+
+#ifndef HALOEXCHANGE_H
+#define HALOEXCHANGE_H
+
+#include <mpi.h>
+#include <cstddef>
+#include <vector>
+
+#include "utils/Bricking.h"
+
+namespace liv {
+
+    /**
+     * @brief Fills the ghost layer of a brick with the voxels of the bricks of neighbouring ranks.
+     *
+     * The neighbours are found once, from the boxes of all ranks of the communicator, which must not overlap. The
+     * messages are set up as persistent requests on fixed buffers, so each exchange only packs, starts and unpacks
+     * them. Ghost cells not covered by any neighbour, at the boundary of the whole volume, repeat the nearest voxel of
+     * the brick.
+     *
+     * An exchange is split into start and finish, so that the interior of the brick can be copied into the padded
+     * buffer while the messages are in flight.
+     */
+    class HaloExchange {
+        // a box of voxels exchanged with a neighbour, relative to the brick for sends and to the padded brick for
+        // receives
+        struct Message {
+            int rank;
+            Box box;
+            std::vector<char> buffer;
+        };
+
+        Box box;
+        Box padded;
+        int ghost;
+        size_t elementSize;
+        std::vector<Message> sends;
+        std::vector<Message> receives;
+        // persistent requests, receives first
+        std::vector<MPI_Request> requests;
+        bool inFlight = false;
+
+        static constexpr int haloTag = 7403;
+
+    public:
+        /**
+         * Gather the boxes of all ranks and set up the messages to the neighbours of this rank. Collective over comm.
+         *
+         * @param box The voxels of the brick of this rank, in the coordinates of the whole volume.
+         * @param ghost The width of the ghost layer in voxels.
+         * @param elementSize The size of a voxel in bytes.
+         */
+        HaloExchange(const Box& box, int ghost, size_t elementSize, MPI_Comm comm);
+
+        HaloExchange(const HaloExchange&) = delete;
+
+        HaloExchange& operator=(const HaloExchange&) = delete;
+
+        ~HaloExchange();
+
+        /**
+         * @brief Pack the voxels the neighbours need from the brick and start all messages.
+         *
+         * @param interior box.extent voxels in x-fastest order.
+         */
+        bool start(const char *interior);
+
+        /**
+         * @brief Copy the brick into the padded buffer and fill the ghost layer from its nearest voxels.
+         *
+         * @param padded getPaddedBox().extent voxels in x-fastest order.
+         */
+        void copyInterior(const char *interior, char *padded) const;
+
+        /**
+         * @brief Wait for all messages and copy the received voxels into the ghost layer of the padded buffer.
+         */
+        bool finish(char *padded);
+
+        /**
+         * @brief Start, copy the interior and finish, in this order.
+         */
+        bool exchange(const char *interior, char *padded);
+
+        [[nodiscard]] const Box& getPaddedBox() const { return padded; }
+
+        /**
+         * @brief Get the ranks this rank exchanges voxels with.
+         */
+        [[nodiscard]] std::vector<int> getNeighbours() const;
+    };
+}
+
+#endif //HALOEXCHANGE_H
@@ -0,0 +1,99 @@
+/**
+ * @file JVMConfiguration.h
+ * @brief This file contains the declarations of utilities for resolving the JVM configuration on a single rank and
+ * distributing it to all other ranks.
+ */
+
+#ifndef JVMCONFIGURATION_H
+#define JVMCONFIGURATION_H
+
+#include <mpi.h>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+namespace liv {
+
+    /**
+     * @brief Inputs of the JVM options: the resolved class path, the contents of the options file and the relevant
+     * environment variables.
+     *
+     * Environment variables that are not set are represented by empty strings.
+     */
+    struct JVMConfiguration {
+        std::string classPath;
+        std::vector<std::string> fileOptions;
+        std::string headless;
+        std::string benchmark;
+        std::string mpiJniLibPath;
+        // rank-local, see readRankEnvironment
+        std::string lwjglSharedPath;
+        std::string lwjglLibraryPath;
+        std::string gpuId;
+        // see fingerprintNativeJars
+        uint64_t nativesFingerprint = 0;
+        // directory for class-data-sharing archives, class-data sharing is disabled if empty
+        std::string classDataArchiveDirectory;
+    };
+
+    /**
+     * @brief Choices made per node at start-up that affect the JVM options.
+     */
+    struct JVMNodeOptions {
+        // directory shared by all ranks on the node into which LWJGL extracts and from which it loads its native
+        // libraries. If empty, every rank uses its own directories below LWJGL_SHARED_PATH and LWJGL_LIBRARY_PATH.
+        std::string nativeLibraryDirectory;
+        // class-data-sharing archive to map, not used if empty
+        std::string classDataArchive;
+        // whether this rank (re)creates the archive when the JVM exits if it is missing or stale
+        bool recordClassDataArchive = false;
+    };
+
+    /**
+     * @brief Scan the class path directory, read liv_jvm_options.txt from the current directory and query the
+     * environment variables that determine the JVM options.
+     *
+     * @param configuration The configuration to fill.
+     * @return false if SCENERY_CLASS_PATH is not set or the directory cannot be opened.
+     */
+    bool readJVMConfiguration(JVMConfiguration& configuration);
+
+    /**
+     * @brief Query the environment variables that may differ between ranks: SCENERY_GPU_ID, which launch scripts set
+     * per rank to assign GPUs, and the node-local LWJGL_SHARED_PATH and LWJGL_LIBRARY_PATH.
+     *
+     * These are not broadcast, but read by every rank.
+     */
+    void readRankEnvironment(JVMConfiguration& configuration);
+
+    std::vector<char> serializeJVMConfiguration(const JVMConfiguration& configuration);
+
+    bool deserializeJVMConfiguration(const std::vector<char>& buffer, JVMConfiguration& configuration);
+
+    /**
+     * @brief Read the configuration on the root rank only and broadcast it to all ranks of the communicator.
+     *
+     * This replaces one directory scan and file read per rank with a single one, which matters on parallel file
+     * systems at large rank counts. The rank-local environment variables are then read by every rank, see
+     * readRankEnvironment. Collective over comm.
+     *
+     * @return false on all ranks if the configuration could not be read on the root rank.
+     */
+    bool broadcastJVMConfiguration(JVMConfiguration& configuration, int root, MPI_Comm comm);
+
+    /**
+     * @brief Build the option strings passed to JNI_CreateJavaVM for the given rank.
+     */
+    std::vector<std::string> buildJVMOptions(const JVMConfiguration& configuration, int rank,
+                                             const JVMNodeOptions& nodeOptions = {});
+
+    /**
+     * @brief Get the path of the class-data-sharing archive used by the ranks on the node with the given name.
+     *
+     * Archives are per node, so that the directory may be on a shared file system without nodes overwriting each
+     * other's archives.
+     */
+    std::string classDataArchivePath(const JVMConfiguration& configuration, const std::string& nodeName);
+}
+
+#endif //JVMCONFIGURATION_H
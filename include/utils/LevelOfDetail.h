@@ -0,0 +1,66 @@
+/**
+ * @file LevelOfDetail.h
+ * @brief This file contains the declarations of kernels building a multiresolution pyramid of a volume, which the
+ * renderer samples instead of the full-resolution data for distant or interacting views.
+ */
+
+#ifndef LEVELOFDETAIL_H
+#define LEVELOFDETAIL_H
+
+#include <vector>
+
+#include "utils/Bricking.h"
+
+namespace liv {
+
+    /**
+     * @brief Filter used to combine 2x2x2 voxels into one voxel of the next coarser level.
+     */
+    enum class DownsamplingFilter {
+        // average of the voxels, preserves the overall appearance
+        Box,
+        // maximum of the voxels, preserves thin high-valued structures
+        Max
+    };
+
+    /**
+     * @brief One level of a multiresolution pyramid, in the renderer format of the full-resolution volume.
+     */
+    struct VolumeLevel {
+        int dimensions[3];
+        std::vector<char> data;
+    };
+
+    /**
+     * @brief Build the coarser levels of a multiresolution pyramid.
+     *
+     * Each level halves the dimensions of the previous one, rounding up. Levels whose dimensions would all be 1
+     * are not generated. levels[0] is the first coarse level, the full-resolution volume itself is not copied.
+     *
+     * @param volume A pointer to the packed full-resolution volume in the renderer format.
+     * @param dimensions The dimensions of the volume.
+     * @param is16BitData Whether the data consists of 16-bit (or otherwise 8-bit) unsigned values.
+     * @param numLevels The maximum number of coarse levels to build.
+     * @param filter The filter used for downsampling.
+     * @param levels The levels to fill in. Existing buffers are reused.
+     */
+    void buildLevels(const char *volume, const int *dimensions, bool is16BitData, int numLevels,
+                     DownsamplingFilter filter, std::vector<VolumeLevel>& levels);
+
+    /**
+     * @brief Update the coarse levels of a pyramid after a region of the full-resolution volume changed.
+     *
+     * Only the voxels of each level that depend on the region are recomputed.
+     *
+     * @param volume A pointer to the packed full-resolution volume in the renderer format.
+     * @param dimensions The dimensions of the volume.
+     * @param is16BitData Whether the data consists of 16-bit (or otherwise 8-bit) unsigned values.
+     * @param region The region of the full-resolution volume that changed.
+     * @param filter The filter used for downsampling.
+     * @param levels The levels previously built by buildLevels.
+     */
+    void updateLevels(const char *volume, const int *dimensions, bool is16BitData, const Box& region,
+                      DownsamplingFilter filter, std::vector<VolumeLevel>& levels);
+}
+
+#endif //LEVELOFDETAIL_H
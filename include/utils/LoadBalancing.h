@@ -0,0 +1,75 @@
+/**
+ * @file LoadBalancing.h
+ * @brief This file contains the declarations of utilities for equalizing the render time of ranks by moving bricks
+ * between them.
+ */
+
+#ifndef LOADBALANCING_H
+#define LOADBALANCING_H
+
+#include <vector>
+
+namespace liv {
+
+    /**
+     * @brief Move of a brick from one rank to another.
+     */
+    struct BrickMigration {
+        int brick;
+        int from;
+        int to;
+    };
+
+    /**
+     * @brief Axis-aligned bounds of a brick.
+     */
+    struct BrickBounds {
+        float lower[3];
+        float upper[3];
+    };
+
+    /**
+     * @brief Sum the costs of the bricks owned by each rank.
+     *
+     * @param costs The cost of every brick, indexed by brick.
+     * @param owners The rank owning every brick, indexed by brick.
+     * @param numRanks The number of ranks.
+     * @return The load of every rank, indexed by rank.
+     */
+    std::vector<double> computeRankLoads(const std::vector<double>& costs, const std::vector<int>& owners, int numRanks);
+
+    /**
+     * @brief Plan which bricks to move so that the loads of the ranks become more even.
+     *
+     * Greedily moves the brick of the most loaded rank whose cost is closest to half the difference to the least
+     * loaded rank, until the most loaded rank is within the tolerance of the mean load, no move reduces the difference
+     * or maxMigrations bricks have been moved. The plan only depends on its inputs, so all ranks compute the same plan
+     * from the same gathered costs.
+     *
+     * With bounds given, a brick is only moved to a rank if the box enclosing the bricks of that rank afterwards
+     * overlaps no brick of another rank, so that the boxes of the ranks stay disjoint. If the least loaded rank cannot
+     * take any brick of the most loaded one, the next least loaded rank is tried.
+     *
+     * @param costs The cost of every brick, indexed by brick.
+     * @param owners The rank owning every brick, indexed by brick.
+     * @param numRanks The number of ranks.
+     * @param tolerance The allowed relative excess of the most loaded rank over the mean load.
+     * @param maxMigrations The maximum number of bricks to move.
+     * @param bounds The bounds of every brick, indexed by brick, or empty to move bricks regardless of their position.
+     * @return The moves in ascending order of brick, at most one per brick.
+     */
+    std::vector<BrickMigration> planBrickMigrations(const std::vector<double>& costs, const std::vector<int>& owners,
+                                                    int numRanks, double tolerance, int maxMigrations,
+                                                    const std::vector<BrickBounds>& bounds = {});
+
+    /**
+     * @brief Blend a new cost measurement into the previous estimate with an exponential moving average.
+     *
+     * @param previous The previous estimate, or a negative value if there is none.
+     * @param measured The new measurement.
+     * @param weight The weight of the new measurement in [0, 1].
+     */
+    double smoothCost(double previous, double measured, double weight);
+}
+
+#endif //LOADBALANCING_H
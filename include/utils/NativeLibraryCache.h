@@ -0,0 +1,76 @@
+/**
+ * @file NativeLibraryCache.h
+ * @brief This file contains the declarations of utilities for sharing the native libraries extracted by LWJGL
+ * between all ranks on a node.
+ */
+
+#ifndef NATIVELIBRARYCACHE_H
+#define NATIVELIBRARYCACHE_H
+
+#include <mpi.h>
+#include <cstdint>
+#include <string>
+
+namespace liv {
+
+    struct JVMConfiguration;
+
+    /**
+     * @brief Compute a fingerprint of the native library jars on the class path from their names, sizes and
+     * modification times.
+     *
+     * @param classPath The class path as a colon-separated list of files.
+     * @return The fingerprint, which changes whenever one of the jars is replaced.
+     */
+    uint64_t fingerprintNativeJars(const std::string& classPath);
+
+    /**
+     * @brief Get the node-local directory into which the native libraries of the given configuration are extracted.
+     *
+     * The directory name contains the fingerprint of the native jars, so that different versions of the renderer
+     * never share a directory.
+     */
+    std::string nativeLibraryDirectory(const JVMConfiguration& configuration);
+
+    /**
+     * @brief Check whether the directory contains a complete extraction, i.e. a manifest whose listed files all exist
+     * with matching sizes and checksums, and no files beyond them.
+     */
+    bool isNativeLibraryCacheValid(const std::string& directory);
+
+    /**
+     * @brief Check the cache on the first rank of the node communicator and broadcast the result. Creates the
+     * directory if it does not exist. Collective over nodeComm.
+     */
+    bool isNativeLibraryCacheValidOnNode(const std::string& directory, MPI_Comm nodeComm);
+
+    /**
+     * @brief Record the checksums of all files in the directory after extraction, marking the cache as valid.
+     *
+     * LWJGL extracts its libraries lazily while the renderer initializes, so this must not be called before the
+     * renderer is configured.
+     *
+     * @return false if the manifest could not be written.
+     */
+    bool writeNativeLibraryCacheManifest(const std::string& directory);
+
+    /**
+     * @brief Write the manifest on the first rank of the node communicator, which extracted the native libraries, and
+     * tell the other ranks whether it succeeded. They wait for this in waitForNativeLibraryCacheOnNode before starting
+     * their JVMs, so that they never extract into the directory themselves.
+     *
+     * The broadcast completes once the other ranks take part, so recorded receives the result and must stay valid
+     * until request is completed, e.g. with MPI_Wait before freeing nodeComm.
+     */
+    void recordNativeLibraryCacheOnNode(const std::string& directory, MPI_Comm nodeComm, int& recorded, MPI_Request& request);
+
+    /**
+     * @brief Wait on any rank of the node communicator but the first until the first has called
+     * recordNativeLibraryCacheOnNode.
+     *
+     * @return whether the native libraries were recorded.
+     */
+    bool waitForNativeLibraryCacheOnNode(MPI_Comm nodeComm);
+}
+
+#endif //NATIVELIBRARYCACHE_H
@@ -0,0 +1,95 @@
+/**
+ * @file ParallelUtils.h
+ * @brief This file contains helpers for splitting data-parallel work on volume buffers across threads.
+ */
+
+#ifndef PARALLELUTILS_H
+#define PARALLELUTILS_H
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdlib>
+#include <thread>
+#include <vector>
+
+namespace liv {
+
+    /**
+     * @brief Get the number of worker threads used by the native volume kernels.
+     *
+     * The value can be overridden with the environment variable LIV_NUM_THREADS, which is useful when several
+     * MPI ranks share a node. Otherwise, the hardware concurrency reported by the standard library is used.
+     *
+     * @return The number of worker threads, at least 1.
+     */
+    inline unsigned int getNumWorkerThreads() {
+        static const unsigned int numThreads = [] {
+            const char* value = std::getenv("LIV_NUM_THREADS");
+            if (value != nullptr && std::atoi(value) > 0) {
+                return static_cast<unsigned int>(std::atoi(value));
+            }
+            return std::max(1u, std::thread::hardware_concurrency());
+        }();
+        return numThreads;
+    }
+
+    /**
+     * @brief Run a function over the range [begin, end) split into contiguous chunks, one chunk per worker thread.
+     *
+     * The calling thread processes the first chunk itself. Ranges smaller than twice minChunk are processed
+     * serially on the calling thread, so that thread start-up costs are only paid for sufficiently large inputs.
+     *
+     * @param begin The first index of the range.
+     * @param end One past the last index of the range.
+     * @param fn A callable invoked as fn(chunkBegin, chunkEnd, chunkIndex).
+     * @param minChunk The minimum number of indices assigned to a single thread.
+     */
+    template <typename F>
+    void parallelFor(size_t begin, size_t end, F&& fn, size_t minChunk = 1 << 16) {
+        if (end <= begin) {
+            return;
+        }
+
+        const size_t count = end - begin;
+        const size_t numChunks = std::min<size_t>(getNumWorkerThreads(), std::max<size_t>(1, count / std::max<size_t>(1, minChunk)));
+
+        if (numChunks <= 1) {
+            fn(begin, end, size_t{0});
+            return;
+        }
+
+        const size_t chunkSize = (count + numChunks - 1) / numChunks;
+
+        std::vector<std::thread> workers;
+        workers.reserve(numChunks - 1);
+
+        for (size_t chunk = 1; chunk < numChunks; chunk++) {
+            const size_t chunkBegin = begin + chunk * chunkSize;
+            const size_t chunkEnd = std::min(end, chunkBegin + chunkSize);
+            if (chunkBegin >= chunkEnd) {
+                break;
+            }
+            workers.emplace_back([&fn, chunkBegin, chunkEnd, chunk] { fn(chunkBegin, chunkEnd, chunk); });
+        }
+
+        fn(begin, std::min(end, begin + chunkSize), size_t{0});
+
+        for (auto& worker : workers) {
+            worker.join();
+        }
+    }
+
+    /**
+     * @brief Get the number of chunks parallelFor will split a range of the given size into.
+     *
+     * Useful for preallocating per-chunk partial results, e.g. for reductions.
+     */
+    inline size_t getNumParallelChunks(size_t count, size_t minChunk = 1 << 16) {
+        if (count == 0) {
+            return 1;
+        }
+        return std::min<size_t>(getNumWorkerThreads(), std::max<size_t>(1, count / std::max<size_t>(1, minChunk)));
+    }
+}
+
+#endif //PARALLELUTILS_H
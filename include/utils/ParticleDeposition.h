@@ -0,0 +1,132 @@
+/**
+ * @file ParticleDeposition.h
+ * @brief This file contains the declarations of utilities for depositing particles onto the grid of a distributed
+ * volume, so that particle data can be rendered as a Volume<float>.
+ */
+
+#ifndef PARTICLEDEPOSITION_H
+#define PARTICLEDEPOSITION_H
+
+#include <mpi.h>
+#include <cstddef>
+#include <string>
+#include <vector>
+
+#include "utils/Bricking.h"
+
+namespace liv {
+
+    /**
+     * @brief Assignment function that spreads the weight of a particle over the cells around it.
+     */
+    enum class DepositionKernel {
+        // the whole weight goes to the cell containing the particle
+        NearestGridPoint,
+        // linear weights over the 2x2x2 cells whose centers surround the particle
+        CloudInCell,
+        // quadratic weights over the 3x3x3 cells around the cell containing the particle
+        TriangularShapedCloud
+    };
+
+    /**
+     * @brief Parse a kernel name, one of "ngp", "cic" or "tsc".
+     *
+     * @return false if the name is unknown, leaving kernel unchanged.
+     */
+    bool depositionKernelFromString(const std::string& name, DepositionKernel& kernel);
+
+    /**
+     * @brief Get the number of cells a kernel reaches beyond the cell containing a particle, along each axis.
+     */
+    int depositionGhostWidth(DepositionKernel kernel);
+
+    /**
+     * @brief The cells of a rank, as part of a global grid of cells.
+     *
+     * Cell (i, j, k) of the global grid covers [origin + (i, j, k) * cellSize, origin + (i + 1, j + 1, k + 1) *
+     * cellSize), and its value is located at the center of the cell.
+     */
+    struct DepositionGrid {
+        // the cells of this rank, in global cell coordinates
+        Box box;
+        // world position of the lower corner of global cell (0, 0, 0)
+        float origin[3];
+        float cellSize[3];
+    };
+
+    /**
+     * @brief Deposit particles onto the cells of a grid and a ghost layer around them.
+     *
+     * The result covers the box of the grid grown by depositionGhostWidth(kernel) cells on every side, in x-fastest
+     * order, and holds the summed weight per cell. Contributions that fall outside of it are dropped. Particles are
+     * split across the worker threads, each depositing into a private grid, and the private grids are summed
+     * afterwards. Fewer threads are used when there are few particles per cell, to bound the memory of the private
+     * grids.
+     *
+     * @param positions x, y and z of each particle in world coordinates.
+     * @param weights The weight, e.g. the mass, of each particle, or nullptr for a weight of 1.
+     * @param numParticles The number of particles.
+     * @param padded Receives the padded grid, resized as needed.
+     */
+    void depositParticles(const float *positions, const float *weights, size_t numParticles,
+                          const DepositionGrid& grid, DepositionKernel kernel, std::vector<float>& padded);
+
+    /**
+     * @brief Deposits the particles of all ranks of a communicator into their bricks.
+     *
+     * Particles near the boundary of a rank's box also contribute to the cells of neighbouring ranks. These
+     * contributions are deposited into the ghost layer and sent to the ranks owning the cells, so that the bricks
+     * of all ranks together equal a deposition of all particles onto the global grid. The boxes of all ranks must
+     * not overlap. The neighbours of a rank are found once, when constructing.
+     *
+     * The brick is meant to be passed to Volume<float>::update, which quantizes it into a staging buffer, so it can be
+     * overwritten by the next deposit.
+     */
+    class ParticleDeposition {
+        // a box of cells exchanged with another rank, in the coordinates of the padded grid of this rank
+        struct Exchange {
+            int rank;
+            Box box;
+            std::vector<float> buffer;
+        };
+
+        DepositionGrid grid;
+        DepositionKernel kernel;
+        MPI_Comm comm;
+        int ghost;
+        std::vector<Exchange> sends;
+        std::vector<Exchange> receives;
+        std::vector<float> padded;
+        std::vector<float> brick;
+
+        static constexpr int depositionTag = 7402;
+
+    public:
+        /**
+         * Gather the boxes of all ranks and find the neighbours of this rank. Collective over comm.
+         */
+        ParticleDeposition(const DepositionGrid& grid, DepositionKernel kernel, MPI_Comm comm);
+
+        /**
+         * @brief Deposit the particles of this rank and add the contributions of neighbouring ranks. Collective over
+         * comm.
+         *
+         * @return false if exchanging contributions with a neighbour failed.
+         */
+        bool deposit(const float *positions, const float *weights, size_t numParticles);
+
+        /**
+         * @brief Get the summed weight of the cells of this rank after deposit, box.extent cells in x-fastest order.
+         */
+        [[nodiscard]] std::vector<float>& getBrick() { return brick; }
+
+        [[nodiscard]] const DepositionGrid& getGrid() const { return grid; }
+
+        /**
+         * @brief Get the ranks this rank exchanges contributions with.
+         */
+        [[nodiscard]] std::vector<int> getNeighbours() const;
+    };
+}
+
+#endif //PARTICLEDEPOSITION_H
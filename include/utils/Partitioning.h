@@ -0,0 +1,87 @@
+/**
+ * @file Partitioning.h
+ * @brief This file contains the declarations of utilities for assigning the bricks of a volume to ranks along a
+ * space-filling curve.
+ */
+
+#ifndef PARTITIONING_H
+#define PARTITIONING_H
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+namespace liv {
+
+    /**
+     * @brief Space-filling curve along which bricks are ordered.
+     */
+    enum class CurveType {
+        // bit interleaving of the brick coordinates, cheap but with jumps between octants
+        Morton,
+        // every step moves to a face neighbour, which keeps the segments of the curve more compact
+        Hilbert
+    };
+
+    /**
+     * @brief Parse "morton" or "hilbert".
+     *
+     * @return false if the name is neither.
+     */
+    bool curveTypeFromString(const std::string& name, CurveType& type);
+
+    /**
+     * @brief Get the position of a cell on the Morton curve, with x in the least significant bit of every triple.
+     *
+     * Coordinates must be below 2^21.
+     */
+    uint64_t mortonIndex(uint32_t x, uint32_t y, uint32_t z);
+
+    /**
+     * @brief Get the position of a cell on the Hilbert curve through a cube of 2^bits cells along each axis.
+     *
+     * Uses Skilling's transposition algorithm. bits must be at most 21.
+     */
+    uint64_t hilbertIndex(uint32_t x, uint32_t y, uint32_t z, int bits);
+
+    /**
+     * @brief Get the indices of all cells of a grid in the order of the given curve.
+     *
+     * Cells are indexed in x-fastest order, as the bricks of a BrickGrid or the blocks of computeBlockGrid. Grids
+     * whose sides are not equal powers of two are ordered along the curve through the enclosing cube.
+     */
+    std::vector<int> curveOrder(const int *gridCounts, CurveType type);
+
+    /**
+     * @brief Split a sequence of cells into contiguous segments of similar weight, one per part.
+     *
+     * Every part receives at least one cell if there are at least as many cells as parts.
+     *
+     * @param order The cells in the order in which they are split.
+     * @param weights The weight of every cell, indexed by cell. All cells weigh the same if empty.
+     * @param numParts The number of parts.
+     * @return The part of every cell, indexed by cell.
+     */
+    std::vector<int> partitionAlongCurve(const std::vector<int>& order, const std::vector<double>& weights, int numParts);
+
+    /**
+     * @brief Assign the cells of a grid to ranks in contiguous segments of the given curve.
+     *
+     * Ranks with consecutive numbers receive neighbouring segments, so that the ranks of a node hold neighbouring
+     * bricks when ranks are numbered by node.
+     *
+     * @return The rank of every cell, indexed by cell.
+     */
+    std::vector<int> assignAlongCurve(const int *gridCounts, int numRanks, CurveType type,
+                                      const std::vector<double>& weights = {});
+
+    /**
+     * @brief Count the voxels with values above zero.
+     *
+     * @param data The voxels, as 16-bit or otherwise 8-bit unsigned values.
+     */
+    size_t countNonEmptyVoxels(const char *data, size_t numVoxels, bool is16BitData);
+}
+
+#endif //PARTITIONING_H
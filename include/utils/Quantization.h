@@ -0,0 +1,75 @@
+/**
+ * @file Quantization.h
+ * @brief This file contains the declarations of kernels for converting floating-point volume data to the
+ * 8- and 16-bit integer formats supported by the renderer.
+ */
+
+#ifndef QUANTIZATION_H
+#define QUANTIZATION_H
+
+#include <cstddef>
+#include <cstdint>
+
+namespace liv {
+
+    /**
+     * @brief IEEE 754 half-precision value, stored as its raw bit pattern.
+     *
+     * Only used as a storage type for volume data. Arithmetic is performed after conversion to float.
+     */
+    struct half {
+        uint16_t bits;
+    };
+
+    /**
+     * @brief Convert a half-precision value to single precision.
+     *
+     * Handles zeros, subnormals, infinities and NaNs.
+     */
+    float halfToFloat(half value);
+
+    /**
+     * @brief Closed interval of data values that is mapped onto the full range of the quantized type.
+     */
+    struct ValueRange {
+        double min;
+        double max;
+    };
+
+    /**
+     * @brief Compute the minimum and maximum of the given values, ignoring NaNs and infinities.
+     *
+     * The computation is split across the worker threads (see getNumWorkerThreads). If no value is finite or
+     * count is 0, the returned range has min > max.
+     *
+     * @param data A pointer to the values.
+     * @param count The number of values.
+     * @param stride The distance between consecutive values in elements, e.g. the number of fields of interleaved data.
+     * @return The range of the values.
+     */
+    ValueRange computeValueRange(const float *data, size_t count, size_t stride = 1);
+    ValueRange computeValueRange(const double *data, size_t count, size_t stride = 1);
+    ValueRange computeValueRange(const half *data, size_t count, size_t stride = 1);
+
+    /**
+     * @brief Linearly map values from the given range onto [0, 255] or [0, 65535] and round to the nearest integer.
+     *
+     * Values outside the range are clamped, NaNs are mapped to 0. If the range is empty, all values are mapped to 0.
+     * The conversion is split across the worker threads.
+     *
+     * @param src A pointer to the source values.
+     * @param count The number of values to convert.
+     * @param range The range of source values mapped onto the full range of the destination type.
+     * @param dst A pointer to the destination buffer, which must hold at least count values.
+     * @param stride The distance between consecutive source values in elements. Strided values are gathered in
+     * batches, so deinterleaving and conversion happen in a single pass over the source.
+     */
+    void quantize(const float *src, size_t count, const ValueRange& range, char *dst, size_t stride = 1);
+    void quantize(const float *src, size_t count, const ValueRange& range, unsigned short *dst, size_t stride = 1);
+    void quantize(const double *src, size_t count, const ValueRange& range, char *dst, size_t stride = 1);
+    void quantize(const double *src, size_t count, const ValueRange& range, unsigned short *dst, size_t stride = 1);
+    void quantize(const half *src, size_t count, const ValueRange& range, char *dst, size_t stride = 1);
+    void quantize(const half *src, size_t count, const ValueRange& range, unsigned short *dst, size_t stride = 1);
+}
+
+#endif //QUANTIZATION_H
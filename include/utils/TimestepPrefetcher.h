@@ -0,0 +1,104 @@
+/**
+ * @file TimestepPrefetcher.h
+ * @brief This file contains the declarations of a background reader that loads the timesteps of a time series ahead
+ * of their use.
+ */
+
+#ifndef TIMESTEPPREFETCHER_H
+#define TIMESTEPPREFETCHER_H
+
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace liv {
+
+    /**
+     * @brief A timestep handed out by a TimestepPrefetcher.
+     */
+    struct PrefetchedTimestep {
+        int step = -1;
+        char *data = nullptr;
+        size_t size = 0;
+        // time the loader took to read the step
+        double readSeconds = 0.0;
+        // time next() waited for the step, zero if it had been read ahead
+        double waitSeconds = 0.0;
+        int slot = -1;
+    };
+
+    /**
+     * @brief Reads timesteps on a background thread while earlier timesteps are in use.
+     *
+     * Up to depth steps are read ahead into a pool of depth + 2 buffers, so that a step handed out stays valid while
+     * the next one is handed out and passed to the renderer. Every step must be given back with release once it is
+     * no longer used, or reading ahead stops when the pool is exhausted.
+     */
+    class TimestepPrefetcher {
+    public:
+        /**
+         * Reads the given step into the buffer, resizing it as needed. Returns false on failure.
+         */
+        using Loader = std::function<bool(int step, std::vector<char>& data)>;
+
+    private:
+        struct Slot {
+            std::vector<char> data;
+            int step = -1;
+            double readSeconds = 0.0;
+        };
+
+        Loader loader;
+        int numSteps;
+        int handedOut = 0;
+        std::vector<Slot> slots;
+        std::deque<int> freeSlots;
+        std::deque<int> readySlots;
+        bool failed = false;
+        bool stopping = false;
+        std::mutex mutex;
+        std::condition_variable changed;
+        std::thread reader;
+
+        void read();
+
+    public:
+        /**
+         * @param loader Reads a step, called on the background thread in ascending step order.
+         * @param numSteps The number of steps, read from 0 to numSteps - 1.
+         * @param depth The number of steps read ahead, at least 1.
+         */
+        TimestepPrefetcher(Loader loader, int numSteps, int depth = 2);
+
+        TimestepPrefetcher(const TimestepPrefetcher&) = delete;
+
+        TimestepPrefetcher& operator=(const TimestepPrefetcher&) = delete;
+
+        ~TimestepPrefetcher();
+
+        /**
+         * @brief Wait for the next step.
+         *
+         * @return false once all steps have been handed out, or if the loader failed.
+         */
+        bool next(PrefetchedTimestep& timestep);
+
+        /**
+         * @brief Give the buffer of a step back for reading further steps.
+         */
+        void release(const PrefetchedTimestep& timestep);
+    };
+
+    /**
+     * @brief List the regular files in a directory with the given extension, sorted by name.
+     *
+     * Timesteps are expected to be named so that their names sort in time order, e.g. with zero-padded numbers.
+     */
+    std::vector<std::string> listTimestepFiles(const std::string& directory, const std::string& extension);
+}
+
+#endif //TIMESTEPPREFETCHER_H
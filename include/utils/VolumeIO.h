@@ -0,0 +1,133 @@
+/**
+ * @file VolumeIO.h
+ * @brief This file contains the declarations of utilities for decomposing a volume stored as a single raw file into
+ * blocks and reading the blocks of all ranks in parallel.
+ */
+
+#ifndef VOLUMEIO_H
+#define VOLUMEIO_H
+
+#include <mpi.h>
+#include <string>
+#include <vector>
+
+#include "utils/Bricking.h"
+
+namespace liv {
+
+    /**
+     * @brief Dimensions and bit resolution of a raw volume, as stored in its .info file.
+     */
+    struct VolumeDescription {
+        int dimensions[3];
+        int bitResolution;
+
+        [[nodiscard]] size_t elementSize() const {
+            return static_cast<size_t>(bitResolution / 8);
+        }
+    };
+
+    /**
+     * @brief A block of a volume, together with its place in the whole volume.
+     */
+    struct VolumeBlock {
+        VolumeDescription volume;
+        Box box;
+        std::vector<char> data;
+    };
+
+    /**
+     * @brief Access hints for mapping a block file.
+     */
+    struct MappingOptions {
+        // fault in all pages when mapping, instead of on first access
+        bool populate = false;
+        // tell the kernel that the pages are accessed in order, so that it reads ahead aggressively
+        bool sequential = true;
+        // ask for transparent huge pages, which only has an effect where the file system supports them
+        bool hugePages = true;
+    };
+
+    /**
+     * @brief A raw block file mapped into memory, as a replacement for reading it into a buffer.
+     *
+     * The file is mapped privately with write access, so that data() can be handed to Volume<T>::update directly.
+     * Pages are read from the page cache on access and never copied into a second buffer, and writes are not
+     * carried through to the file. The mapping must outlive the volume it is passed to, as any other volume buffer.
+     */
+    class MappedFile {
+        char *address = nullptr;
+        size_t length = 0;
+
+    public:
+        MappedFile() = default;
+
+        MappedFile(const MappedFile&) = delete;
+
+        MappedFile& operator=(const MappedFile&) = delete;
+
+        MappedFile(MappedFile&& other) noexcept;
+
+        MappedFile& operator=(MappedFile&& other) noexcept;
+
+        ~MappedFile();
+
+        /**
+         * @brief Map the whole file, replacing any previous mapping.
+         *
+         * @return false if the file cannot be opened or mapped.
+         */
+        bool open(const std::string& path, const MappingOptions& options = {});
+
+        void close();
+
+        [[nodiscard]] char *data() const { return address; }
+
+        [[nodiscard]] size_t size() const { return length; }
+    };
+
+    /**
+     * @brief Read a .info file containing the dimensions of a volume followed by its bit resolution.
+     *
+     * @return false if the file cannot be read or the bit resolution is neither 8 nor 16.
+     */
+    bool readVolumeDescription(const std::string& infoFilePath, VolumeDescription& description);
+
+    /**
+     * @brief Get the path of the .info file belonging to a .raw file.
+     */
+    std::string volumeInfoPath(const std::string& rawFilePath);
+
+    /**
+     * @brief Choose the number of blocks along x, y and z for the given total, as close to a cube as possible.
+     */
+    void computeBlockGrid(int numBlocks, int * grid);
+
+    /**
+     * @brief Get the box of voxels covered by a block of a regular decomposition.
+     *
+     * Blocks are numbered in x-fastest order. Voxels that do not divide evenly go to the first blocks along each axis.
+     * This matches the decomposition written by volume_divider.
+     */
+    Box blockBox(const int * volumeDimensions, const int * grid, int blockIndex);
+
+    /**
+     * @brief Read a box of a raw volume file collectively with MPI-IO.
+     *
+     * Every rank of comm reads its own box through a subarray file view with MPI_File_read_all, which lets the MPI
+     * library aggregate the accesses of all ranks with collective buffering. Collective over comm.
+     *
+     * @return false on all ranks if the file could not be opened, or on the ranks whose read failed.
+     */
+    bool readVolumeBox(const std::string& rawFilePath, const VolumeDescription& description, const Box& box,
+                       MPI_Comm comm, std::vector<char>& data);
+
+    /**
+     * @brief Decompose a raw volume into one block per rank of comm and read the block of this rank.
+     *
+     * The volume is described by the .info file next to the .raw file. Collective over comm.
+     */
+    bool loadVolumeBlock(const std::string& rawFilePath, MPI_Comm comm, VolumeBlock& block);
+}
+
+#endif //VOLUMEIO_H
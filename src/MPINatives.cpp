@@ -10,7 +10,11 @@
 #include <algorithm>
 #include <chrono>
 
-MPI_Comm visualizationComm = MPI_COMM_WORLD; //TODO: Change this to the actual communicator
+MPI_Comm visualizationComm = MPI_COMM_WORLD;
+
+void setVisualizationCommunicator(MPI_Comm comm) {
+    visualizationComm = comm;
+}
 
 void compositePlaceholder(JNIEnv *e, jobject clazzObject, jobject subImage, jint myRank, jint commSize, jfloatArray camPos, jlong imagePointer) {
     std::cout << "In the composite placeholder function." << std::endl;
@@ -118,6 +118,44 @@ namespace liv {
         jvmData->jvm->DetachCurrentThread();
     }
 
+    void RenderingManager::addProcessorDataBatch(const std::vector<int>& processorIDs, const std::vector<float>& origins,
+                                                 const std::vector<float>& dimensions) {
+        if (origins.size() != 3 * processorIDs.size() || dimensions.size() != 3 * processorIDs.size()) {
+            std::cerr << "ERROR: Origins and dimensions must contain exactly 3 elements per processor." << std::endl;
+            return;
+        }
+
+        JNIEnv *env;
+        jvmData->jvm->AttachCurrentThread(reinterpret_cast<void **>(&env), NULL);
+
+        jmethodID addProcessorDataBatchMethod = findJvmMethod(env, jvmData->clazz, "addProcessorDataBatch", "([I[F[F)V");
+
+        const auto numProcessors = static_cast<jsize>(processorIDs.size());
+
+        jintArray jIDs = env->NewIntArray(numProcessors);
+        env->SetIntArrayRegion(jIDs, 0, numProcessors, processorIDs.data());
+
+        jfloatArray jOrigins = env->NewFloatArray(3 * numProcessors);
+        env->SetFloatArrayRegion(jOrigins, 0, 3 * numProcessors, origins.data());
+
+        jfloatArray jDimensions = env->NewFloatArray(3 * numProcessors);
+        env->SetFloatArrayRegion(jDimensions, 0, 3 * numProcessors, dimensions.data());
+
+        env->CallVoidMethod(jvmData->obj, addProcessorDataBatchMethod, jIDs, jOrigins, jDimensions);
+
+        if (env->ExceptionOccurred()) {
+            std::cerr << "ERROR in calling addProcessorDataBatch!" << std::endl;
+            env->ExceptionDescribe();
+            env->ExceptionClear();
+        }
+
+        env->DeleteLocalRef(jIDs);
+        env->DeleteLocalRef(jOrigins);
+        env->DeleteLocalRef(jDimensions);
+
+        jvmData->jvm->DetachCurrentThread();
+    }
+
     void RenderingManager::addVolume(int volumeID, const std::vector<int>& dimensions, const std::vector<float>& position, bool is16BitData) {
         if (dimensions.size() != 3 || position.size() != 3) {
             std::cerr << "ERROR: Dimensions and position vectors must contain exactly 3 elements." << std::endl;
@@ -170,6 +208,289 @@ namespace liv {
         jvmData->jvm->DetachCurrentThread();
     }
 
+    void RenderingManager::addVolumes(const std::vector<int>& volumeIDs, const std::vector<int>& dimensions,
+                                      const std::vector<float>& positions, bool is16BitData) {
+        if (dimensions.size() != 3 * volumeIDs.size() || positions.size() != 3 * volumeIDs.size()) {
+            std::cerr << "ERROR: Dimensions and positions must contain exactly 3 elements per volume." << std::endl;
+            return;
+        }
+
+        JNIEnv *env;
+        jvmData->jvm->AttachCurrentThread(reinterpret_cast<void **>(&env), NULL);
+
+        jclass superClass = env->GetSuperclass(jvmData->clazz);
+        jmethodID addVolumesMethod = findJvmMethod(env, superClass, "addVolumes", "([I[I[FZ)V");
+
+        const auto numVolumes = static_cast<jsize>(volumeIDs.size());
+
+        jintArray jIDs = env->NewIntArray(numVolumes);
+        jintArray jdims = env->NewIntArray(3 * numVolumes);
+        jfloatArray jpos = env->NewFloatArray(3 * numVolumes);
+
+        env->SetIntArrayRegion(jIDs, 0, numVolumes, volumeIDs.data());
+        env->SetIntArrayRegion(jdims, 0, 3 * numVolumes, dimensions.data());
+        env->SetFloatArrayRegion(jpos, 0, 3 * numVolumes, positions.data());
+
+        env->CallVoidMethod(jvmData->obj, addVolumesMethod, jIDs, jdims, jpos, is16BitData);
+
+        if (env->ExceptionOccurred()) {
+            std::cerr << "ERROR in calling addVolumes!" << std::endl;
+            env->ExceptionDescribe();
+            env->ExceptionClear();
+        }
+
+        env->DeleteLocalRef(jIDs);
+        env->DeleteLocalRef(jdims);
+        env->DeleteLocalRef(jpos);
+
+        jvmData->jvm->DetachCurrentThread();
+    }
+
+    void RenderingManager::updateVolumes(const std::vector<int>& volumeIDs, const std::vector<char *>& volumeBuffers,
+                                         const std::vector<long>& bufferSizes) {
+        if (volumeBuffers.size() != volumeIDs.size() || bufferSizes.size() != volumeIDs.size()) {
+            std::cerr << "ERROR: Every volume needs exactly one buffer and buffer size." << std::endl;
+            return;
+        }
+
+        JNIEnv *env;
+        jvmData->jvm->AttachCurrentThread(reinterpret_cast<void **>(&env), NULL);
+
+        jclass superClass = env->GetSuperclass(jvmData->clazz);
+        jmethodID updateVolumesMethod = findJvmMethod(env, superClass, "updateVolumes", "([I[Ljava/nio/ByteBuffer;)V");
+
+        const auto numVolumes = static_cast<jsize>(volumeIDs.size());
+
+        jintArray jIDs = env->NewIntArray(numVolumes);
+        env->SetIntArrayRegion(jIDs, 0, numVolumes, volumeIDs.data());
+
+        jclass byteBufferClass = env->FindClass("java/nio/ByteBuffer");
+        jobjectArray jbuffers = env->NewObjectArray(numVolumes, byteBufferClass, nullptr);
+        for (jsize volume = 0; volume < numVolumes; volume++) {
+            jobject jbuffer = env->NewDirectByteBuffer(volumeBuffers[volume], bufferSizes[volume]);
+            env->SetObjectArrayElement(jbuffers, volume, jbuffer);
+            env->DeleteLocalRef(jbuffer);
+        }
+
+        env->CallVoidMethod(jvmData->obj, updateVolumesMethod, jIDs, jbuffers);
+
+        if (env->ExceptionOccurred()) {
+            std::cerr << "ERROR in calling updateVolumes!" << std::endl;
+            env->ExceptionDescribe();
+            env->ExceptionClear();
+        }
+
+        env->DeleteLocalRef(jIDs);
+        env->DeleteLocalRef(jbuffers);
+        env->DeleteLocalRef(byteBufferClass);
+
+        jvmData->jvm->DetachCurrentThread();
+    }
+
+    void RenderingManager::addVolumeFields(int volumeID, const std::vector<int>& dimensions, const std::vector<float>& position,
+                                           bool is16BitData, const std::vector<std::string>& fieldNames) {
+        if (dimensions.size() != 3 || position.size() != 3) {
+            std::cerr << "ERROR: Dimensions and position vectors must contain exactly 3 elements." << std::endl;
+            return;
+        }
+
+        JNIEnv *env;
+        jvmData->jvm->AttachCurrentThread(reinterpret_cast<void **>(&env), NULL);
+
+        jclass superClass = env->GetSuperclass(jvmData->clazz);
+        jmethodID addVolumeFieldsMethod = findJvmMethod(env, superClass, "addVolumeFields", "(I[I[FZ[Ljava/lang/String;)V");
+
+        jintArray jdims = env->NewIntArray(3);
+        jfloatArray jpos = env->NewFloatArray(3);
+
+        env->SetIntArrayRegion(jdims, 0, 3, dimensions.data());
+        env->SetFloatArrayRegion(jpos, 0, 3, position.data());
+
+        const auto numFields = static_cast<jsize>(fieldNames.size());
+        jclass stringClass = env->FindClass("java/lang/String");
+        jobjectArray jnames = env->NewObjectArray(numFields, stringClass, nullptr);
+        for (jsize field = 0; field < numFields; field++) {
+            jstring jname = env->NewStringUTF(fieldNames[field].c_str());
+            env->SetObjectArrayElement(jnames, field, jname);
+            env->DeleteLocalRef(jname);
+        }
+
+        env->CallVoidMethod(jvmData->obj, addVolumeFieldsMethod, volumeID, jdims, jpos, is16BitData, jnames);
+
+        if (env->ExceptionOccurred()) {
+            std::cerr << "ERROR in calling addVolumeFields!" << std::endl;
+            env->ExceptionDescribe();
+            env->ExceptionClear();
+        }
+
+        env->DeleteLocalRef(jdims);
+        env->DeleteLocalRef(jpos);
+        env->DeleteLocalRef(jnames);
+        env->DeleteLocalRef(stringClass);
+
+        jvmData->jvm->DetachCurrentThread();
+    }
+
+    void RenderingManager::updateVolumeFields(int volumeID, const std::vector<char *>& fieldBuffers, const std::vector<long>& bufferSizes) {
+        if (fieldBuffers.size() != bufferSizes.size()) {
+            std::cerr << "ERROR: Every field buffer needs a buffer size." << std::endl;
+            return;
+        }
+
+        JNIEnv *env;
+        jvmData->jvm->AttachCurrentThread(reinterpret_cast<void **>(&env), NULL);
+
+        jclass superClass = env->GetSuperclass(jvmData->clazz);
+        jmethodID updateVolumeFieldsMethod = findJvmMethod(env, superClass, "updateVolumeFields", "(I[Ljava/nio/ByteBuffer;)V");
+
+        const auto numFields = static_cast<jsize>(fieldBuffers.size());
+        jclass byteBufferClass = env->FindClass("java/nio/ByteBuffer");
+        jobjectArray jbuffers = env->NewObjectArray(numFields, byteBufferClass, nullptr);
+        for (jsize field = 0; field < numFields; field++) {
+            jobject jbuffer = env->NewDirectByteBuffer(fieldBuffers[field], bufferSizes[field]);
+            env->SetObjectArrayElement(jbuffers, field, jbuffer);
+            env->DeleteLocalRef(jbuffer);
+        }
+
+        env->CallVoidMethod(jvmData->obj, updateVolumeFieldsMethod, volumeID, jbuffers);
+
+        if (env->ExceptionOccurred()) {
+            std::cerr << "ERROR in calling updateVolumeFields!" << std::endl;
+            env->ExceptionDescribe();
+            env->ExceptionClear();
+        }
+
+        env->DeleteLocalRef(jbuffers);
+        env->DeleteLocalRef(byteBufferClass);
+
+        jvmData->jvm->DetachCurrentThread();
+    }
+
+    void RenderingManager::setActiveVolumeField(int volumeID, int field) {
+        JNIEnv *env;
+        jvmData->jvm->AttachCurrentThread(reinterpret_cast<void **>(&env), NULL);
+
+        jclass superClass = env->GetSuperclass(jvmData->clazz);
+        jmethodID setActiveFieldMethod = findJvmMethod(env, superClass, "setActiveVolumeField", "(II)V");
+
+        invokeVoidJvmMethod(env, jvmData->obj, setActiveFieldMethod, volumeID, field);
+
+        jvmData->jvm->DetachCurrentThread();
+    }
+
+    void RenderingManager::updateVolumeBricks(int volumeID, const std::vector<int>& offsets, const std::vector<int>& extents,
+                                              char *brickBuffer, long bufferSize) {
+        if (offsets.size() != extents.size() || offsets.size() % 3 != 0) {
+            std::cerr << "ERROR: Brick offsets and extents must contain 3 elements per brick." << std::endl;
+            return;
+        }
+
+        JNIEnv *env;
+        jvmData->jvm->AttachCurrentThread(reinterpret_cast<void **>(&env), NULL);
+
+        jclass superClass = env->GetSuperclass(jvmData->clazz);
+        jmethodID updateVolumeBricksMethod = findJvmMethod(env, superClass, "updateVolumeBricks", "(I[I[ILjava/nio/ByteBuffer;)V");
+
+        const auto numValues = static_cast<jsize>(offsets.size());
+
+        jintArray jOffsets = env->NewIntArray(numValues);
+        jintArray jExtents = env->NewIntArray(numValues);
+        env->SetIntArrayRegion(jOffsets, 0, numValues, offsets.data());
+        env->SetIntArrayRegion(jExtents, 0, numValues, extents.data());
+
+        jobject jbuffer = env->NewDirectByteBuffer(brickBuffer, bufferSize);
+        env->CallVoidMethod(jvmData->obj, updateVolumeBricksMethod, volumeID, jOffsets, jExtents, jbuffer);
+
+        if (env->ExceptionOccurred()) {
+            std::cerr << "ERROR in calling updateVolumeBricks!" << std::endl;
+            env->ExceptionDescribe();
+            env->ExceptionClear();
+        }
+
+        env->DeleteLocalRef(jOffsets);
+        env->DeleteLocalRef(jExtents);
+        env->DeleteLocalRef(jbuffer);
+
+        jvmData->jvm->DetachCurrentThread();
+    }
+
+    void RenderingManager::updateBrickStatistics(int volumeID, const std::vector<int>& brickSize, const std::vector<int>& minMax,
+                                                 const std::vector<int>& histogram) {
+        if (brickSize.size() != 3) {
+            std::cerr << "ERROR: Brick size vector must contain exactly 3 elements." << std::endl;
+            return;
+        }
+
+        JNIEnv *env;
+        jvmData->jvm->AttachCurrentThread(reinterpret_cast<void **>(&env), NULL);
+
+        jclass superClass = env->GetSuperclass(jvmData->clazz);
+        jmethodID updateStatisticsMethod = findJvmMethod(env, superClass, "updateVolumeBrickStatistics", "(I[I[I[I)V");
+
+        jintArray jBrickSize = env->NewIntArray(3);
+        jintArray jMinMax = env->NewIntArray(static_cast<jsize>(minMax.size()));
+        jintArray jHistogram = env->NewIntArray(static_cast<jsize>(histogram.size()));
+
+        env->SetIntArrayRegion(jBrickSize, 0, 3, brickSize.data());
+        env->SetIntArrayRegion(jMinMax, 0, static_cast<jsize>(minMax.size()), minMax.data());
+        env->SetIntArrayRegion(jHistogram, 0, static_cast<jsize>(histogram.size()), histogram.data());
+
+        env->CallVoidMethod(jvmData->obj, updateStatisticsMethod, volumeID, jBrickSize, jMinMax, jHistogram);
+
+        if (env->ExceptionOccurred()) {
+            std::cerr << "ERROR in calling updateVolumeBrickStatistics!" << std::endl;
+            env->ExceptionDescribe();
+            env->ExceptionClear();
+        }
+
+        env->DeleteLocalRef(jBrickSize);
+        env->DeleteLocalRef(jMinMax);
+        env->DeleteLocalRef(jHistogram);
+
+        jvmData->jvm->DetachCurrentThread();
+    }
+
+    void RenderingManager::updateVolumeLevels(int volumeID, const std::vector<int>& dimensions, const std::vector<char *>& levelBuffers,
+                                              const std::vector<long>& bufferSizes) {
+        if (dimensions.size() != 3 * levelBuffers.size() || levelBuffers.size() != bufferSizes.size()) {
+            std::cerr << "ERROR: Level dimensions must contain 3 elements per level, and every level needs a buffer size." << std::endl;
+            return;
+        }
+
+        JNIEnv *env;
+        jvmData->jvm->AttachCurrentThread(reinterpret_cast<void **>(&env), NULL);
+
+        jclass superClass = env->GetSuperclass(jvmData->clazz);
+        jmethodID updateLevelsMethod = findJvmMethod(env, superClass, "updateVolumeLevels", "(I[I[Ljava/nio/ByteBuffer;)V");
+
+        const auto numLevels = static_cast<jsize>(levelBuffers.size());
+
+        jintArray jDimensions = env->NewIntArray(3 * numLevels);
+        env->SetIntArrayRegion(jDimensions, 0, 3 * numLevels, dimensions.data());
+
+        jclass byteBufferClass = env->FindClass("java/nio/ByteBuffer");
+        jobjectArray jLevels = env->NewObjectArray(numLevels, byteBufferClass, nullptr);
+        for (jsize level = 0; level < numLevels; level++) {
+            jobject jbuffer = env->NewDirectByteBuffer(levelBuffers[level], bufferSizes[level]);
+            env->SetObjectArrayElement(jLevels, level, jbuffer);
+            env->DeleteLocalRef(jbuffer);
+        }
+
+        env->CallVoidMethod(jvmData->obj, updateLevelsMethod, volumeID, jDimensions, jLevels);
+
+        if (env->ExceptionOccurred()) {
+            std::cerr << "ERROR in calling updateVolumeLevels!" << std::endl;
+            env->ExceptionDescribe();
+            env->ExceptionClear();
+        }
+
+        env->DeleteLocalRef(jDimensions);
+        env->DeleteLocalRef(jLevels);
+        env->DeleteLocalRef(byteBufferClass);
+
+        jvmData->jvm->DetachCurrentThread();
+    }
+
 
     void RenderingManager::setSceneConfigured() {
         JNIEnv *env;
@@ -192,6 +513,56 @@ namespace liv {
         jvmData->jvm->DetachCurrentThread();
     }
 
+    void RenderingManager::removeVolume(int volumeID) {
+        JNIEnv *env;
+        jvmData->jvm->AttachCurrentThread(reinterpret_cast<void **>(&env), NULL);
+
+        jclass superClass = env->GetSuperclass(jvmData->clazz);
+        jmethodID removeVolumeMethod = findJvmMethod(env, superClass, "removeVolume", "(I)V");
+
+        invokeVoidJvmMethod(env, jvmData->obj, removeVolumeMethod, volumeID);
+
+        jvmData->jvm->DetachCurrentThread();
+    }
+
+    std::vector<float> RenderingManager::getVolumeRenderTimes(const std::vector<int>& volumeIDs) {
+        JNIEnv *env;
+        jvmData->jvm->AttachCurrentThread(reinterpret_cast<void **>(&env), NULL);
+
+        std::vector<float> times;
+
+        jclass superClass = env->GetSuperclass(jvmData->clazz);
+        jmethodID getRenderTimesMethod = findJvmMethod(env, superClass, "getVolumeRenderTimes", "([I)[F");
+        if (getRenderTimesMethod == nullptr) {
+            // older renderers do not measure per-volume times
+            env->ExceptionClear();
+            jvmData->jvm->DetachCurrentThread();
+            return times;
+        }
+
+        const auto numVolumes = static_cast<jsize>(volumeIDs.size());
+        jintArray jVolumeIDs = env->NewIntArray(numVolumes);
+        env->SetIntArrayRegion(jVolumeIDs, 0, numVolumes, volumeIDs.data());
+
+        auto jTimes = static_cast<jfloatArray>(env->CallObjectMethod(jvmData->obj, getRenderTimesMethod, jVolumeIDs));
+        if (env->ExceptionOccurred()) {
+            std::cerr << "ERROR in calling getVolumeRenderTimes!" << std::endl;
+            env->ExceptionDescribe();
+            env->ExceptionClear();
+        } else if (jTimes != nullptr && env->GetArrayLength(jTimes) == numVolumes) {
+            times.resize(volumeIDs.size());
+            env->GetFloatArrayRegion(jTimes, 0, numVolumes, times.data());
+        }
+
+        if (jTimes != nullptr) {
+            env->DeleteLocalRef(jTimes);
+        }
+        env->DeleteLocalRef(jVolumeIDs);
+
+        jvmData->jvm->DetachCurrentThread();
+        return times;
+    }
+
     void RenderingManager::waitRendererConfigured() {
         JNIEnv *env;
         env = jvmData->env;
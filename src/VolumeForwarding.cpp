@@ -0,0 +1,883 @@
+//
+// Forwarding of volume data from ranks without a renderer to the rank that renders it.
+//
+
+#include "VolumeForwarding.h"
+#include "ManageRendering.h"
+#include "utils/ParallelUtils.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cstdlib>
+#include <cstring>
+#include <iostream>
+#include <string>
+
+namespace liv {
+
+    namespace {
+        constexpr int kMessageTag = 7301;
+        constexpr int kPayloadTag = 7302;
+        constexpr int kReplyTag = 7303;
+        constexpr int kDataTag = 7304;
+
+        // larger volumes are sent in several messages, since MPI counts are ints
+        constexpr long long kMaxMessageBytes = 1ll << 30;
+
+        // a staging ring starts with a flag per slot, set by the visualization rank once it has released the slot,
+        // followed by the slots
+        MPI_Aint ringHeaderBytes(int numSlots) {
+            constexpr MPI_Aint alignment = 64;
+            const auto flagBytes = static_cast<MPI_Aint>(numSlots * sizeof(uint64_t));
+            return (flagBytes + alignment - 1) / alignment * alignment;
+        }
+
+        MPI_Aint slotDisplacement(int slot, int numSlots, long long slotSize) {
+            return ringHeaderBytes(numSlots) + static_cast<MPI_Aint>(slot) * slotSize;
+        }
+
+        // shared-memory slots 0 and 1 alternate between full updates of a volume, brick updates use slot 2
+        constexpr int kBrickSlot = 2;
+
+        ForwardedMessage makeMessage(ForwardedOperation operation, int volumeID = 0) {
+            ForwardedMessage message{};
+            message.operation = static_cast<int>(operation);
+            message.volumeID = volumeID;
+            return message;
+        }
+
+        // the leader is rank 0 of the pair communicator
+        MPI_Comm createPairComm(MPI_Comm comm, int leader, int member) {
+            MPI_Group group;
+            MPI_Group pairGroup;
+            MPI_Comm_group(comm, &group);
+
+            const int members[2] = {leader, member};
+            MPI_Group_incl(group, 2, members, &pairGroup);
+
+            MPI_Comm pairComm;
+            MPI_Comm_create_group(comm, pairGroup, member, &pairComm);
+
+            MPI_Group_free(&pairGroup);
+            MPI_Group_free(&group);
+            return pairComm;
+        }
+
+        void freeWindow(MPI_Win& window) {
+            if (window != MPI_WIN_NULL) {
+                MPI_Win_unlock_all(window);
+                MPI_Win_free(&window);
+            }
+        }
+
+        // collective over the pair communicator, only the sender, rank 1, contributes memory
+        SharedSegment allocateSegment(MPI_Comm pairComm, size_t size) {
+            SharedSegment segment;
+            char *base;
+            MPI_Win_allocate_shared(static_cast<MPI_Aint>(size), 1, MPI_INFO_NULL, pairComm, &base, &segment.window);
+            MPI_Win_lock_all(MPI_MODE_NOCHECK, segment.window);
+
+            MPI_Aint sharedSize;
+            int displacementUnit;
+            MPI_Win_shared_query(segment.window, 1, &sharedSize, &displacementUnit, &segment.base);
+            segment.capacity = static_cast<size_t>(sharedSize);
+            return segment;
+        }
+
+        // collective over the pair communicator, only the visualization rank contributes memory
+        char *allocateRing(MPI_Comm pairComm, MPI_Aint size, MPI_Win& window) {
+            char *base;
+            MPI_Win_allocate(size, 1, MPI_INFO_NULL, pairComm, &base, &window);
+            MPI_Win_lock_all(MPI_MODE_NOCHECK, window);
+            return base;
+        }
+    }
+
+    RenderingMode renderingModeFromEnvironment() {
+        const char *mode = getenv("LIV_RENDERING_MODE");
+        if (mode == nullptr || std::string(mode) == "rank") {
+            return RenderingMode::PerRank;
+        }
+        if (std::string(mode) == "node") {
+            return RenderingMode::PerNode;
+        }
+        if (std::string(mode) == "transit") {
+            return RenderingMode::InTransit;
+        }
+
+        std::cerr << "ERROR: Unknown rendering mode " << mode << ", rendering on every rank" << std::endl;
+        return RenderingMode::PerRank;
+    }
+
+    int numVisualizationRanksFromEnvironment(int numRanks) {
+        const char *value = getenv("LIV_VISUALIZATION_RANKS");
+        const int requested = value == nullptr ? 1 : std::atoi(value);
+        const int numVisualizationRanks = std::clamp(requested, 1, std::max(numRanks - 1, 1));
+
+        if (numVisualizationRanks != requested) {
+            std::cerr << "ERROR: Cannot use " << requested << " of " << numRanks << " ranks for visualization, using "
+                      << numVisualizationRanks << std::endl;
+        }
+        return numVisualizationRanks;
+    }
+
+    TransitTransport transitTransportFromEnvironment() {
+        const char *transport = getenv("LIV_TRANSIT_TRANSPORT");
+        if (transport == nullptr || std::string(transport) == "messages") {
+            return TransitTransport::MessagePassing;
+        }
+        if (std::string(transport) == "onesided") {
+            return TransitTransport::OneSided;
+        }
+
+        std::cerr << "ERROR: Unknown in-transit transport " << transport << ", using messages" << std::endl;
+        return TransitTransport::MessagePassing;
+    }
+
+    int numStagingSlotsFromEnvironment() {
+        const char *value = getenv("LIV_STAGING_SLOTS");
+        const int numSlots = value == nullptr ? 4 : std::atoi(value);
+        return std::max(numSlots, 1);
+    }
+
+    int visualizationRankOf(int rank, int numRanks, int numVisualizationRanks) {
+        // the first rank of each of numVisualizationRanks contiguous groups
+        const long long group = static_cast<long long>(rank) * numVisualizationRanks / numRanks;
+        return static_cast<int>((group * numRanks + numVisualizationRanks - 1) / numVisualizationRanks);
+    }
+
+    int ForwardedVolumeIDs::get(int sourceRank, int volumeID) {
+        auto id = ids.find({sourceRank, volumeID});
+        if (id == ids.end()) {
+            id = ids.emplace(std::make_pair(sourceRank, volumeID), next--).first;
+        }
+        return id->second;
+    }
+
+    void ForwardedVolumeIDs::erase(int sourceRank, int volumeID) {
+        ids.erase({sourceRank, volumeID});
+    }
+
+    float VolumeSender::send(ForwardedMessage& message, const std::vector<int>& ints) {
+        message.sourceRank = sourceRank;
+        message.numInts = static_cast<int>(ints.size());
+
+        MPI_Send(&message, sizeof(ForwardedMessage), MPI_BYTE, destination, kMessageTag, comm);
+        if (!ints.empty()) {
+            MPI_Send(ints.data(), static_cast<int>(ints.size()), MPI_INT, destination, kPayloadTag, comm);
+        }
+
+        float value = 0.0f;
+        if (message.replyRequested) {
+            MPI_Recv(&value, 1, MPI_FLOAT, destination, kReplyTag, comm, MPI_STATUS_IGNORE);
+        }
+        return value;
+    }
+
+    void VolumeSender::addVolume(int volumeID, const int *dimensions, const float *position, bool is16BitData) {
+        auto message = makeMessage(ForwardedOperation::AddVolume, volumeID);
+        std::copy(dimensions, dimensions + 3, message.dimensions);
+        std::copy(position, position + 3, message.position);
+        message.is16BitData = is16BitData;
+        send(message);
+    }
+
+    void VolumeSender::removeVolume(int volumeID) {
+        auto message = makeMessage(ForwardedOperation::RemoveVolume, volumeID);
+        send(message);
+    }
+
+    void VolumeSender::updateBrickStatistics(int volumeID, const std::vector<int>& brickSize, const std::vector<int>& minMax,
+                                             const std::vector<int>& histogram) {
+        auto message = makeMessage(ForwardedOperation::UpdateBrickStatistics, volumeID);
+        message.dimensions[0] = static_cast<int>(minMax.size());
+
+        std::vector<int> ints(brickSize.begin(), brickSize.end());
+        ints.insert(ints.end(), minMax.begin(), minMax.end());
+        ints.insert(ints.end(), histogram.begin(), histogram.end());
+        send(message, ints);
+    }
+
+    void VolumeSender::setVolumeDimensions(const std::vector<int>& dimensions) {
+        auto message = makeMessage(ForwardedOperation::SetVolumeDimensions);
+        std::copy(dimensions.begin(), dimensions.begin() + 3, message.dimensions);
+        send(message);
+    }
+
+    float VolumeSender::getVolumeScaling() {
+        auto message = makeMessage(ForwardedOperation::GetVolumeScaling);
+        message.replyRequested = 1;
+        return send(message);
+    }
+
+    void VolumeSender::finish() {
+        auto message = makeMessage(ForwardedOperation::Finish);
+        send(message);
+    }
+
+    VolumeReceiver::~VolumeReceiver() {
+        join();
+    }
+
+    void VolumeReceiver::start() {
+        if (numSenders > 0) {
+            thread = std::thread(&VolumeReceiver::run, this);
+        }
+    }
+
+    void VolumeReceiver::join() {
+        if (thread.joinable()) {
+            thread.join();
+        }
+    }
+
+    void VolumeReceiver::reply(int source, float value) {
+        MPI_Send(&value, 1, MPI_FLOAT, source, kReplyTag, comm);
+    }
+
+    void VolumeReceiver::run() {
+        int remaining = numSenders;
+
+        while (remaining > 0) {
+            ForwardedMessage message;
+            MPI_Status status;
+            MPI_Recv(&message, sizeof(ForwardedMessage), MPI_BYTE, MPI_ANY_SOURCE, kMessageTag, comm, &status);
+            const int source = status.MPI_SOURCE;
+
+            std::vector<int> ints(message.numInts);
+            if (message.numInts > 0) {
+                MPI_Recv(ints.data(), message.numInts, MPI_INT, source, kPayloadTag, comm, MPI_STATUS_IGNORE);
+            }
+
+            const int volumeID = volumeIDs.get(message.sourceRank, message.volumeID);
+            const std::vector<int> dimensions(message.dimensions, message.dimensions + 3);
+            float value = 0.0f;
+
+            switch (static_cast<ForwardedOperation>(message.operation)) {
+                case ForwardedOperation::AddVolume: {
+                    auto manager = renderer();
+                    if (!manager->isRendererConfigured()) {
+                        manager->waitRendererConfigured();
+                    }
+                    manager->addVolume(volumeID, dimensions, {message.position, message.position + 3}, message.is16BitData != 0);
+                    break;
+                }
+                case ForwardedOperation::UpdateVolume: {
+                    auto data = const_cast<char *>(receiveData(message, source));
+                    renderer()->updateVolume(volumeID, data, static_cast<long>(message.dataSize));
+                    release(message, source);
+                    break;
+                }
+                case ForwardedOperation::UpdateVolumeBricks: {
+                    auto data = const_cast<char *>(receiveData(message, source));
+                    const auto half = ints.begin() + ints.size() / 2;
+                    renderer()->updateVolumeBricks(volumeID, {ints.begin(), half}, {half, ints.end()}, data,
+                                                   static_cast<long>(message.dataSize));
+                    release(message, source);
+                    break;
+                }
+                case ForwardedOperation::UpdateBrickStatistics: {
+                    const auto minMaxEnd = ints.begin() + 3 + message.dimensions[0];
+                    renderer()->updateBrickStatistics(volumeID, {ints.begin(), ints.begin() + 3},
+                                                      {ints.begin() + 3, minMaxEnd}, {minMaxEnd, ints.end()});
+                    break;
+                }
+                case ForwardedOperation::SetVolumeDimensions:
+                    renderer()->setVolumeDimensions(dimensions);
+                    break;
+                case ForwardedOperation::GetVolumeScaling:
+                    value = renderer()->getVolumeScaling();
+                    break;
+                case ForwardedOperation::RemoveVolume:
+                    renderer()->removeVolume(volumeID);
+                    handleTransportMessage(message, source);
+                    volumeIDs.erase(message.sourceRank, message.volumeID);
+                    break;
+                case ForwardedOperation::Finish:
+                    remaining--;
+                    handleTransportMessage(message, source);
+                    break;
+                default:
+                    handleTransportMessage(message, source);
+                    break;
+            }
+
+            if (message.replyRequested) {
+                reply(source, value);
+            }
+        }
+
+        std::cout << "All " << numSenders << " forwarding ranks have finished" << std::endl;
+    }
+
+    SharedMemoryVolumeSender::SharedMemoryVolumeSender(MPI_Comm nodeComm, int sourceRank)
+        : VolumeSender(nodeComm, 0, sourceRank) {
+        int nodeRank;
+        MPI_Comm_rank(nodeComm, &nodeRank);
+
+        pairComm = createPairComm(nodeComm, 0, nodeRank);
+    }
+
+    SharedMemoryVolumeSender::~SharedMemoryVolumeSender() {
+        if (pairComm != MPI_COMM_NULL) {
+            std::cerr << "ERROR: Shared-memory volume sender destroyed without finishing" << std::endl;
+        }
+    }
+
+    int SharedMemoryVolumeSender::nextSlot(int volumeID) {
+        auto current = currentSlots.find(volumeID);
+        return current == currentSlots.end() ? 0 : 1 - current->second;
+    }
+
+    SharedSegment& SharedMemoryVolumeSender::ensureCapacity(int volumeID, int slot, size_t size) {
+        auto& segment = segments[{volumeID, slot}];
+        if (size <= segment.capacity) {
+            return segment;
+        }
+
+        const size_t newCapacity = std::max(size, segment.capacity + segment.capacity / 2);
+
+        auto message = makeMessage(ForwardedOperation::ResizeBuffer, volumeID);
+        message.slot = slot;
+        message.dataSize = static_cast<long long>(newCapacity);
+        send(message);
+
+        // the renderer does not hold this slot: it was given the other full-update slot last, and consumes bricks
+        // before replying. The new segment is still allocated first, in the same order as on the rendering rank.
+        SharedSegment resized = allocateSegment(pairComm, newCapacity);
+        freeWindow(segment.window);
+        segment = resized;
+        return segment;
+    }
+
+    void SharedMemoryVolumeSender::stage(int volumeID, int slot, const char *data, size_t size) {
+        auto& segment = ensureCapacity(volumeID, slot, size);
+
+        // data written directly into the shared buffer is not copied
+        if (data != segment.base) {
+            parallelFor(0, size, [&](size_t begin, size_t end, size_t) {
+                std::memcpy(segment.base + begin, data + begin, end - begin);
+            }, 1 << 20);
+        }
+
+        MPI_Win_sync(segment.window);
+    }
+
+    void SharedMemoryVolumeSender::updateVolume(int volumeID, const char *data, long size) {
+        const int slot = nextSlot(volumeID);
+        stage(volumeID, slot, data, static_cast<size_t>(size));
+
+        auto message = makeMessage(ForwardedOperation::UpdateVolume, volumeID);
+        message.dataSize = size;
+        message.slot = slot;
+        // once the renderer has switched to this slot, the other one may be overwritten
+        message.replyRequested = 1;
+        send(message);
+
+        currentSlots[volumeID] = slot;
+    }
+
+    void SharedMemoryVolumeSender::updateVolumeBricks(int volumeID, const std::vector<int>& offsets,
+                                                      const std::vector<int>& extents, const char *data, long size) {
+        stage(volumeID, kBrickSlot, data, static_cast<size_t>(size));
+
+        auto message = makeMessage(ForwardedOperation::UpdateVolumeBricks, volumeID);
+        message.dataSize = size;
+        message.slot = kBrickSlot;
+        // the slot may only be reused once the renderer has consumed the bricks
+        message.replyRequested = 1;
+
+        std::vector<int> ints(offsets);
+        ints.insert(ints.end(), extents.begin(), extents.end());
+        send(message, ints);
+    }
+
+    char *SharedMemoryVolumeSender::getSharedBuffer(int volumeID, size_t size) {
+        return ensureCapacity(volumeID, nextSlot(volumeID), size).base;
+    }
+
+    void SharedMemoryVolumeSender::finish() {
+        VolumeSender::finish();
+
+        // blocks until the rendering rank releases the segments once rendering has stopped
+        for (auto& entry : segments) {
+            freeWindow(entry.second.window);
+        }
+        segments.clear();
+        currentSlots.clear();
+        MPI_Comm_free(&pairComm);
+    }
+
+    SharedMemoryVolumeReceiver::SharedMemoryVolumeReceiver(MPI_Comm nodeComm, std::function<RenderingManager *()> renderer)
+        : VolumeReceiver(nodeComm, 0, std::move(renderer)) {
+        int nodeSize;
+        MPI_Comm_size(nodeComm, &nodeSize);
+        numSenders = nodeSize - 1;
+
+        for (int sender = 1; sender < nodeSize; sender++) {
+            senders[sender].pairComm = createPairComm(nodeComm, 0, sender);
+        }
+    }
+
+    SharedMemoryVolumeReceiver::~SharedMemoryVolumeReceiver() {
+        join();
+    }
+
+    const char *SharedMemoryVolumeReceiver::receiveData(const ForwardedMessage& message, int source) {
+        auto& segment = senders[source].segments[{message.volumeID, message.slot}];
+        MPI_Win_sync(segment.window);
+        return segment.base;
+    }
+
+    void SharedMemoryVolumeReceiver::handleTransportMessage(const ForwardedMessage& message, int source) {
+        auto& sender = senders[source];
+
+        switch (static_cast<ForwardedOperation>(message.operation)) {
+            case ForwardedOperation::ResizeBuffer: {
+                // the rendering rank contributes no memory, it only maps the sender's segment
+                auto& segment = sender.segments[{message.volumeID, message.slot}];
+                SharedSegment resized = allocateSegment(sender.pairComm, 0);
+                freeWindow(segment.window);
+                segment = resized;
+                break;
+            }
+            case ForwardedOperation::RemoveVolume:
+            case ForwardedOperation::Finish:
+                // the renderer may still read the segments, they are freed by releaseBuffers
+                break;
+            default:
+                std::cerr << "ERROR: Unknown forwarded operation " << message.operation << std::endl;
+                break;
+        }
+    }
+
+    void SharedMemoryVolumeReceiver::releaseBuffers() {
+        for (auto& entry : senders) {
+            auto& sender = entry.second;
+            for (auto& segment : sender.segments) {
+                freeWindow(segment.second.window);
+            }
+            sender.segments.clear();
+            if (sender.pairComm != MPI_COMM_NULL) {
+                MPI_Comm_free(&sender.pairComm);
+            }
+        }
+    }
+
+    MessagePassingVolumeSender::~MessagePassingVolumeSender() {
+        if (!pending.empty()) {
+            std::cerr << "ERROR: Message-passing volume sender destroyed without finishing" << std::endl;
+        }
+    }
+
+    void MessagePassingVolumeSender::waitPending(int volumeID) {
+        auto requests = pending.find(volumeID);
+        if (requests != pending.end()) {
+            MPI_Waitall(static_cast<int>(requests->second.size()), requests->second.data(), MPI_STATUSES_IGNORE);
+            pending.erase(requests);
+        }
+    }
+
+    void MessagePassingVolumeSender::sendData(int volumeID, const char *data, long size) {
+        auto& requests = pending[volumeID];
+        for (long long offset = 0; offset < size; offset += kMaxMessageBytes) {
+            const auto count = static_cast<int>(std::min<long long>(kMaxMessageBytes, size - offset));
+            requests.emplace_back();
+            MPI_Isend(data + offset, count, MPI_BYTE, destination, kDataTag, comm, &requests.back());
+        }
+    }
+
+    void MessagePassingVolumeSender::updateVolume(int volumeID, const char *data, long size) {
+        waitPending(volumeID);
+
+        auto& buffer = sendBuffers[volumeID];
+        buffer.resize(static_cast<size_t>(size));
+        parallelFor(0, buffer.size(), [&](size_t begin, size_t end, size_t) {
+            std::memcpy(buffer.data() + begin, data + begin, end - begin);
+        }, 1 << 20);
+
+        auto message = makeMessage(ForwardedOperation::UpdateVolume, volumeID);
+        message.dataSize = size;
+        send(message);
+        sendData(volumeID, buffer.data(), size);
+    }
+
+    void MessagePassingVolumeSender::updateVolumeBricks(int volumeID, const std::vector<int>& offsets,
+                                                        const std::vector<int>& extents, const char *data, long size) {
+        waitPending(volumeID);
+
+        auto& buffer = sendBuffers[volumeID];
+        buffer.assign(data, data + size);
+
+        auto message = makeMessage(ForwardedOperation::UpdateVolumeBricks, volumeID);
+        message.dataSize = size;
+
+        std::vector<int> ints(offsets);
+        ints.insert(ints.end(), extents.begin(), extents.end());
+        send(message, ints);
+        sendData(volumeID, buffer.data(), size);
+    }
+
+    void MessagePassingVolumeSender::removeVolume(int volumeID) {
+        waitPending(volumeID);
+        sendBuffers.erase(volumeID);
+        VolumeSender::removeVolume(volumeID);
+    }
+
+    void MessagePassingVolumeSender::finish() {
+        while (!pending.empty()) {
+            waitPending(pending.begin()->first);
+        }
+        sendBuffers.clear();
+
+        VolumeSender::finish();
+    }
+
+    MessagePassingVolumeReceiver::~MessagePassingVolumeReceiver() {
+        join();
+    }
+
+    const char *MessagePassingVolumeReceiver::receiveData(const ForwardedMessage& message, int source) {
+        auto& volume = volumes[volumeIDs.get(message.sourceRank, message.volumeID)];
+
+        const bool bricks = static_cast<ForwardedOperation>(message.operation) == ForwardedOperation::UpdateVolumeBricks;
+        if (!bricks) {
+            volume.current = 1 - volume.current;
+        }
+
+        auto& buffer = bricks ? volume.bricks : volume.buffers[volume.current];
+        buffer.resize(static_cast<size_t>(message.dataSize));
+
+        for (long long offset = 0; offset < message.dataSize; offset += kMaxMessageBytes) {
+            const auto count = static_cast<int>(std::min<long long>(kMaxMessageBytes, message.dataSize - offset));
+            MPI_Recv(buffer.data() + offset, count, MPI_BYTE, source, kDataTag, comm, MPI_STATUS_IGNORE);
+        }
+        return buffer.data();
+    }
+
+    void MessagePassingVolumeReceiver::handleTransportMessage(const ForwardedMessage& message, int /*source*/) {
+        if (static_cast<ForwardedOperation>(message.operation) == ForwardedOperation::RemoveVolume) {
+            volumes.erase(volumeIDs.get(message.sourceRank, message.volumeID));
+        }
+    }
+
+    OneSidedVolumeSender::OneSidedVolumeSender(MPI_Comm comm, int destination, int sourceRank, int numSlots)
+        : VolumeSender(comm, destination, sourceRank), minSlots(std::max(numSlots, 1)) {
+        int rank;
+        MPI_Comm_rank(comm, &rank);
+
+        pairComm = createPairComm(comm, destination, rank);
+        allocateRing(pairComm, 0, window);
+        MPI_Barrier(pairComm);
+
+        notifier = std::thread(&OneSidedVolumeSender::announce, this);
+    }
+
+    OneSidedVolumeSender::~OneSidedVolumeSender() {
+        if (notifier.joinable()) {
+            std::cerr << "ERROR: One-sided volume sender destroyed without finishing" << std::endl;
+            {
+                std::lock_guard<std::mutex> lock(mutex);
+                stopping = true;
+            }
+            changed.notify_all();
+            notifier.join();
+        }
+    }
+
+    void OneSidedVolumeSender::announce() {
+        std::unique_lock<std::mutex> lock(mutex);
+
+        while (true) {
+            changed.wait(lock, [this]() { return stopping || !announcements.empty(); });
+            if (announcements.empty()) {
+                return;
+            }
+
+            auto announcement = std::move(announcements.front());
+            announcements.pop_front();
+            announcing = true;
+            lock.unlock();
+
+            // the data must have arrived before the visualization rank learns about it
+            MPI_Win_flush(0, window);
+            VolumeSender::send(announcement.first, announcement.second);
+
+            lock.lock();
+            announcing = false;
+            changed.notify_all();
+        }
+    }
+
+    void OneSidedVolumeSender::drain() {
+        std::unique_lock<std::mutex> lock(mutex);
+        changed.wait(lock, [this]() { return announcements.empty() && !announcing; });
+    }
+
+    float OneSidedVolumeSender::send(ForwardedMessage& message, const std::vector<int>& ints) {
+        // keeps all messages in the order they were issued
+        drain();
+        return VolumeSender::send(message, ints);
+    }
+
+    bool OneSidedVolumeSender::refreshSlots() {
+        std::vector<uint64_t> released(numSlots);
+        MPI_Request request;
+        MPI_Rget_accumulate(nullptr, 0, MPI_UINT64_T, released.data(), numSlots, MPI_UINT64_T, 0, 0, numSlots,
+                            MPI_UINT64_T, MPI_NO_OP, window, &request);
+        MPI_Wait(&request, MPI_STATUS_IGNORE);
+
+        bool freed = false;
+        for (int slot = 0; slot < numSlots; slot++) {
+            if (slotsInUse[slot] && released[slot] != 0) {
+                slotsInUse[slot] = 0;
+                freed = true;
+            }
+        }
+        return freed;
+    }
+
+    void OneSidedVolumeSender::ensureRing(long long size, int volumeID) {
+        const size_t numVolumes = currentSlots.size() + (volumeID >= 0 && currentSlots.count(volumeID) == 0 ? 1 : 0);
+        const int requiredSlots = std::max(minSlots, static_cast<int>(numVolumes) + 1);
+        if (size <= slotSize && requiredSlots <= numSlots) {
+            return;
+        }
+
+        const long long newSlotSize = size > slotSize ? std::max(size, slotSize + slotSize / 2) : slotSize;
+        const int newNumSlots = std::max(requiredSlots, numSlots);
+
+        // all puts into the old ring must have completed, and the visualization rank must have handled them
+        drain();
+
+        auto message = makeMessage(ForwardedOperation::ResizeBuffer);
+        message.dataSize = newSlotSize;
+        message.dimensions[0] = newNumSlots;
+        send(message);
+
+        // the new ring is allocated before the old one is freed, in the same order as on the visualization rank
+        MPI_Win resized = MPI_WIN_NULL;
+        allocateRing(pairComm, 0, resized);
+        MPI_Barrier(pairComm);
+        freeWindow(window);
+        window = resized;
+
+        numSlots = newNumSlots;
+        slotSize = newSlotSize;
+        staging.resize(numSlots);
+
+        // the visualization rank moved the slots the renderer holds to the start of the new ring, in order of volume
+        slotsInUse.assign(numSlots, 0);
+        int slot = 0;
+        for (auto& current : currentSlots) {
+            current.second = slot;
+            slotsInUse[slot++] = 1;
+        }
+        nextSlot = slot % numSlots;
+    }
+
+    int OneSidedVolumeSender::put(const char *data, long size) {
+        // the ring has a free slot besides those the renderer holds, which are released by later updates
+        int slot = -1;
+        while (slot < 0) {
+            for (int i = 0; i < numSlots && slot < 0; i++) {
+                const int candidate = (nextSlot + i) % numSlots;
+                slot = slotsInUse[candidate] ? -1 : candidate;
+            }
+            if (slot < 0 && !refreshSlots()) {
+                std::this_thread::sleep_for(std::chrono::microseconds(100));
+            }
+        }
+        slotsInUse[slot] = 1;
+        nextSlot = (slot + 1) % numSlots;
+
+        // the previous put from this staging buffer completed before the slot was announced and released
+        auto& buffer = staging[slot];
+        if (buffer.size() < static_cast<size_t>(size)) {
+            buffer = std::vector<char>(static_cast<size_t>(slotSize));
+        }
+        parallelFor(0, static_cast<size_t>(size), [&](size_t begin, size_t end, size_t) {
+            std::memcpy(buffer.data() + begin, data + begin, end - begin);
+        }, 1 << 20);
+
+        const uint64_t inUse = 0;
+        MPI_Accumulate(&inUse, 1, MPI_UINT64_T, 0, static_cast<MPI_Aint>(slot * sizeof(uint64_t)), 1, MPI_UINT64_T,
+                       MPI_REPLACE, window);
+
+        const MPI_Aint displacement = slotDisplacement(slot, numSlots, slotSize);
+        for (long long offset = 0; offset < size; offset += kMaxMessageBytes) {
+            const auto count = static_cast<int>(std::min<long long>(kMaxMessageBytes, size - offset));
+            MPI_Put(buffer.data() + offset, count, MPI_BYTE, 0, displacement + offset, count, MPI_BYTE, window);
+        }
+        return slot;
+    }
+
+    void OneSidedVolumeSender::enqueue(const ForwardedMessage& message, std::vector<int> ints) {
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            announcements.emplace_back(message, std::move(ints));
+        }
+        changed.notify_all();
+    }
+
+    void OneSidedVolumeSender::updateVolume(int volumeID, const char *data, long size) {
+        ensureRing(size, volumeID);
+
+        auto message = makeMessage(ForwardedOperation::UpdateVolume, volumeID);
+        message.dataSize = size;
+        message.slot = put(data, size);
+
+        // the previous slot of the volume is released once the renderer has been given this one
+        currentSlots[volumeID] = message.slot;
+        enqueue(message, {});
+    }
+
+    void OneSidedVolumeSender::updateVolumeBricks(int volumeID, const std::vector<int>& offsets,
+                                                  const std::vector<int>& extents, const char *data, long size) {
+        ensureRing(size, -1);
+
+        auto message = makeMessage(ForwardedOperation::UpdateVolumeBricks, volumeID);
+        message.dataSize = size;
+        message.slot = put(data, size);
+
+        std::vector<int> ints(offsets);
+        ints.insert(ints.end(), extents.begin(), extents.end());
+        enqueue(message, std::move(ints));
+    }
+
+    void OneSidedVolumeSender::removeVolume(int volumeID) {
+        // the visualization rank releases the slot the renderer held
+        currentSlots.erase(volumeID);
+        VolumeSender::removeVolume(volumeID);
+    }
+
+    void OneSidedVolumeSender::finish() {
+        VolumeSender::finish();
+
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            stopping = true;
+        }
+        changed.notify_all();
+        notifier.join();
+
+        // blocks until the visualization rank releases the ring once rendering has stopped
+        freeWindow(window);
+        MPI_Comm_free(&pairComm);
+        staging.clear();
+        currentSlots.clear();
+    }
+
+    OneSidedVolumeReceiver::OneSidedVolumeReceiver(MPI_Comm comm, const std::vector<int>& senders,
+                                                   std::function<RenderingManager *()> renderer)
+        : VolumeReceiver(comm, static_cast<int>(senders.size()), std::move(renderer)) {
+        int rank;
+        MPI_Comm_rank(comm, &rank);
+
+        for (int sender : senders) {
+            auto& ring = rings[sender];
+            ring.pairComm = createPairComm(comm, rank, sender);
+            allocate(ring, 0, 0);
+        }
+    }
+
+    OneSidedVolumeReceiver::~OneSidedVolumeReceiver() {
+        join();
+    }
+
+    void OneSidedVolumeReceiver::allocate(StagingRing& ring, long long slotSize, int numSlots) {
+        ring.base = allocateRing(ring.pairComm, slotDisplacement(numSlots, numSlots, slotSize), ring.window);
+        ring.slotSize = slotSize;
+        ring.numSlots = numSlots;
+
+        // no slot has been released yet, and the sender reads the flags only after the barrier
+        std::memset(ring.base, 0, static_cast<size_t>(ringHeaderBytes(numSlots)));
+        MPI_Win_sync(ring.window);
+        MPI_Barrier(ring.pairComm);
+    }
+
+    void OneSidedVolumeReceiver::resize(StagingRing& ring, const ForwardedMessage& message) {
+        StagingRing resized;
+        resized.pairComm = ring.pairComm;
+        allocate(resized, message.dataSize, message.dimensions[0]);
+
+        // the renderer keeps reading the last full update of every volume, so these move to the start of the new ring
+        // in order of volume, where the sender expects them
+        int slot = 0;
+        for (const auto& entry : ring.held) {
+            const auto& volume = entry.second;
+            const char *source = ring.base + slotDisplacement(volume.slot, ring.numSlots, ring.slotSize);
+            char *target = resized.base + slotDisplacement(slot, resized.numSlots, resized.slotSize);
+            parallelFor(0, static_cast<size_t>(volume.size), [&](size_t begin, size_t end, size_t) {
+                std::memcpy(target + begin, source + begin, end - begin);
+            }, 1 << 20);
+
+            renderer()->updateVolume(volumeIDs.get(message.sourceRank, entry.first), target,
+                                     static_cast<long>(volume.size));
+            resized.held[entry.first] = {slot++, volume.size};
+        }
+
+        freeWindow(ring.window);
+        ring = std::move(resized);
+    }
+
+    void OneSidedVolumeReceiver::releaseSlot(StagingRing& ring, int slot) {
+        const uint64_t released = 1;
+        MPI_Accumulate(&released, 1, MPI_UINT64_T, 0, static_cast<MPI_Aint>(slot * sizeof(uint64_t)), 1, MPI_UINT64_T,
+                       MPI_REPLACE, ring.window);
+        MPI_Win_flush(0, ring.window);
+    }
+
+    const char *OneSidedVolumeReceiver::receiveData(const ForwardedMessage& message, int source) {
+        auto& ring = rings[source];
+        MPI_Win_sync(ring.window);
+        return ring.base + slotDisplacement(message.slot, ring.numSlots, ring.slotSize);
+    }
+
+    void OneSidedVolumeReceiver::release(const ForwardedMessage& message, int source) {
+        auto& ring = rings[source];
+
+        if (static_cast<ForwardedOperation>(message.operation) == ForwardedOperation::UpdateVolumeBricks) {
+            releaseSlot(ring, message.slot);
+            return;
+        }
+
+        // the renderer reads the full update from the slot until it has been given the next one
+        auto held = ring.held.find(message.volumeID);
+        if (held != ring.held.end()) {
+            releaseSlot(ring, held->second.slot);
+        }
+        ring.held[message.volumeID] = {message.slot, message.dataSize};
+    }
+
+    void OneSidedVolumeReceiver::handleTransportMessage(const ForwardedMessage& message, int source) {
+        switch (static_cast<ForwardedOperation>(message.operation)) {
+            case ForwardedOperation::ResizeBuffer:
+                resize(rings[source], message);
+                break;
+            case ForwardedOperation::RemoveVolume: {
+                auto& ring = rings[source];
+                auto held = ring.held.find(message.volumeID);
+                if (held != ring.held.end()) {
+                    releaseSlot(ring, held->second.slot);
+                    ring.held.erase(held);
+                }
+                break;
+            }
+            case ForwardedOperation::Finish:
+                // the renderer may still read the ring, it is freed by releaseBuffers
+                break;
+            default:
+                std::cerr << "ERROR: Unknown forwarded operation " << message.operation << std::endl;
+                break;
+        }
+    }
+
+    void OneSidedVolumeReceiver::releaseBuffers() {
+        for (auto& entry : rings) {
+            freeWindow(entry.second.window);
+            MPI_Comm_free(&entry.second.pairComm);
+        }
+        rings.clear();
+    }
+}
@@ -0,0 +1,243 @@
+//
+// Composition of AMR patches into uniform bricks.
+//
+
+#include "utils/AMRResampling.h"
+
+#include <algorithm>
+#include <iostream>
+
+#include "utils/ParallelUtils.h"
+
+namespace liv {
+
+    namespace {
+        int floorDiv(int a, int b) {
+            return a / b - (a % b != 0 && (a < 0) != (b < 0));
+        }
+
+        int ceilDiv(int a, int b) {
+            return -floorDiv(-a, b);
+        }
+
+        int power(int base, int exponent) {
+            int result = 1;
+            for (int i = 0; i < exponent; i++) {
+                result *= base;
+            }
+            return result;
+        }
+
+        // the patch cells that make up each brick cell along one axis, relative to the patch
+        struct AxisSamples {
+            std::vector<int> first;
+            std::vector<int> count;
+        };
+
+        AxisSamples axisSamples(int lower, int extent, int patchLower, int patchExtent, int finer, int coarser) {
+            AxisSamples samples;
+            samples.first.resize(extent);
+            samples.count.resize(extent);
+            for (int c = 0; c < extent; c++) {
+                const int cell = lower + c;
+                if (finer > 1) {
+                    const int begin = std::max(cell * finer, patchLower);
+                    const int end = std::min((cell + 1) * finer, patchLower + patchExtent);
+                    samples.first[c] = begin - patchLower;
+                    samples.count[c] = end - begin;
+                } else {
+                    samples.first[c] = floorDiv(cell, coarser) - patchLower;
+                    samples.count[c] = 1;
+                }
+            }
+            return samples;
+        }
+    }
+
+    AMRResampler::AMRResampler(const Box& box, int level, int refinementRatio, float fillValue)
+        : box(box), level(level), refinementRatio(refinementRatio), fillValue(fillValue),
+          brick(box.numVoxels(), fillValue) {}
+
+    int AMRResampler::addPatch(const AMRPatch& patch) {
+        patches.push_back(patch);
+        return static_cast<int>(patches.size()) - 1;
+    }
+
+    void AMRResampler::setPatchData(int patchID, const float *data) {
+        if (patchID < 0 || patchID >= static_cast<int>(patches.size())) {
+            std::cerr << "ERROR: Unknown AMR patch " << patchID << std::endl;
+            return;
+        }
+        patches[patchID].data = data;
+    }
+
+    Box AMRResampler::coveredCells(const AMRPatch& patch) const {
+        Box cells{};
+        for (int axis = 0; axis < 3; axis++) {
+            const int lower = patch.box.offset[axis];
+            const int upper = lower + patch.box.extent[axis];
+            int begin, end;
+            if (patch.level >= level) {
+                // brick cell c is covered if its center (c + 0.5) * finer lies within the patch
+                const int finer = power(refinementRatio, patch.level - level);
+                begin = ceilDiv(2 * lower - finer, 2 * finer);
+                end = ceilDiv(2 * upper - finer, 2 * finer);
+            } else {
+                const int coarser = power(refinementRatio, level - patch.level);
+                begin = lower * coarser;
+                end = upper * coarser;
+            }
+            cells.offset[axis] = begin;
+            cells.extent[axis] = std::max(0, end - begin);
+        }
+        return cells;
+    }
+
+    void AMRResampler::resamplePatch(const AMRPatch& patch, const Box& region) {
+        Box cells{};
+        if (patch.data == nullptr || !intersectBoxes(coveredCells(patch), region, cells)) {
+            return;
+        }
+
+        const int finer = patch.level >= level ? power(refinementRatio, patch.level - level) : 1;
+        const int coarser = patch.level < level ? power(refinementRatio, level - patch.level) : 1;
+
+        AxisSamples samples[3];
+        for (int axis = 0; axis < 3; axis++) {
+            samples[axis] = axisSamples(cells.offset[axis], cells.extent[axis], patch.box.offset[axis],
+                                        patch.box.extent[axis], finer, coarser);
+        }
+
+        const size_t patchStrideY = static_cast<size_t>(patch.box.extent[0]);
+        const size_t patchStrideZ = patchStrideY * patch.box.extent[1];
+        const size_t brickStrideY = static_cast<size_t>(box.extent[0]);
+        const size_t brickStrideZ = brickStrideY * box.extent[1];
+
+        for (int z = 0; z < cells.extent[2]; z++) {
+            for (int y = 0; y < cells.extent[1]; y++) {
+                float *row = brick.data() + (cells.offset[2] - box.offset[2] + z) * brickStrideZ
+                             + (cells.offset[1] - box.offset[1] + y) * brickStrideY + (cells.offset[0] - box.offset[0]);
+
+                if (finer == 1) {
+                    const float *source = patch.data + samples[2].first[z] * patchStrideZ
+                                          + samples[1].first[y] * patchStrideY;
+                    for (int x = 0; x < cells.extent[0]; x++) {
+                        row[x] = source[samples[0].first[x]];
+                    }
+                    continue;
+                }
+
+                for (int x = 0; x < cells.extent[0]; x++) {
+                    float sum = 0.0f;
+                    for (int k = 0; k < samples[2].count[z]; k++) {
+                        for (int j = 0; j < samples[1].count[y]; j++) {
+                            const float *source = patch.data + (samples[2].first[z] + k) * patchStrideZ
+                                                  + (samples[1].first[y] + j) * patchStrideY + samples[0].first[x];
+                            for (int i = 0; i < samples[0].count[x]; i++) {
+                                sum += source[i];
+                            }
+                        }
+                    }
+                    row[x] = sum / static_cast<float>(samples[0].count[x] * samples[1].count[y] * samples[2].count[z]);
+                }
+            }
+        }
+    }
+
+    void AMRResampler::resampleRegion(const Box& region) {
+        const size_t strides[3] = {1, static_cast<size_t>(box.extent[0]),
+                                   static_cast<size_t>(box.extent[0]) * box.extent[1]};
+        for (int z = 0; z < region.extent[2]; z++) {
+            for (int y = 0; y < region.extent[1]; y++) {
+                float *row = brick.data() + (region.offset[2] - box.offset[2] + z) * strides[2]
+                             + (region.offset[1] - box.offset[1] + y) * strides[1] + (region.offset[0] - box.offset[0]);
+                std::fill(row, row + region.extent[0], fillValue);
+            }
+        }
+
+        // coarse levels first, so that finer patches overwrite them
+        std::vector<int> order;
+        for (int p = 0; p < static_cast<int>(patches.size()); p++) {
+            Box overlap{};
+            if (intersectBoxes(coveredCells(patches[p]), region, overlap)) {
+                order.push_back(p);
+            }
+        }
+        std::stable_sort(order.begin(), order.end(), [this](int a, int b) {
+            return patches[a].level < patches[b].level;
+        });
+
+        // patches of one level cover disjoint cells and are resampled in parallel
+        for (size_t begin = 0; begin < order.size();) {
+            size_t end = begin;
+            while (end < order.size() && patches[order[end]].level == patches[order[begin]].level) {
+                end++;
+            }
+            parallelFor(begin, end, [&](size_t first, size_t last, size_t) {
+                for (size_t p = first; p < last; p++) {
+                    resamplePatch(patches[order[p]], region);
+                }
+            }, 1);
+            begin = end;
+        }
+    }
+
+    void AMRResampler::resample() {
+        resampleRegion(box);
+    }
+
+    std::vector<Box> AMRResampler::resample(const std::vector<int>& changedPatches) {
+        std::vector<Box> regions;
+        for (int patchID : changedPatches) {
+            if (patchID < 0 || patchID >= static_cast<int>(patches.size())) {
+                std::cerr << "ERROR: Unknown AMR patch " << patchID << std::endl;
+                continue;
+            }
+
+            Box region{};
+            if (!intersectBoxes(coveredCells(patches[patchID]), box, region)) {
+                continue;
+            }
+            resampleRegion(region);
+
+            for (int axis = 0; axis < 3; axis++) {
+                region.offset[axis] -= box.offset[axis];
+            }
+            regions.push_back(region);
+        }
+        return regions;
+    }
+
+    Box boundingBox(const std::vector<AMRPatch>& patches, int level, int refinementRatio) {
+        Box bounds{};
+        if (patches.empty()) {
+            return bounds;
+        }
+
+        int lower[3], upper[3];
+        for (size_t p = 0; p < patches.size(); p++) {
+            const auto& patch = patches[p];
+            for (int axis = 0; axis < 3; axis++) {
+                int begin = patch.box.offset[axis];
+                int end = begin + patch.box.extent[axis];
+                if (patch.level >= level) {
+                    const int finer = power(refinementRatio, patch.level - level);
+                    begin = floorDiv(begin, finer);
+                    end = ceilDiv(end, finer);
+                } else {
+                    const int coarser = power(refinementRatio, level - patch.level);
+                    begin *= coarser;
+                    end *= coarser;
+                }
+                lower[axis] = p == 0 ? begin : std::min(lower[axis], begin);
+                upper[axis] = p == 0 ? end : std::max(upper[axis], end);
+            }
+        }
+
+        for (int axis = 0; axis < 3; axis++) {
+            bounds.offset[axis] = lower[axis];
+            bounds.extent[axis] = upper[axis] - lower[axis];
+        }
+        return bounds;
+    }
+}
@@ -0,0 +1,402 @@
+//
+// Writing and reading of single-file containers for bricked volumes.
+//
+
+#include "utils/BrickContainer.h"
+#include "utils/Partitioning.h"
+
+#include <algorithm>
+#include <cerrno>
+#include <cstdlib>
+#include <cstring>
+#include <fcntl.h>
+#include <iostream>
+#include <unistd.h>
+
+#ifdef LIV_HAVE_ZLIB
+#include <zlib.h>
+#endif
+
+namespace liv {
+
+    namespace {
+        constexpr char kMagic[8] = {'L', 'I', 'V', 'B', 'R', 'I', 'C', 'K'};
+
+        uint64_t alignUp(uint64_t value, uint64_t alignment) {
+            return (value + alignment - 1) / alignment * alignment;
+        }
+
+        bool preadAll(int fd, char *buffer, size_t size, uint64_t offset) {
+            while (size > 0) {
+                const ssize_t count = pread(fd, buffer, size, static_cast<off_t>(offset));
+                if (count < 0 && errno == EINTR) continue;
+                if (count <= 0) return false;
+                buffer += count;
+                size -= static_cast<size_t>(count);
+                offset += static_cast<uint64_t>(count);
+            }
+            return true;
+        }
+
+        bool pwriteAll(int fd, const char *buffer, size_t size, uint64_t offset) {
+            while (size > 0) {
+                const ssize_t count = pwrite(fd, buffer, size, static_cast<off_t>(offset));
+                if (count < 0 && errno == EINTR) continue;
+                if (count <= 0) return false;
+                buffer += count;
+                size -= static_cast<size_t>(count);
+                offset += static_cast<uint64_t>(count);
+            }
+            return true;
+        }
+
+        template<typename T>
+        void valueRange(const char *data, size_t numVoxels, int32_t& minValue, int32_t& maxValue) {
+            const T *values = reinterpret_cast<const T *>(data);
+            T lo = numVoxels > 0 ? values[0] : 0;
+            T hi = lo;
+            for (size_t i = 1; i < numVoxels; i++) {
+                lo = std::min(lo, values[i]);
+                hi = std::max(hi, values[i]);
+            }
+            minValue = lo;
+            maxValue = hi;
+        }
+    }
+
+    bool isCompressionSupported(BrickCompression compression) {
+        switch (compression) {
+            case BrickCompression::None:
+                return true;
+            case BrickCompression::Deflate:
+#ifdef LIV_HAVE_ZLIB
+                return true;
+#else
+                return false;
+#endif
+        }
+        return false;
+    }
+
+    BrickContainerWriter::~BrickContainerWriter() {
+        if (fd >= 0) {
+            ::close(fd);
+        }
+    }
+
+    bool BrickContainerWriter::open(const std::string& filePath, const VolumeDescription& volume, const int *brickSize,
+                                    BrickCompression brickCompression, uint32_t alignment) {
+        if (!isCompressionSupported(brickCompression)) {
+            std::cerr << "ERROR: Brick compression " << static_cast<uint32_t>(brickCompression)
+                      << " is not supported by this build of LiV" << std::endl;
+            return false;
+        }
+        if (alignment == 0) {
+            std::cerr << "ERROR: The alignment of a brick container must be positive" << std::endl;
+            return false;
+        }
+
+        fd = ::open(filePath.c_str(), O_WRONLY | O_CREAT | O_TRUNC, 0644);
+        if (fd < 0) {
+            std::cerr << "ERROR: Could not create brick container " << filePath << ": " << std::strerror(errno) << std::endl;
+            return false;
+        }
+
+        path = filePath;
+        compression = brickCompression;
+        grid = BrickGrid(volume.dimensions, brickSize);
+
+        header = BrickContainerHeader{};
+        std::memcpy(header.magic, kMagic, sizeof(kMagic));
+        header.version = kBrickContainerVersion;
+        header.alignment = alignment;
+        std::copy(volume.dimensions, volume.dimensions + 3, header.dimensions);
+        header.bitResolution = volume.bitResolution;
+        std::copy(brickSize, brickSize + 3, header.brickSize);
+        header.numBricks = static_cast<uint32_t>(grid.numBricks());
+        header.flags = kBrickContainerHasMinMax | kBrickContainerHasVoxelCounts;
+
+        entries.assign(header.numBricks, BrickContainerEntry{});
+        uint64_t offset = alignUp(sizeof(BrickContainerHeader), alignment);
+
+        // uncompressed bricks have known sizes, so their places are fixed up front and bricks land in brick order
+        if (compression == BrickCompression::None) {
+            for (uint32_t i = 0; i < header.numBricks; i++) {
+                entries[i].offset = offset;
+                offset += alignUp(grid.brickBox(static_cast<int>(i)).numVoxels() * volume.elementSize(), alignment);
+            }
+        }
+        end = offset;
+        return true;
+    }
+
+    bool BrickContainerWriter::writeBrick(int brickIndex, const char *data) {
+        const size_t elementSize = static_cast<size_t>(header.bitResolution / 8);
+        const size_t numVoxels = grid.brickBox(brickIndex).numVoxels();
+        const size_t size = numVoxels * elementSize;
+        auto& entry = entries[brickIndex];
+
+        if (header.bitResolution == 16) {
+            valueRange<unsigned short>(data, numVoxels, entry.minValue, entry.maxValue);
+        } else {
+            valueRange<unsigned char>(data, numVoxels, entry.minValue, entry.maxValue);
+        }
+        entry.nonEmptyVoxels = static_cast<uint32_t>(countNonEmptyVoxels(data, numVoxels, header.bitResolution == 16));
+
+        const char *stored = data;
+        uint64_t storedSize = size;
+        entry.compression = static_cast<uint32_t>(BrickCompression::None);
+
+#ifdef LIV_HAVE_ZLIB
+        std::vector<char> compressed;
+        if (compression == BrickCompression::Deflate) {
+            uLongf compressedSize = compressBound(static_cast<uLong>(size));
+            compressed.resize(compressedSize);
+            if (compress2(reinterpret_cast<Bytef *>(compressed.data()), &compressedSize,
+                          reinterpret_cast<const Bytef *>(data), static_cast<uLong>(size), Z_BEST_SPEED) != Z_OK) {
+                std::cerr << "ERROR: Could not compress brick " << brickIndex << " of " << path << std::endl;
+                return false;
+            }
+            // bricks that do not shrink are stored as they are
+            if (compressedSize < size) {
+                stored = compressed.data();
+                storedSize = compressedSize;
+                entry.compression = static_cast<uint32_t>(BrickCompression::Deflate);
+            }
+        }
+#endif
+
+        if (compression != BrickCompression::None) {
+            entry.offset = end.fetch_add(alignUp(storedSize, header.alignment));
+        }
+        entry.storedSize = storedSize;
+
+        if (!pwriteAll(fd, stored, storedSize, entry.offset)) {
+            std::cerr << "ERROR: Could not write brick " << brickIndex << " to " << path << ": " << std::strerror(errno) << std::endl;
+            return false;
+        }
+        return true;
+    }
+
+    bool BrickContainerWriter::close() {
+        if (fd < 0) {
+            return false;
+        }
+
+        header.tableOffset = end;
+        const size_t tableSize = entries.size() * sizeof(BrickContainerEntry);
+        bool success = pwriteAll(fd, reinterpret_cast<const char *>(entries.data()), tableSize, header.tableOffset)
+                       && ftruncate(fd, static_cast<off_t>(alignUp(header.tableOffset + tableSize, header.alignment))) == 0
+                       && pwriteAll(fd, reinterpret_cast<const char *>(&header), sizeof(header), 0);
+        if (!success) {
+            std::cerr << "ERROR: Could not finish brick container " << path << ": " << std::strerror(errno) << std::endl;
+        }
+
+        ::close(fd);
+        fd = -1;
+        return success;
+    }
+
+    BrickContainer::~BrickContainer() {
+        close();
+    }
+
+    bool BrickContainer::open(const std::string& path, bool directIO) {
+        close();
+
+        fd = ::open(path.c_str(), O_RDONLY);
+        if (fd < 0) {
+            std::cerr << "ERROR: Could not open brick container " << path << ": " << std::strerror(errno) << std::endl;
+            return false;
+        }
+
+        if (!preadAll(fd, reinterpret_cast<char *>(&header), sizeof(header), 0)
+            || std::memcmp(header.magic, kMagic, sizeof(kMagic)) != 0) {
+            std::cerr << "ERROR: " << path << " is not a brick container" << std::endl;
+            close();
+            return false;
+        }
+        if (header.version != kBrickContainerVersion || header.alignment == 0
+            || (header.bitResolution != 8 && header.bitResolution != 16)) {
+            std::cerr << "ERROR: Unsupported brick container " << path << " (version " << header.version << ")" << std::endl;
+            close();
+            return false;
+        }
+
+        grid = BrickGrid(header.dimensions, header.brickSize);
+        if (static_cast<uint32_t>(grid.numBricks()) != header.numBricks) {
+            std::cerr << "ERROR: The brick table of " << path << " does not match its dimensions" << std::endl;
+            close();
+            return false;
+        }
+
+        entries.resize(header.numBricks);
+        if (!preadAll(fd, reinterpret_cast<char *>(entries.data()), entries.size() * sizeof(BrickContainerEntry),
+                      header.tableOffset)) {
+            std::cerr << "ERROR: Could not read the brick table of " << path << std::endl;
+            close();
+            return false;
+        }
+
+#ifdef O_DIRECT
+        if (directIO) {
+            const int directFd = ::open(path.c_str(), O_RDONLY | O_DIRECT);
+            if (directFd >= 0) {
+                ::close(fd);
+                fd = directFd;
+                direct = true;
+            }
+        }
+#endif
+        return true;
+    }
+
+    void BrickContainer::close() {
+        if (fd >= 0) {
+            ::close(fd);
+        }
+        fd = -1;
+        direct = false;
+        entries.clear();
+    }
+
+    VolumeDescription BrickContainer::getVolume() const {
+        return {{header.dimensions[0], header.dimensions[1], header.dimensions[2]}, header.bitResolution};
+    }
+
+    bool BrickContainer::readStored(const BrickContainerEntry& entry, std::vector<char>& stored) const {
+        stored.resize(entry.storedSize);
+        if (!direct) {
+            return preadAll(fd, stored.data(), stored.size(), entry.offset);
+        }
+
+        // O_DIRECT needs aligned buffers and lengths, which the padding of every brick allows for
+        const size_t length = alignUp(entry.storedSize, header.alignment);
+        void *buffer = nullptr;
+        if (posix_memalign(&buffer, header.alignment, length) != 0) {
+            return false;
+        }
+        const bool success = preadAll(fd, static_cast<char *>(buffer), length, entry.offset);
+        if (success) {
+            std::memcpy(stored.data(), buffer, entry.storedSize);
+        }
+        free(buffer);
+        return success;
+    }
+
+    bool BrickContainer::readBrick(int brickIndex, std::vector<char>& data) const {
+        const auto& entry = entries[brickIndex];
+        const size_t size = grid.brickBox(brickIndex).numVoxels() * static_cast<size_t>(header.bitResolution / 8);
+
+        switch (static_cast<BrickCompression>(entry.compression)) {
+            case BrickCompression::None:
+                if (entry.storedSize != size || !readStored(entry, data)) {
+                    std::cerr << "ERROR: Could not read brick " << brickIndex << " of the brick container" << std::endl;
+                    return false;
+                }
+                return true;
+            case BrickCompression::Deflate: {
+#ifdef LIV_HAVE_ZLIB
+                std::vector<char> stored;
+                uLongf uncompressedSize = static_cast<uLongf>(size);
+                data.resize(size);
+                if (!readStored(entry, stored)
+                    || uncompress(reinterpret_cast<Bytef *>(data.data()), &uncompressedSize,
+                                  reinterpret_cast<const Bytef *>(stored.data()), static_cast<uLong>(stored.size())) != Z_OK
+                    || uncompressedSize != size) {
+                    std::cerr << "ERROR: Could not decompress brick " << brickIndex << " of the brick container" << std::endl;
+                    return false;
+                }
+                return true;
+#else
+                break;
+#endif
+            }
+        }
+        std::cerr << "ERROR: Brick " << brickIndex << " uses compression " << entry.compression
+                  << ", which is not supported by this build of LiV" << std::endl;
+        return false;
+    }
+
+    bool BrickContainer::readBox(const Box& box, std::vector<char>& data) const {
+        for (int axis = 0; axis < 3; axis++) {
+            if (box.offset[axis] < 0 || box.extent[axis] < 0 || box.offset[axis] + box.extent[axis] > header.dimensions[axis]) {
+                std::cerr << "ERROR: The requested box lies outside the volume of the brick container" << std::endl;
+                return false;
+            }
+        }
+
+        const size_t elementSize = static_cast<size_t>(header.bitResolution / 8);
+        data.resize(box.numVoxels() * elementSize);
+        const size_t boxStrides[3] = {elementSize, elementSize * box.extent[0],
+                                      elementSize * box.extent[0] * box.extent[1]};
+
+        std::vector<char> brick;
+        for (int brickIndex : grid.bricksIntersecting(box.offset, box.extent)) {
+            if (!readBrick(brickIndex, brick)) {
+                return false;
+            }
+
+            const Box brickBox = grid.brickBox(brickIndex);
+            const size_t brickStrides[3] = {elementSize, elementSize * brickBox.extent[0],
+                                            elementSize * brickBox.extent[0] * brickBox.extent[1]};
+            int lower[3];
+            int extent[3];
+            for (int axis = 0; axis < 3; axis++) {
+                lower[axis] = std::max(box.offset[axis], brickBox.offset[axis]);
+                extent[axis] = std::min(box.offset[axis] + box.extent[axis], brickBox.offset[axis] + brickBox.extent[axis]) - lower[axis];
+            }
+
+            size_t srcOffset = 0;
+            size_t dstOffset = 0;
+            for (int axis = 0; axis < 3; axis++) {
+                srcOffset += (lower[axis] - brickBox.offset[axis]) * brickStrides[axis];
+                dstOffset += (lower[axis] - box.offset[axis]) * boxStrides[axis];
+            }
+            copyBox(brick.data() + srcOffset, brickStrides, data.data() + dstOffset, boxStrides, extent, elementSize);
+        }
+        return true;
+    }
+
+    double BrickContainer::estimateNonEmptyVoxels(const Box& box) const {
+        if (!hasVoxelCounts()) {
+            return static_cast<double>(box.numVoxels());
+        }
+
+        double estimate = 0.0;
+        for (int brickIndex : grid.bricksIntersecting(box.offset, box.extent)) {
+            const Box brickBox = grid.brickBox(brickIndex);
+            size_t overlap = 1;
+            for (int axis = 0; axis < 3; axis++) {
+                overlap *= std::min(box.offset[axis] + box.extent[axis], brickBox.offset[axis] + brickBox.extent[axis])
+                           - std::max(box.offset[axis], brickBox.offset[axis]);
+            }
+            estimate += static_cast<double>(entries[brickIndex].nonEmptyVoxels) * overlap / brickBox.numVoxels();
+        }
+        return estimate;
+    }
+
+    bool isBrickContainer(const std::string& path) {
+        const int fd = ::open(path.c_str(), O_RDONLY);
+        if (fd < 0) {
+            return false;
+        }
+        char magic[sizeof(kMagic)];
+        const bool matches = preadAll(fd, magic, sizeof(magic), 0) && std::memcmp(magic, kMagic, sizeof(kMagic)) == 0;
+        ::close(fd);
+        return matches;
+    }
+
+    bool loadContainerBlock(const std::string& path, int blockIndex, int numBlocks, VolumeBlock& block) {
+        BrickContainer container;
+        if (!container.open(path)) {
+            return false;
+        }
+
+        block.volume = container.getVolume();
+        int blockGrid[3];
+        computeBlockGrid(numBlocks, blockGrid);
+        block.box = blockBox(block.volume.dimensions, blockGrid, blockIndex);
+        return container.readBox(block.box, block.data);
+    }
+}
@@ -0,0 +1,127 @@
+//
+// Per-brick value ranges and value histograms of volumes.
+//
+
+#include "utils/BrickStatistics.h"
+#include "utils/ParallelUtils.h"
+
+#include <algorithm>
+#include <iostream>
+#include <limits>
+
+namespace liv {
+
+    namespace {
+
+        // scans one brick, accumulating its range and, if histogram is not null, the histogram of its values
+        template <typename V>
+        void scanBrick(const char *volume, const Box& box, const size_t *strides, int binShift, int *histogram,
+                       int& brickMin, int& brickMax) {
+            constexpr size_t kLanes = 16;
+
+            V lo[kLanes];
+            V hi[kLanes];
+            for (size_t j = 0; j < kLanes; j++) {
+                lo[j] = std::numeric_limits<V>::max();
+                hi[j] = 0;
+            }
+
+            for (int z = 0; z < box.extent[2]; z++) {
+                for (int y = 0; y < box.extent[1]; y++) {
+                    const auto *row = reinterpret_cast<const V *>(volume + box.offset[0] * strides[0]
+                        + (box.offset[1] + y) * strides[1] + (box.offset[2] + z) * strides[2]);
+
+                    int x = 0;
+                    for (; x + static_cast<int>(kLanes) <= box.extent[0]; x += kLanes) {
+                        for (size_t j = 0; j < kLanes; j++) {
+                            const V v = row[x + j];
+                            lo[j] = v < lo[j] ? v : lo[j];
+                            hi[j] = v > hi[j] ? v : hi[j];
+                        }
+                    }
+                    for (; x < box.extent[0]; x++) {
+                        lo[0] = row[x] < lo[0] ? row[x] : lo[0];
+                        hi[0] = row[x] > hi[0] ? row[x] : hi[0];
+                    }
+
+                    if (histogram != nullptr) {
+                        for (x = 0; x < box.extent[0]; x++) {
+                            histogram[row[x] >> binShift]++;
+                        }
+                    }
+                }
+            }
+
+            brickMin = *std::min_element(lo, lo + kLanes);
+            brickMax = *std::max_element(hi, hi + kLanes);
+        }
+
+        template <typename V>
+        void scanBricks(const char *volume, const BrickGrid& grid, const int *volumeDimensions, int numBins,
+                        const std::vector<int>& bricks, BrickStatistics& statistics, bool computeHistogram) {
+            const size_t strides[3] = {sizeof(V), sizeof(V) * volumeDimensions[0],
+                                       sizeof(V) * volumeDimensions[0] * volumeDimensions[1]};
+
+            const int valueBits = sizeof(V) * 8;
+            int binBits = 0;
+            while ((1 << binBits) < numBins) {
+                binBits++;
+            }
+            const int binShift = valueBits - binBits;
+
+            const size_t numChunks = getNumParallelChunks(bricks.size(), 1);
+            std::vector<std::vector<int>> partialHistograms(computeHistogram ? numChunks : 0, std::vector<int>(numBins, 0));
+
+            parallelFor(0, bricks.size(), [&](size_t begin, size_t end, size_t chunk) {
+                int *histogram = computeHistogram ? partialHistograms[chunk].data() : nullptr;
+                for (size_t i = begin; i < end; i++) {
+                    const int brick = bricks[i];
+                    scanBrick<V>(volume, grid.brickBox(brick), strides, binShift, histogram,
+                                 statistics.minMax[2 * brick], statistics.minMax[2 * brick + 1]);
+                }
+            }, 1);
+
+            if (computeHistogram) {
+                statistics.histogram.assign(numBins, 0);
+                for (const auto& partial : partialHistograms) {
+                    for (int bin = 0; bin < numBins; bin++) {
+                        statistics.histogram[bin] += partial[bin];
+                    }
+                }
+            }
+        }
+    }
+
+    void computeBrickStatistics(const char *volume, const BrickGrid& grid, const int *volumeDimensions,
+                                bool is16BitData, int numBins, BrickStatistics& statistics) {
+        if (numBins <= 0 || numBins > 256 || (numBins & (numBins - 1)) != 0) {
+            std::cerr << "ERROR: The number of histogram bins must be a power of two no larger than 256. Using 256 bins." << std::endl;
+            numBins = 256;
+        }
+
+        std::vector<int> bricks(grid.numBricks());
+        for (int brick = 0; brick < grid.numBricks(); brick++) {
+            bricks[brick] = brick;
+        }
+
+        statistics.minMax.resize(2 * static_cast<size_t>(grid.numBricks()));
+
+        if (is16BitData) {
+            scanBricks<unsigned short>(volume, grid, volumeDimensions, numBins, bricks, statistics, true);
+        } else {
+            scanBricks<unsigned char>(volume, grid, volumeDimensions, numBins, bricks, statistics, true);
+        }
+    }
+
+    void updateBrickRanges(const char *volume, const BrickGrid& grid, const int *volumeDimensions, bool is16BitData,
+                           const std::vector<int>& bricks, BrickStatistics& statistics) {
+        statistics.minMax.resize(2 * static_cast<size_t>(grid.numBricks()));
+        const int numBins = static_cast<int>(statistics.histogram.size());
+
+        if (is16BitData) {
+            scanBricks<unsigned short>(volume, grid, volumeDimensions, numBins, bricks, statistics, false);
+        } else {
+            scanBricks<unsigned char>(volume, grid, volumeDimensions, numBins, bricks, statistics, false);
+        }
+    }
+}
@@ -0,0 +1,175 @@
+//
+// Brick decomposition of volumes and strided box copies.
+//
+
+#include "utils/Bricking.h"
+#include "utils/ParallelUtils.h"
+
+#include <algorithm>
+#include <cstring>
+
+namespace liv {
+
+    namespace {
+        constexpr uint32_t kPrime1 = 0x9E3779B1u;
+        constexpr uint32_t kPrime2 = 0x85EBCA77u;
+        constexpr uint64_t kPrime64 = 0x9E3779B97F4A7C15ull;
+
+        // number of 32-bit lanes hashed independently
+        constexpr size_t kHashLanes = 16;
+
+        inline uint32_t rotateLeft(uint32_t value, int bits) {
+            return (value << bits) | (value >> (32 - bits));
+        }
+    }
+
+    BrickGrid::BrickGrid(const int *volumeDimensions, const int *brickSize) {
+        for (int d = 0; d < 3; d++) {
+            this->volumeDimensions[d] = volumeDimensions[d];
+            this->brickSize[d] = std::max(1, std::min(brickSize[d], std::max(1, volumeDimensions[d])));
+            brickCounts[d] = (volumeDimensions[d] + this->brickSize[d] - 1) / this->brickSize[d];
+        }
+    }
+
+    Box BrickGrid::brickBox(int brickIndex) const {
+        const int coords[3] = {
+            brickIndex % brickCounts[0],
+            (brickIndex / brickCounts[0]) % brickCounts[1],
+            brickIndex / (brickCounts[0] * brickCounts[1])
+        };
+
+        Box box{};
+        for (int d = 0; d < 3; d++) {
+            box.offset[d] = coords[d] * brickSize[d];
+            box.extent[d] = std::min(brickSize[d], volumeDimensions[d] - box.offset[d]);
+        }
+        return box;
+    }
+
+    std::vector<int> BrickGrid::bricksIntersecting(const int *offset, const int *extent) const {
+        int first[3];
+        int last[3];
+        for (int d = 0; d < 3; d++) {
+            const int begin = std::max(0, offset[d]);
+            const int end = std::min(volumeDimensions[d], offset[d] + extent[d]);
+            if (end <= begin) {
+                return {};
+            }
+            first[d] = begin / brickSize[d];
+            last[d] = (end - 1) / brickSize[d];
+        }
+
+        std::vector<int> bricks;
+        bricks.reserve(static_cast<size_t>(last[0] - first[0] + 1) * (last[1] - first[1] + 1) * (last[2] - first[2] + 1));
+        for (int z = first[2]; z <= last[2]; z++) {
+            for (int y = first[1]; y <= last[1]; y++) {
+                for (int x = first[0]; x <= last[0]; x++) {
+                    bricks.push_back(x + brickCounts[0] * (y + brickCounts[1] * z));
+                }
+            }
+        }
+        return bricks;
+    }
+
+    bool intersectBoxes(const Box& a, const Box& b, Box& result) {
+        for (int axis = 0; axis < 3; axis++) {
+            const int lower = std::max(a.offset[axis], b.offset[axis]);
+            const int upper = std::min(a.offset[axis] + a.extent[axis], b.offset[axis] + b.extent[axis]);
+            if (upper <= lower) {
+                return false;
+            }
+            result.offset[axis] = lower;
+            result.extent[axis] = upper - lower;
+        }
+        return true;
+    }
+
+    Box paddedBox(const Box& box, int ghost) {
+        Box padded = box;
+        for (int axis = 0; axis < 3; axis++) {
+            padded.offset[axis] -= ghost;
+            padded.extent[axis] += 2 * ghost;
+        }
+        return padded;
+    }
+
+    void copyBox(const char *src, const size_t *srcStrides, char *dst, const size_t *dstStrides,
+                 const int *extent, size_t elementSize) {
+        if (extent[0] <= 0 || extent[1] <= 0 || extent[2] <= 0) {
+            return;
+        }
+
+        const size_t numRows = static_cast<size_t>(extent[1]) * extent[2];
+        const size_t rowBytes = static_cast<size_t>(extent[0]) * elementSize;
+        const bool contiguous = srcStrides[0] == elementSize && dstStrides[0] == elementSize;
+
+        parallelFor(0, numRows, [&](size_t begin, size_t end, size_t) {
+            for (size_t row = begin; row < end; row++) {
+                const size_t y = row % extent[1];
+                const size_t z = row / extent[1];
+                const char *srcRow = src + y * srcStrides[1] + z * srcStrides[2];
+                char *dstRow = dst + y * dstStrides[1] + z * dstStrides[2];
+
+                if (contiguous) {
+                    std::memcpy(dstRow, srcRow, rowBytes);
+                } else {
+                    for (int x = 0; x < extent[0]; x++) {
+                        std::memcpy(dstRow + x * dstStrides[0], srcRow + x * srcStrides[0], elementSize);
+                    }
+                }
+            }
+        }, std::max<size_t>(1, (1 << 16) / std::max<size_t>(1, rowBytes)));
+    }
+
+    uint64_t hashBox(const char *src, const size_t *strides, const int *extent, size_t elementSize) {
+        uint32_t lanes[kHashLanes];
+        for (size_t j = 0; j < kHashLanes; j++) {
+            lanes[j] = kPrime1 * static_cast<uint32_t>(j + 1);
+        }
+        uint64_t tail = kPrime64;
+
+        const size_t rowBytes = static_cast<size_t>(extent[0]) * elementSize;
+        const size_t blockBytes = kHashLanes * sizeof(uint32_t);
+
+        for (int z = 0; z < extent[2]; z++) {
+            for (int y = 0; y < extent[1]; y++) {
+                const char *row = src + y * strides[1] + z * strides[2];
+
+                size_t i = 0;
+                for (; i + blockBytes <= rowBytes; i += blockBytes) {
+                    uint32_t words[kHashLanes];
+                    std::memcpy(words, row + i, blockBytes);
+                    for (size_t j = 0; j < kHashLanes; j++) {
+                        lanes[j] = rotateLeft(lanes[j] + words[j] * kPrime2, 13) * kPrime1;
+                    }
+                }
+                for (; i < rowBytes; i++) {
+                    tail = (tail ^ static_cast<unsigned char>(row[i])) * kPrime64;
+                }
+            }
+        }
+
+        uint64_t hash = tail ^ (static_cast<uint64_t>(rowBytes) * extent[1] * extent[2]);
+        for (size_t j = 0; j < kHashLanes; j++) {
+            hash = (hash ^ lanes[j]) * kPrime64;
+            hash ^= hash >> 29;
+        }
+        return hash;
+    }
+
+    std::vector<uint64_t> hashBricks(const char *volume, const BrickGrid& grid, const int *volumeDimensions, size_t elementSize) {
+        std::vector<uint64_t> hashes(grid.numBricks());
+        const size_t strides[3] = {elementSize, elementSize * volumeDimensions[0],
+                                   elementSize * volumeDimensions[0] * volumeDimensions[1]};
+
+        parallelFor(0, hashes.size(), [&](size_t begin, size_t end, size_t) {
+            for (size_t brick = begin; brick < end; brick++) {
+                const Box box = grid.brickBox(static_cast<int>(brick));
+                const char *src = volume + box.offset[0] * strides[0] + box.offset[1] * strides[1] + box.offset[2] * strides[2];
+                hashes[brick] = hashBox(src, strides, box.extent, elementSize);
+            }
+        }, 1);
+
+        return hashes;
+    }
+}
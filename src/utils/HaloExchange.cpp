@@ -0,0 +1,188 @@
+//
+// Exchange of ghost cells between the bricks of neighbouring ranks.
+//
+
+#include "utils/HaloExchange.h"
+
+#include <algorithm>
+#include <cstring>
+#include <iostream>
+
+namespace liv {
+
+    namespace {
+        void byteStrides(const int *extent, size_t elementSize, size_t *strides) {
+            strides[0] = elementSize;
+            strides[1] = elementSize * extent[0];
+            strides[2] = elementSize * extent[0] * extent[1];
+        }
+
+        size_t byteOffset(const Box& box, const size_t *strides) {
+            return box.offset[0] * strides[0] + box.offset[1] * strides[1] + box.offset[2] * strides[2];
+        }
+    }
+
+    HaloExchange::HaloExchange(const Box& box, int ghost, size_t elementSize, MPI_Comm comm)
+        : box(box), padded(paddedBox(box, ghost)), ghost(ghost), elementSize(elementSize) {
+        int rank, numRanks;
+        MPI_Comm_rank(comm, &rank);
+        MPI_Comm_size(comm, &numRanks);
+
+        std::vector<Box> boxes(numRanks);
+        MPI_Allgather(&box, sizeof(Box), MPI_BYTE, boxes.data(), sizeof(Box), MPI_BYTE, comm);
+
+        if (ghost <= 0) {
+            return;
+        }
+
+        for (int r = 0; r < numRanks; r++) {
+            if (r == rank) continue;
+
+            // our voxels in the ghost layer of rank r, and the voxels of rank r in our ghost layer
+            Box overlap{};
+            if (intersectBoxes(box, paddedBox(boxes[r], ghost), overlap)) {
+                for (int axis = 0; axis < 3; axis++) {
+                    overlap.offset[axis] -= box.offset[axis];
+                }
+                sends.push_back({r, overlap, std::vector<char>(overlap.numVoxels() * elementSize)});
+            }
+            if (intersectBoxes(boxes[r], padded, overlap)) {
+                for (int axis = 0; axis < 3; axis++) {
+                    overlap.offset[axis] -= padded.offset[axis];
+                }
+                receives.push_back({r, overlap, std::vector<char>(overlap.numVoxels() * elementSize)});
+            }
+        }
+
+        requests.resize(receives.size() + sends.size(), MPI_REQUEST_NULL);
+        for (size_t m = 0; m < receives.size(); m++) {
+            auto& message = receives[m];
+            MPI_Recv_init(message.buffer.data(), static_cast<int>(message.buffer.size()), MPI_BYTE, message.rank,
+                          haloTag, comm, &requests[m]);
+        }
+        for (size_t m = 0; m < sends.size(); m++) {
+            auto& message = sends[m];
+            MPI_Send_init(message.buffer.data(), static_cast<int>(message.buffer.size()), MPI_BYTE, message.rank,
+                          haloTag, comm, &requests[receives.size() + m]);
+        }
+    }
+
+    HaloExchange::~HaloExchange() {
+        // requests cannot be freed any more once MPI is finalized
+        int finalized = 0;
+        MPI_Finalized(&finalized);
+        if (finalized) {
+            return;
+        }
+
+        if (inFlight) {
+            MPI_Waitall(static_cast<int>(requests.size()), requests.data(), MPI_STATUSES_IGNORE);
+        }
+        for (auto& request : requests) {
+            if (request != MPI_REQUEST_NULL) {
+                MPI_Request_free(&request);
+            }
+        }
+    }
+
+    bool HaloExchange::start(const char *interior) {
+        if (inFlight) {
+            std::cerr << "ERROR: Halo exchange started while the previous one is still in flight" << std::endl;
+            return false;
+        }
+        if (requests.empty()) {
+            return true;
+        }
+
+        size_t strides[3];
+        byteStrides(box.extent, elementSize, strides);
+
+        // receives are started first, so that they are posted before the matching sends arrive
+        if (!receives.empty()
+            && MPI_Startall(static_cast<int>(receives.size()), requests.data()) != MPI_SUCCESS) {
+            std::cerr << "ERROR: Could not start receiving the halo from neighbouring ranks" << std::endl;
+            return false;
+        }
+        inFlight = true;
+
+        for (auto& message : sends) {
+            size_t packedStrides[3];
+            byteStrides(message.box.extent, elementSize, packedStrides);
+            copyBox(interior + byteOffset(message.box, strides), strides, message.buffer.data(), packedStrides,
+                    message.box.extent, elementSize);
+        }
+
+        if (!sends.empty() && MPI_Startall(static_cast<int>(sends.size()), requests.data() + receives.size())
+                              != MPI_SUCCESS) {
+            std::cerr << "ERROR: Could not start sending the halo to neighbouring ranks" << std::endl;
+            return false;
+        }
+        return true;
+    }
+
+    void HaloExchange::copyInterior(const char *interior, char *paddedData) const {
+        const size_t rowBytes = box.extent[0] * elementSize;
+        size_t strides[3];
+        byteStrides(box.extent, elementSize, strides);
+        size_t paddedStrides[3];
+        byteStrides(padded.extent, elementSize, paddedStrides);
+
+        for (int z = 0; z < padded.extent[2]; z++) {
+            const int sourceZ = std::clamp(z - ghost, 0, box.extent[2] - 1);
+            for (int y = 0; y < padded.extent[1]; y++) {
+                const int sourceY = std::clamp(y - ghost, 0, box.extent[1] - 1);
+                const char *source = interior + sourceZ * strides[2] + sourceY * strides[1];
+                char *target = paddedData + z * paddedStrides[2] + y * paddedStrides[1];
+
+                for (int x = 0; x < ghost; x++) {
+                    std::memcpy(target + x * elementSize, source, elementSize);
+                }
+                std::memcpy(target + ghost * elementSize, source, rowBytes);
+                for (int x = 0; x < ghost; x++) {
+                    std::memcpy(target + (ghost + box.extent[0] + x) * elementSize, source + rowBytes - elementSize,
+                                elementSize);
+                }
+            }
+        }
+    }
+
+    bool HaloExchange::finish(char *paddedData) {
+        if (!inFlight) {
+            return true;
+        }
+        inFlight = false;
+
+        if (MPI_Waitall(static_cast<int>(requests.size()), requests.data(), MPI_STATUSES_IGNORE) != MPI_SUCCESS) {
+            std::cerr << "ERROR: Could not exchange the halo with neighbouring ranks" << std::endl;
+            return false;
+        }
+
+        size_t paddedStrides[3];
+        byteStrides(padded.extent, elementSize, paddedStrides);
+        for (const auto& message : receives) {
+            size_t packedStrides[3];
+            byteStrides(message.box.extent, elementSize, packedStrides);
+            copyBox(message.buffer.data(), packedStrides, paddedData + byteOffset(message.box, paddedStrides),
+                    paddedStrides, message.box.extent, elementSize);
+        }
+        return true;
+    }
+
+    bool HaloExchange::exchange(const char *interior, char *paddedData) {
+        const bool started = start(interior);
+        copyInterior(interior, paddedData);
+        return finish(paddedData) && started;
+    }
+
+    std::vector<int> HaloExchange::getNeighbours() const {
+        std::vector<int> neighbours;
+        for (const auto* messages : {&sends, &receives}) {
+            for (const auto& message : *messages) {
+                neighbours.push_back(message.rank);
+            }
+        }
+        std::sort(neighbours.begin(), neighbours.end());
+        neighbours.erase(std::unique(neighbours.begin(), neighbours.end()), neighbours.end());
+        return neighbours;
+    }
+}
@@ -0,0 +1,223 @@
+//
+// Resolution of the JVM configuration on one rank and its distribution to all ranks.
+//
+
+#include "utils/JVMConfiguration.h"
+#include "utils/NativeLibraryCache.h"
+
+#include <cstdint>
+#include <cstdlib>
+#include <cstring>
+#include <dirent.h>
+#include <fstream>
+#include <iostream>
+
+namespace liv {
+
+    namespace {
+        std::string envOrEmpty(const char *name) {
+            const char *value = getenv(name);
+            return value == nullptr ? std::string() : std::string(value);
+        }
+
+        std::string envOrDefault(const char *name, const char *defaultValue) {
+            const char *value = getenv(name);
+            return value == nullptr ? std::string(defaultValue) : std::string(value);
+        }
+
+        void writeString(std::vector<char>& buffer, const std::string& value) {
+            const auto length = static_cast<uint32_t>(value.size());
+            const char *lengthBytes = reinterpret_cast<const char *>(&length);
+            buffer.insert(buffer.end(), lengthBytes, lengthBytes + sizeof(length));
+            buffer.insert(buffer.end(), value.begin(), value.end());
+        }
+
+        bool readString(const std::vector<char>& buffer, size_t& position, std::string& value) {
+            uint32_t length;
+            if (position + sizeof(length) > buffer.size()) {
+                return false;
+            }
+            std::memcpy(&length, buffer.data() + position, sizeof(length));
+            position += sizeof(length);
+
+            if (position + length > buffer.size()) {
+                return false;
+            }
+            value.assign(buffer.data() + position, length);
+            position += length;
+            return true;
+        }
+    }
+
+    bool readJVMConfiguration(JVMConfiguration& configuration) {
+        const char *directory = getenv("SCENERY_CLASS_PATH");
+        if (directory == nullptr) {
+            std::cerr << "ERROR: SCENERY_CLASS_PATH environment variable is not set." << std::endl;
+            return false;
+        }
+
+        DIR *dir = opendir(directory);
+        if (dir == nullptr) {
+            std::cerr << "ERROR: Could not open directory " << directory << std::endl;
+            return false;
+        }
+
+        configuration.classPath.clear();
+        struct dirent *ent;
+        while ((ent = readdir(dir)) != nullptr) {
+            configuration.classPath.append(directory);
+            configuration.classPath.append(ent->d_name);
+            configuration.classPath.append(":");
+        }
+        closedir(dir);
+
+        configuration.fileOptions.clear();
+        std::ifstream optionsFile("liv_jvm_options.txt");
+        if (optionsFile.is_open()) {
+            std::cout << "Found additional JVM options file, reading options..." << std::endl;
+            std::string line;
+            while (std::getline(optionsFile, line)) {
+                if (!line.empty()) {
+                    configuration.fileOptions.push_back(line);
+                }
+            }
+        } else {
+            std::cout << "Did not find additional JVM options file, using default options. If you want to use custom options, "
+                         "please create a file named liv_jvm_options.txt in the current directory." << std::endl;
+        }
+
+        configuration.headless = envOrDefault("SCENERY_HEADLESS", "true");
+        configuration.benchmark = envOrEmpty("LiV-Test-Benchmark");
+        configuration.mpiJniLibPath = envOrDefault("MPI_JNI_LIB_PATH", "/usr/local/lib/");
+        readRankEnvironment(configuration);
+        configuration.nativesFingerprint = fingerprintNativeJars(configuration.classPath);
+        configuration.classDataArchiveDirectory = envOrEmpty("LIV_CDS_ARCHIVE_DIR");
+
+        return true;
+    }
+
+    void readRankEnvironment(JVMConfiguration& configuration) {
+        configuration.lwjglSharedPath = envOrDefault("LWJGL_SHARED_PATH", "/tmp/");
+        configuration.lwjglLibraryPath = envOrDefault("LWJGL_LIBRARY_PATH", "/tmp/");
+        configuration.gpuId = envOrEmpty("SCENERY_GPU_ID");
+    }
+
+    std::vector<char> serializeJVMConfiguration(const JVMConfiguration& configuration) {
+        std::vector<char> buffer;
+        writeString(buffer, configuration.classPath);
+        writeString(buffer, configuration.headless);
+        writeString(buffer, configuration.benchmark);
+        writeString(buffer, configuration.mpiJniLibPath);
+        writeString(buffer, std::to_string(configuration.nativesFingerprint));
+        writeString(buffer, configuration.classDataArchiveDirectory);
+        writeString(buffer, std::to_string(configuration.fileOptions.size()));
+        for (const auto& option : configuration.fileOptions) {
+            writeString(buffer, option);
+        }
+        return buffer;
+    }
+
+    bool deserializeJVMConfiguration(const std::vector<char>& buffer, JVMConfiguration& configuration) {
+        size_t position = 0;
+        std::string nativesFingerprint;
+        std::string numFileOptions;
+
+        if (!readString(buffer, position, configuration.classPath) ||
+            !readString(buffer, position, configuration.headless) ||
+            !readString(buffer, position, configuration.benchmark) ||
+            !readString(buffer, position, configuration.mpiJniLibPath) ||
+            !readString(buffer, position, nativesFingerprint) ||
+            !readString(buffer, position, configuration.classDataArchiveDirectory) ||
+            !readString(buffer, position, numFileOptions)) {
+            return false;
+        }
+
+        configuration.nativesFingerprint = std::strtoull(nativesFingerprint.c_str(), nullptr, 10);
+        configuration.fileOptions.resize(std::strtoul(numFileOptions.c_str(), nullptr, 10));
+        for (auto& option : configuration.fileOptions) {
+            if (!readString(buffer, position, option)) {
+                return false;
+            }
+        }
+        return position == buffer.size();
+    }
+
+    bool broadcastJVMConfiguration(JVMConfiguration& configuration, int root, MPI_Comm comm) {
+        int rank;
+        MPI_Comm_rank(comm, &rank);
+
+        std::vector<char> buffer;
+        // a size of 0 signals that the root could not read the configuration
+        long long size = 0;
+
+        if (rank == root && readJVMConfiguration(configuration)) {
+            buffer = serializeJVMConfiguration(configuration);
+            size = static_cast<long long>(buffer.size());
+        }
+
+        MPI_Bcast(&size, 1, MPI_LONG_LONG, root, comm);
+        if (size == 0) {
+            return false;
+        }
+
+        buffer.resize(size);
+        MPI_Bcast(buffer.data(), static_cast<int>(size), MPI_CHAR, root, comm);
+
+        if (rank != root) {
+            if (!deserializeJVMConfiguration(buffer, configuration)) {
+                std::cerr << "ERROR: Received a malformed JVM configuration." << std::endl;
+                return false;
+            }
+            readRankEnvironment(configuration);
+        }
+        return true;
+    }
+
+    std::vector<std::string> buildJVMOptions(const JVMConfiguration& configuration, int rank,
+                                             const JVMNodeOptions& nodeOptions) {
+        const auto rankString = std::to_string(rank);
+        const auto& nativeLibraryDirectory = nodeOptions.nativeLibraryDirectory;
+
+        const auto extractPath = nativeLibraryDirectory.empty() ? configuration.lwjglSharedPath + "/rank" + rankString : nativeLibraryDirectory;
+        const auto libraryPath = nativeLibraryDirectory.empty() ? configuration.lwjglLibraryPath + "/rank" + rankString : nativeLibraryDirectory;
+
+        std::vector<std::string> options = {
+            "-Djava.class.path=" + configuration.classPath,
+            "-Dscenery.VulkanRenderer.EnableValidations=false",
+            "-Dorg.lwjgl.system.stackSize=1000",
+            "-Dscenery.Headless=" + configuration.headless,
+            "-Dscenery.LogLevel=info",
+            "-Dorg.lwjgl.system.SharedLibraryExtractPath=" + extractPath,
+            "-Dorg.lwjgl.librarypath=" + libraryPath,
+            "-Djava.library.path=" + configuration.mpiJniLibPath,
+            "-Dscenery.Renderer.DeviceId=" + (configuration.gpuId.empty() ? rankString : configuration.gpuId)
+        };
+
+        if (!nodeOptions.classDataArchive.empty()) {
+            // the JVM falls back to regular class loading if the archive does not match the class path or JDK
+            if (nodeOptions.recordClassDataArchive) {
+                options.emplace_back("-XX:+AutoCreateSharedArchive");
+            }
+            options.push_back("-XX:SharedArchiveFile=" + nodeOptions.classDataArchive);
+        }
+
+        options.insert(options.end(), configuration.fileOptions.begin(), configuration.fileOptions.end());
+
+        // Handle LiV-Test-Benchmark environment variable and add JVM options accordingly
+        if ((configuration.benchmark.empty() || configuration.benchmark == "false") && rank == 0) {
+            options.emplace_back("-Dscenery.ServerAddress=tcp://127.0.0.1");
+            options.emplace_back("-Dscenery.RemoteCamera=true");
+        } else if (configuration.benchmark == "true") {
+            options.emplace_back("-Dscenery.LiV-Test-Benchmark=true");
+        }
+
+        return options;
+    }
+
+    std::string classDataArchivePath(const JVMConfiguration& configuration, const std::string& nodeName) {
+        if (configuration.classDataArchiveDirectory.empty()) {
+            return "";
+        }
+        return configuration.classDataArchiveDirectory + "/liv-" + nodeName + ".jsa";
+    }
+}
@@ -0,0 +1,139 @@
+//
+// Multiresolution pyramids of volumes.
+//
+
+#include "utils/LevelOfDetail.h"
+#include "utils/ParallelUtils.h"
+
+#include <algorithm>
+
+namespace liv {
+
+    namespace {
+
+        template <typename V, DownsamplingFilter filter>
+        inline V combine(V a, V b, V c, V d, V e, V f, V g, V h) {
+            if constexpr (filter == DownsamplingFilter::Max) {
+                return std::max(std::max(std::max(a, b), std::max(c, d)), std::max(std::max(e, f), std::max(g, h)));
+            } else {
+                const unsigned int sum = static_cast<unsigned int>(a) + b + c + d + e + f + g + h;
+                return static_cast<V>((sum + 4) >> 3);
+            }
+        }
+
+        // computes the voxels of the given box of the destination level from the source level
+        template <typename V, DownsamplingFilter filter>
+        void downsampleBox(const V *src, const int *srcDims, V *dst, const int *dstDims, const Box& box) {
+            const size_t srcRow = srcDims[0];
+            const size_t srcSlice = srcRow * srcDims[1];
+            const size_t numRows = static_cast<size_t>(box.extent[1]) * box.extent[2];
+
+            parallelFor(0, numRows, [&](size_t begin, size_t end, size_t) {
+                for (size_t r = begin; r < end; r++) {
+                    const int y = box.offset[1] + static_cast<int>(r % box.extent[1]);
+                    const int z = box.offset[2] + static_cast<int>(r / box.extent[1]);
+
+                    // odd source dimensions replicate the last voxel
+                    const size_t y0 = 2 * y;
+                    const size_t y1 = std::min(2 * y + 1, srcDims[1] - 1);
+                    const size_t z0 = 2 * z;
+                    const size_t z1 = std::min(2 * z + 1, srcDims[2] - 1);
+
+                    const V *r00 = src + y0 * srcRow + z0 * srcSlice;
+                    const V *r01 = src + y1 * srcRow + z0 * srcSlice;
+                    const V *r10 = src + y0 * srcRow + z1 * srcSlice;
+                    const V *r11 = src + y1 * srcRow + z1 * srcSlice;
+                    V *out = dst + static_cast<size_t>(y) * dstDims[0] + static_cast<size_t>(z) * dstDims[0] * dstDims[1];
+
+                    int x = box.offset[0];
+                    const int pairedEnd = std::min(box.offset[0] + box.extent[0], srcDims[0] / 2);
+                    for (; x < pairedEnd; x++) {
+                        const size_t x0 = 2 * x;
+                        out[x] = combine<V, filter>(r00[x0], r00[x0 + 1], r01[x0], r01[x0 + 1],
+                                                    r10[x0], r10[x0 + 1], r11[x0], r11[x0 + 1]);
+                    }
+                    for (; x < box.offset[0] + box.extent[0]; x++) {
+                        const size_t x0 = 2 * x;
+                        const size_t x1 = std::min(2 * x + 1, srcDims[0] - 1);
+                        out[x] = combine<V, filter>(r00[x0], r00[x1], r01[x0], r01[x1],
+                                                    r10[x0], r10[x1], r11[x0], r11[x1]);
+                    }
+                }
+            }, std::max<size_t>(1, (1 << 14) / std::max(1, box.extent[0])));
+        }
+
+        template <typename V>
+        void downsample(const char *src, const int *srcDims, char *dst, const int *dstDims, const Box& box,
+                        DownsamplingFilter filter) {
+            if (filter == DownsamplingFilter::Max) {
+                downsampleBox<V, DownsamplingFilter::Max>(reinterpret_cast<const V *>(src), srcDims,
+                                                          reinterpret_cast<V *>(dst), dstDims, box);
+            } else {
+                downsampleBox<V, DownsamplingFilter::Box>(reinterpret_cast<const V *>(src), srcDims,
+                                                          reinterpret_cast<V *>(dst), dstDims, box);
+            }
+        }
+
+        void downsampleLevel(const char *src, const int *srcDims, VolumeLevel& level, const Box& box,
+                             bool is16BitData, DownsamplingFilter filter) {
+            if (is16BitData) {
+                downsample<unsigned short>(src, srcDims, level.data.data(), level.dimensions, box, filter);
+            } else {
+                downsample<unsigned char>(src, srcDims, level.data.data(), level.dimensions, box, filter);
+            }
+        }
+    }
+
+    void buildLevels(const char *volume, const int *dimensions, bool is16BitData, int numLevels,
+                     DownsamplingFilter filter, std::vector<VolumeLevel>& levels) {
+        const size_t elementSize = is16BitData ? 2 : 1;
+
+        int levelDims[3] = {dimensions[0], dimensions[1], dimensions[2]};
+        int count = 0;
+        while (count < numLevels && (levelDims[0] > 1 || levelDims[1] > 1 || levelDims[2] > 1)) {
+            for (int& d : levelDims) {
+                d = (d + 1) / 2;
+            }
+            count++;
+        }
+        levels.resize(count);
+
+        const char *src = volume;
+        const int *srcDims = dimensions;
+
+        for (auto& level : levels) {
+            for (int d = 0; d < 3; d++) {
+                level.dimensions[d] = (srcDims[d] + 1) / 2;
+            }
+            level.data.resize(static_cast<size_t>(level.dimensions[0]) * level.dimensions[1] * level.dimensions[2] * elementSize);
+
+            const Box box{{0, 0, 0}, {level.dimensions[0], level.dimensions[1], level.dimensions[2]}};
+            downsampleLevel(src, srcDims, level, box, is16BitData, filter);
+
+            src = level.data.data();
+            srcDims = level.dimensions;
+        }
+    }
+
+    void updateLevels(const char *volume, const int *dimensions, bool is16BitData, const Box& region,
+                      DownsamplingFilter filter, std::vector<VolumeLevel>& levels) {
+        const char *src = volume;
+        const int *srcDims = dimensions;
+        Box box = region;
+
+        for (auto& level : levels) {
+            // the voxels of this level that depend on the changed voxels of the previous one
+            for (int d = 0; d < 3; d++) {
+                const int begin = box.offset[d] / 2;
+                const int end = std::min(level.dimensions[d], (box.offset[d] + box.extent[d] + 1) / 2);
+                box.offset[d] = begin;
+                box.extent[d] = end - begin;
+            }
+
+            downsampleLevel(src, srcDims, level, box, is16BitData, filter);
+
+            src = level.data.data();
+            srcDims = level.dimensions;
+        }
+    }
+}
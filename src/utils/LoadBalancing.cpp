@@ -0,0 +1,128 @@
+//
+// Planning of brick moves between ranks to equalize their render time.
+//
+
+#include "utils/LoadBalancing.h"
+
+#include <algorithm>
+#include <cmath>
+#include <numeric>
+
+namespace liv {
+
+    namespace {
+        // bricks only touching at a face do not overlap
+        bool overlaps(const BrickBounds& a, const BrickBounds& b) {
+            for (int axis = 0; axis < 3; axis++) {
+                if (a.lower[axis] >= b.upper[axis] || b.lower[axis] >= a.upper[axis]) {
+                    return false;
+                }
+            }
+            return true;
+        }
+
+        // whether the box enclosing the bricks of rank and the given brick overlaps no brick of another rank
+        bool keepsBoxesDisjoint(const std::vector<BrickBounds>& bounds, const std::vector<int>& owners, int brick,
+                                int rank) {
+            BrickBounds box = bounds[brick];
+            for (size_t b = 0; b < bounds.size(); b++) {
+                if (owners[b] != rank) continue;
+                for (int axis = 0; axis < 3; axis++) {
+                    box.lower[axis] = std::min(box.lower[axis], bounds[b].lower[axis]);
+                    box.upper[axis] = std::max(box.upper[axis], bounds[b].upper[axis]);
+                }
+            }
+
+            for (size_t b = 0; b < bounds.size(); b++) {
+                if (static_cast<int>(b) != brick && owners[b] != rank && overlaps(box, bounds[b])) {
+                    return false;
+                }
+            }
+            return true;
+        }
+    }
+
+    std::vector<double> computeRankLoads(const std::vector<double>& costs, const std::vector<int>& owners, int numRanks) {
+        std::vector<double> loads(numRanks, 0.0);
+        for (size_t brick = 0; brick < costs.size(); brick++) {
+            loads[owners[brick]] += costs[brick];
+        }
+        return loads;
+    }
+
+    std::vector<BrickMigration> planBrickMigrations(const std::vector<double>& costs, const std::vector<int>& owners,
+                                                    int numRanks, double tolerance, int maxMigrations,
+                                                    const std::vector<BrickBounds>& bounds) {
+        std::vector<int> newOwners(owners);
+        auto loads = computeRankLoads(costs, owners, numRanks);
+        const double mean = std::accumulate(loads.begin(), loads.end(), 0.0) / numRanks;
+
+        for (int move = 0; move < maxMigrations; move++) {
+            int busiest = 0;
+            for (int rank = 1; rank < numRanks; rank++) {
+                busiest = loads[rank] > loads[busiest] ? rank : busiest;
+            }
+
+            if (loads[busiest] <= mean * (1.0 + tolerance)) {
+                break;
+            }
+
+            // the least loaded ranks first, stable so that all ranks agree on the order of equal loads
+            std::vector<int> receivers(numRanks);
+            std::iota(receivers.begin(), receivers.end(), 0);
+            std::stable_sort(receivers.begin(), receivers.end(), [&loads](int a, int b) { return loads[a] < loads[b]; });
+
+            int best = -1;
+            int receiver = -1;
+            for (int candidate : receivers) {
+                if (loads[candidate] >= loads[busiest]) {
+                    break;
+                }
+
+                // moving a brick of cost c changes the difference between both ranks to |gap - 2c|
+                const double gap = loads[busiest] - loads[candidate];
+                for (size_t brick = 0; brick < costs.size(); brick++) {
+                    if (newOwners[brick] != busiest || costs[brick] <= 0.0 || costs[brick] >= gap) {
+                        continue;
+                    }
+                    if (best >= 0 && std::abs(gap / 2 - costs[brick]) >= std::abs(gap / 2 - costs[best])) {
+                        continue;
+                    }
+                    if (!bounds.empty() && !keepsBoxesDisjoint(bounds, newOwners, static_cast<int>(brick), candidate)) {
+                        continue;
+                    }
+                    best = static_cast<int>(brick);
+                }
+
+                if (best >= 0) {
+                    receiver = candidate;
+                    break;
+                }
+            }
+
+            if (best < 0) {
+                break;
+            }
+
+            newOwners[best] = receiver;
+            loads[busiest] -= costs[best];
+            loads[receiver] += costs[best];
+        }
+
+        // a brick moved several times only travels once, from its original to its final owner
+        std::vector<BrickMigration> migrations;
+        for (size_t brick = 0; brick < owners.size(); brick++) {
+            if (newOwners[brick] != owners[brick]) {
+                migrations.push_back({static_cast<int>(brick), owners[brick], newOwners[brick]});
+            }
+        }
+        return migrations;
+    }
+
+    double smoothCost(double previous, double measured, double weight) {
+        if (previous < 0.0) {
+            return measured;
+        }
+        return weight * measured + (1.0 - weight) * previous;
+    }
+}
@@ -0,0 +1,180 @@
+//
+// Node-local cache of the native libraries extracted by LWJGL.
+//
+
+#include "utils/NativeLibraryCache.h"
+#include "utils/JVMConfiguration.h"
+
+#include <filesystem>
+#include <fstream>
+#include <iostream>
+#include <sstream>
+#include <system_error>
+#include <vector>
+
+namespace liv {
+
+    namespace {
+        constexpr uint64_t kFnvOffset = 0xcbf29ce484222325ull;
+        constexpr uint64_t kFnvPrime = 0x100000001b3ull;
+
+        constexpr const char *kManifestName = "liv-natives.manifest";
+
+        uint64_t hashBytes(uint64_t hash, const char *data, size_t size) {
+            for (size_t i = 0; i < size; i++) {
+                hash = (hash ^ static_cast<unsigned char>(data[i])) * kFnvPrime;
+            }
+            return hash;
+        }
+
+        // the extracted files, i.e. all regular files except the manifest and any temporary manifest left behind by an
+        // interrupted run
+        std::vector<std::filesystem::path> extractedFiles(const std::string& directory) {
+            std::vector<std::filesystem::path> files;
+            std::error_code error;
+            for (const auto& entry : std::filesystem::recursive_directory_iterator(directory, error)) {
+                if (entry.is_regular_file() && entry.path().filename().string().rfind(kManifestName, 0) != 0) {
+                    files.push_back(entry.path());
+                }
+            }
+            return files;
+        }
+
+        bool hashFile(const std::filesystem::path& path, uint64_t& hash) {
+            std::ifstream file(path, std::ios::binary);
+            if (!file.is_open()) {
+                return false;
+            }
+
+            hash = kFnvOffset;
+            std::vector<char> chunk(1 << 20);
+            while (file) {
+                file.read(chunk.data(), static_cast<std::streamsize>(chunk.size()));
+                hash = hashBytes(hash, chunk.data(), static_cast<size_t>(file.gcount()));
+            }
+            return true;
+        }
+    }
+
+    uint64_t fingerprintNativeJars(const std::string& classPath) {
+        uint64_t fingerprint = kFnvOffset;
+
+        std::stringstream entries(classPath);
+        std::string entry;
+        while (std::getline(entries, entry, ':')) {
+            const auto name = std::filesystem::path(entry).filename().string();
+            if (name.find("natives") == std::string::npos || name.size() < 4 || name.compare(name.size() - 4, 4, ".jar") != 0) {
+                continue;
+            }
+
+            std::error_code error;
+            const auto size = std::filesystem::file_size(entry, error);
+            const auto modified = std::filesystem::last_write_time(entry, error).time_since_epoch().count();
+
+            fingerprint = hashBytes(fingerprint, name.data(), name.size());
+            fingerprint = hashBytes(fingerprint, reinterpret_cast<const char *>(&size), sizeof(size));
+            fingerprint = hashBytes(fingerprint, reinterpret_cast<const char *>(&modified), sizeof(modified));
+        }
+        return fingerprint;
+    }
+
+    std::string nativeLibraryDirectory(const JVMConfiguration& configuration) {
+        std::stringstream directory;
+        directory << configuration.lwjglSharedPath << "/liv-natives-" << std::hex << configuration.nativesFingerprint;
+        return directory.str();
+    }
+
+    bool isNativeLibraryCacheValid(const std::string& directory) {
+        std::ifstream manifest(std::filesystem::path(directory) / kManifestName);
+        if (!manifest.is_open()) {
+            return false;
+        }
+
+        uint64_t expectedHash;
+        uintmax_t expectedSize;
+        std::string name;
+        size_t numFiles = 0;
+        while (manifest >> std::hex >> expectedHash >> std::dec >> expectedSize && std::getline(manifest >> std::ws, name)) {
+            const auto path = std::filesystem::path(directory) / name;
+
+            std::error_code error;
+            uint64_t hash;
+            if (std::filesystem::file_size(path, error) != expectedSize || error || !hashFile(path, hash) || hash != expectedHash) {
+                std::cout << "Native library cache in " << directory << " is stale: " << name << " changed" << std::endl;
+                return false;
+            }
+            numFiles++;
+        }
+
+        // LWJGL extracts libraries lazily, so files missing from the manifest were extracted after it was written
+        if (manifest.eof() && extractedFiles(directory).size() != numFiles) {
+            std::cout << "Native library cache in " << directory << " is incomplete: files were extracted after the "
+                         "manifest was written" << std::endl;
+            return false;
+        }
+
+        // an extraction that produced no files is not worth sharing
+        return manifest.eof() && numFiles > 0;
+    }
+
+    bool isNativeLibraryCacheValidOnNode(const std::string& directory, MPI_Comm nodeComm) {
+        int nodeRank;
+        MPI_Comm_rank(nodeComm, &nodeRank);
+
+        int valid = 0;
+        if (nodeRank == 0) {
+            std::error_code error;
+            std::filesystem::create_directories(directory, error);
+            if (error) {
+                std::cerr << "ERROR: Could not create native library directory " << directory << ": " << error.message() << std::endl;
+            }
+            valid = isNativeLibraryCacheValid(directory);
+        }
+
+        MPI_Bcast(&valid, 1, MPI_INT, 0, nodeComm);
+        return valid != 0;
+    }
+
+    bool writeNativeLibraryCacheManifest(const std::string& directory) {
+        std::stringstream contents;
+
+        std::error_code error;
+        for (const auto& path : extractedFiles(directory)) {
+            uint64_t hash;
+            if (!hashFile(path, hash)) {
+                std::cerr << "ERROR: Could not read extracted library " << path << std::endl;
+                return false;
+            }
+            contents << std::hex << hash << std::dec << " " << std::filesystem::file_size(path, error) << " "
+                     << std::filesystem::relative(path, directory).string() << "\n";
+        }
+
+        // write to a temporary file first, so that a partially written manifest is never considered valid
+        const auto manifestPath = std::filesystem::path(directory) / kManifestName;
+        const auto temporaryPath = std::filesystem::path(directory) / (std::string(kManifestName) + ".tmp");
+        {
+            std::ofstream manifest(temporaryPath, std::ios::trunc);
+            manifest << contents.str();
+            if (!manifest) {
+                std::cerr << "ERROR: Could not write native library manifest in " << directory << std::endl;
+                return false;
+            }
+        }
+        std::filesystem::rename(temporaryPath, manifestPath, error);
+        return !error;
+    }
+
+    void recordNativeLibraryCacheOnNode(const std::string& directory, MPI_Comm nodeComm, int& recorded, MPI_Request& request) {
+        recorded = writeNativeLibraryCacheManifest(directory);
+        // the other ranks only take part once they need their JVM, so this rank does not wait for them here
+        MPI_Ibcast(&recorded, 1, MPI_INT, 0, nodeComm, &request);
+    }
+
+    bool waitForNativeLibraryCacheOnNode(MPI_Comm nodeComm) {
+        int recorded = 0;
+        MPI_Request request;
+        MPI_Ibcast(&recorded, 1, MPI_INT, 0, nodeComm, &request);
+        MPI_Wait(&request, MPI_STATUS_IGNORE);
+        return recorded != 0;
+    }
+}
@@ -0,0 +1,298 @@
+//
+// Deposition of particles onto the grid of a distributed volume.
+//
+
+#include "utils/ParticleDeposition.h"
+
+#include <algorithm>
+#include <cmath>
+#include <iostream>
+
+#include "utils/ParallelUtils.h"
+
+namespace liv {
+
+    namespace {
+        template<DepositionKernel K>
+        constexpr int kernelSupport() {
+            if constexpr (K == DepositionKernel::NearestGridPoint) {
+                return 1;
+            } else if constexpr (K == DepositionKernel::CloudInCell) {
+                return 2;
+            } else {
+                return 3;
+            }
+        }
+
+        // computes the weights of the cells a particle at u, in cell coordinates, contributes to along one axis, and
+        // returns the first of these cells
+        template<DepositionKernel K>
+        inline int axisWeights(float u, float *weights) {
+            if constexpr (K == DepositionKernel::NearestGridPoint) {
+                weights[0] = 1.0f;
+                return static_cast<int>(std::floor(u));
+            } else if constexpr (K == DepositionKernel::CloudInCell) {
+                const float s = u - 0.5f;
+                const int first = static_cast<int>(std::floor(s));
+                const float f = s - static_cast<float>(first);
+                weights[0] = 1.0f - f;
+                weights[1] = f;
+                return first;
+            } else {
+                const int cell = static_cast<int>(std::floor(u));
+                const float d = u - (static_cast<float>(cell) + 0.5f);
+                weights[0] = 0.5f * (0.5f - d) * (0.5f - d);
+                weights[1] = 0.75f - d * d;
+                weights[2] = 0.5f * (0.5f + d) * (0.5f + d);
+                return cell - 1;
+            }
+        }
+
+        template<DepositionKernel K>
+        void depositRange(const float *positions, const float *weights, size_t begin, size_t end,
+                          const float *lower, const float *inverseCellSize, const int *dimensions, float *cells) {
+            constexpr int support = kernelSupport<K>();
+            const size_t strideY = static_cast<size_t>(dimensions[0]);
+            const size_t strideZ = strideY * dimensions[1];
+
+            for (size_t p = begin; p < end; p++) {
+                float axis[3][support];
+                int first[3];
+                bool inside = true;
+
+                for (int a = 0; a < 3; a++) {
+                    const float u = (positions[3 * p + a] - lower[a]) * inverseCellSize[a];
+                    // also rejects NaN, before converting to int
+                    if (!(u > -support && u < static_cast<float>(dimensions[a] + support))) {
+                        inside = false;
+                        break;
+                    }
+                    first[a] = axisWeights<K>(u, axis[a]);
+                }
+                if (!inside) {
+                    continue;
+                }
+
+                const float weight = weights != nullptr ? weights[p] : 1.0f;
+                for (int z = 0; z < support; z++) {
+                    const int k = first[2] + z;
+                    if (k < 0 || k >= dimensions[2]) continue;
+                    const float wz = weight * axis[2][z];
+                    for (int y = 0; y < support; y++) {
+                        const int j = first[1] + y;
+                        if (j < 0 || j >= dimensions[1]) continue;
+                        const float wyz = wz * axis[1][y];
+                        float *row = cells + k * strideZ + j * strideY;
+                        for (int x = 0; x < support; x++) {
+                            const int i = first[0] + x;
+                            if (i < 0 || i >= dimensions[0]) continue;
+                            row[i] += wyz * axis[0][x];
+                        }
+                    }
+                }
+            }
+        }
+
+        void depositRange(DepositionKernel kernel, const float *positions, const float *weights, size_t begin,
+                          size_t end, const float *lower, const float *inverseCellSize, const int *dimensions,
+                          float *cells) {
+            switch (kernel) {
+                case DepositionKernel::NearestGridPoint:
+                    depositRange<DepositionKernel::NearestGridPoint>(positions, weights, begin, end, lower,
+                                                                     inverseCellSize, dimensions, cells);
+                    break;
+                case DepositionKernel::CloudInCell:
+                    depositRange<DepositionKernel::CloudInCell>(positions, weights, begin, end, lower,
+                                                                inverseCellSize, dimensions, cells);
+                    break;
+                case DepositionKernel::TriangularShapedCloud:
+                    depositRange<DepositionKernel::TriangularShapedCloud>(positions, weights, begin, end, lower,
+                                                                          inverseCellSize, dimensions, cells);
+                    break;
+            }
+        }
+
+        void byteStrides(const int *dimensions, size_t *strides) {
+            strides[0] = sizeof(float);
+            strides[1] = sizeof(float) * dimensions[0];
+            strides[2] = sizeof(float) * dimensions[0] * dimensions[1];
+        }
+
+        size_t boxStart(const Box& box, const int *dimensions) {
+            return box.offset[0] + static_cast<size_t>(dimensions[0]) * (box.offset[1]
+                   + static_cast<size_t>(dimensions[1]) * box.offset[2]);
+        }
+    }
+
+    bool depositionKernelFromString(const std::string& name, DepositionKernel& kernel) {
+        if (name == "ngp") {
+            kernel = DepositionKernel::NearestGridPoint;
+            return true;
+        }
+        if (name == "cic") {
+            kernel = DepositionKernel::CloudInCell;
+            return true;
+        }
+        if (name == "tsc") {
+            kernel = DepositionKernel::TriangularShapedCloud;
+            return true;
+        }
+        return false;
+    }
+
+    int depositionGhostWidth(DepositionKernel kernel) {
+        return kernel == DepositionKernel::NearestGridPoint ? 0 : 1;
+    }
+
+    void depositParticles(const float *positions, const float *weights, size_t numParticles,
+                          const DepositionGrid& grid, DepositionKernel kernel, std::vector<float>& padded) {
+        const int ghost = depositionGhostWidth(kernel);
+        const Box box = paddedBox(grid.box, ghost);
+
+        float lower[3];
+        float inverseCellSize[3];
+        for (int axis = 0; axis < 3; axis++) {
+            lower[axis] = grid.origin[axis] + static_cast<float>(box.offset[axis]) * grid.cellSize[axis];
+            inverseCellSize[axis] = 1.0f / grid.cellSize[axis];
+        }
+
+        const size_t numCells = box.numVoxels();
+        padded.assign(numCells, 0.0f);
+
+        // a private grid only pays off if its thread deposits at least as many particles as it has cells
+        const size_t minChunk = std::max<size_t>(1 << 14, numCells);
+        const size_t numChunks = getNumParallelChunks(numParticles, minChunk);
+        std::vector<std::vector<float>> privateGrids(numChunks - 1);
+
+        parallelFor(0, numParticles, [&](size_t begin, size_t end, size_t chunk) {
+            float *cells = padded.data();
+            if (chunk > 0) {
+                privateGrids[chunk - 1].assign(numCells, 0.0f);
+                cells = privateGrids[chunk - 1].data();
+            }
+            depositRange(kernel, positions, weights, begin, end, lower, inverseCellSize, box.extent, cells);
+        }, minChunk);
+
+        if (privateGrids.empty()) {
+            return;
+        }
+
+        parallelFor(0, numCells, [&](size_t begin, size_t end, size_t) {
+            for (const auto& privateGrid : privateGrids) {
+                if (privateGrid.empty()) continue;
+                for (size_t i = begin; i < end; i++) {
+                    padded[i] += privateGrid[i];
+                }
+            }
+        });
+    }
+
+    ParticleDeposition::ParticleDeposition(const DepositionGrid& grid, DepositionKernel kernel, MPI_Comm comm)
+        : grid(grid), kernel(kernel), comm(comm), ghost(depositionGhostWidth(kernel)),
+          brick(grid.box.numVoxels(), 0.0f) {
+        int rank, numRanks;
+        MPI_Comm_rank(comm, &rank);
+        MPI_Comm_size(comm, &numRanks);
+
+        std::vector<Box> boxes(numRanks);
+        MPI_Allgather(&grid.box, sizeof(Box), MPI_BYTE, boxes.data(), sizeof(Box), MPI_BYTE, comm);
+
+        if (ghost == 0) {
+            return;
+        }
+
+        const Box padding = paddedBox(grid.box, ghost);
+        for (int r = 0; r < numRanks; r++) {
+            if (r == rank) continue;
+
+            // our ghost cells that belong to rank r, and our cells in the ghost layer of rank r
+            Box overlap{};
+            if (intersectBoxes(padding, boxes[r], overlap)) {
+                sends.push_back({r, overlap, {}});
+            }
+            if (intersectBoxes(paddedBox(boxes[r], ghost), grid.box, overlap)) {
+                receives.push_back({r, overlap, {}});
+            }
+        }
+
+        for (auto* exchanges : {&sends, &receives}) {
+            for (auto& exchange : *exchanges) {
+                for (int axis = 0; axis < 3; axis++) {
+                    exchange.box.offset[axis] -= padding.offset[axis];
+                }
+                exchange.buffer.resize(exchange.box.numVoxels());
+            }
+        }
+    }
+
+    bool ParticleDeposition::deposit(const float *positions, const float *weights, size_t numParticles) {
+        depositParticles(positions, weights, numParticles, grid, kernel, padded);
+
+        const Box padding = paddedBox(grid.box, ghost);
+        const int *dimensions = padding.extent;
+        size_t strides[3];
+        byteStrides(dimensions, strides);
+
+        std::vector<MPI_Request> requests;
+        requests.reserve(sends.size() + receives.size());
+
+        for (auto& exchange : receives) {
+            requests.emplace_back();
+            MPI_Irecv(exchange.buffer.data(), static_cast<int>(exchange.buffer.size()), MPI_FLOAT, exchange.rank,
+                      depositionTag, comm, &requests.back());
+        }
+
+        for (auto& exchange : sends) {
+            size_t packedStrides[3];
+            byteStrides(exchange.box.extent, packedStrides);
+            copyBox(reinterpret_cast<const char *>(padded.data() + boxStart(exchange.box, dimensions)), strides,
+                    reinterpret_cast<char *>(exchange.buffer.data()), packedStrides, exchange.box.extent, sizeof(float));
+
+            requests.emplace_back();
+            MPI_Isend(exchange.buffer.data(), static_cast<int>(exchange.buffer.size()), MPI_FLOAT, exchange.rank,
+                      depositionTag, comm, &requests.back());
+        }
+
+        if (MPI_Waitall(static_cast<int>(requests.size()), requests.data(), MPI_STATUSES_IGNORE) != MPI_SUCCESS) {
+            std::cerr << "ERROR: Could not exchange deposited particles with neighbouring ranks" << std::endl;
+            return false;
+        }
+
+        for (const auto& exchange : receives) {
+            const auto& extent = exchange.box.extent;
+            const float *source = exchange.buffer.data();
+            for (int z = 0; z < extent[2]; z++) {
+                for (int y = 0; y < extent[1]; y++) {
+                    Box row = exchange.box;
+                    row.offset[1] += y;
+                    row.offset[2] += z;
+                    float *target = padded.data() + boxStart(row, dimensions);
+                    for (int x = 0; x < extent[0]; x++) {
+                        target[x] += *source++;
+                    }
+                }
+            }
+        }
+
+        Box interior{};
+        std::fill(interior.offset, interior.offset + 3, ghost);
+        std::copy(grid.box.extent, grid.box.extent + 3, interior.extent);
+        size_t brickStrides[3];
+        byteStrides(grid.box.extent, brickStrides);
+        copyBox(reinterpret_cast<const char *>(padded.data() + boxStart(interior, dimensions)), strides,
+                reinterpret_cast<char *>(brick.data()), brickStrides, grid.box.extent, sizeof(float));
+        return true;
+    }
+
+    std::vector<int> ParticleDeposition::getNeighbours() const {
+        std::vector<int> neighbours;
+        for (const auto* exchanges : {&sends, &receives}) {
+            for (const auto& exchange : *exchanges) {
+                neighbours.push_back(exchange.rank);
+            }
+        }
+        std::sort(neighbours.begin(), neighbours.end());
+        neighbours.erase(std::unique(neighbours.begin(), neighbours.end()), neighbours.end());
+        return neighbours;
+    }
+}
@@ -0,0 +1,166 @@
+//
+// Assignment of bricks to ranks along space-filling curves.
+//
+
+#include "utils/Partitioning.h"
+
+#include <algorithm>
+#include <numeric>
+#include <utility>
+
+namespace liv {
+
+    namespace {
+        // spreads the lower 21 bits of value so that two zero bits follow each bit
+        uint64_t spreadBits(uint32_t value) {
+            uint64_t x = value & 0x1fffff;
+            x = (x | x << 32) & 0x1f00000000ffffULL;
+            x = (x | x << 16) & 0x1f0000ff0000ffULL;
+            x = (x | x << 8) & 0x100f00f00f00f00fULL;
+            x = (x | x << 4) & 0x10c30c30c30c30c3ULL;
+            x = (x | x << 2) & 0x1249249249249249ULL;
+            return x;
+        }
+
+        template<typename T>
+        size_t countAboveZero(const char *data, size_t numVoxels) {
+            const T *values = reinterpret_cast<const T *>(data);
+            size_t count = 0;
+            for (size_t i = 0; i < numVoxels; i++) {
+                count += values[i] != 0;
+            }
+            return count;
+        }
+    }
+
+    bool curveTypeFromString(const std::string& name, CurveType& type) {
+        if (name == "morton") {
+            type = CurveType::Morton;
+            return true;
+        }
+        if (name == "hilbert") {
+            type = CurveType::Hilbert;
+            return true;
+        }
+        return false;
+    }
+
+    uint64_t mortonIndex(uint32_t x, uint32_t y, uint32_t z) {
+        return spreadBits(x) | spreadBits(y) << 1 | spreadBits(z) << 2;
+    }
+
+    uint64_t hilbertIndex(uint32_t x, uint32_t y, uint32_t z, int bits) {
+        if (bits <= 0) {
+            return 0;
+        }
+
+        uint32_t axes[3] = {x, y, z};
+        const uint32_t highest = 1u << (bits - 1);
+
+        // inverse undo of the rotations and reflections
+        for (uint32_t q = highest; q > 1; q >>= 1) {
+            const uint32_t p = q - 1;
+            for (auto& axis : axes) {
+                if (axis & q) {
+                    axes[0] ^= p;
+                } else {
+                    const uint32_t t = (axes[0] ^ axis) & p;
+                    axes[0] ^= t;
+                    axis ^= t;
+                }
+            }
+        }
+
+        // Gray encoding
+        axes[1] ^= axes[0];
+        axes[2] ^= axes[1];
+        uint32_t t = 0;
+        for (uint32_t q = highest; q > 1; q >>= 1) {
+            if (axes[2] & q) {
+                t ^= q - 1;
+            }
+        }
+        for (auto& axis : axes) {
+            axis ^= t;
+        }
+
+        // the transposed index holds the bits of the index interleaved across the axes, most significant in x
+        uint64_t index = 0;
+        for (int bit = bits - 1; bit >= 0; bit--) {
+            for (const auto axis : axes) {
+                index = index << 1 | ((axis >> bit) & 1);
+            }
+        }
+        return index;
+    }
+
+    std::vector<int> curveOrder(const int *gridCounts, CurveType type) {
+        const int numCells = gridCounts[0] * gridCounts[1] * gridCounts[2];
+
+        int bits = 0;
+        while ((1 << bits) < std::max({gridCounts[0], gridCounts[1], gridCounts[2]})) {
+            bits++;
+        }
+
+        std::vector<std::pair<uint64_t, int>> keys(numCells);
+        for (int cell = 0; cell < numCells; cell++) {
+            const auto x = static_cast<uint32_t>(cell % gridCounts[0]);
+            const auto y = static_cast<uint32_t>(cell / gridCounts[0] % gridCounts[1]);
+            const auto z = static_cast<uint32_t>(cell / (gridCounts[0] * gridCounts[1]));
+            keys[cell] = {type == CurveType::Hilbert ? hilbertIndex(x, y, z, bits) : mortonIndex(x, y, z), cell};
+        }
+        std::sort(keys.begin(), keys.end());
+
+        std::vector<int> order(numCells);
+        for (int i = 0; i < numCells; i++) {
+            order[i] = keys[i].second;
+        }
+        return order;
+    }
+
+    std::vector<int> partitionAlongCurve(const std::vector<int>& order, const std::vector<double>& weights, int numParts) {
+        const size_t numCells = order.size();
+        std::vector<int> parts(numCells, 0);
+        if (numParts <= 0) {
+            return parts;
+        }
+
+        auto weightOf = [&](int cell) { return weights.empty() ? 1.0 : weights[cell]; };
+        double total = 0.0;
+        for (int cell : order) {
+            total += weightOf(cell);
+        }
+
+        size_t next = 0;
+        double cumulative = 0.0;
+        for (int part = 0; part < numParts; part++) {
+            const size_t remainingParts = numParts - part - 1;
+            // leave at least one cell for each of the following parts, and take at least one if that is possible
+            const size_t maxEnd = std::max(next, numCells > remainingParts ? numCells - remainingParts : 0);
+            const size_t minEnd = std::min(next + 1, maxEnd);
+            const double target = total * (part + 1) / numParts;
+
+            size_t end = next;
+            while (end < maxEnd && (end < minEnd || part == numParts - 1
+                                    || cumulative + weightOf(order[end]) / 2 <= target)) {
+                cumulative += weightOf(order[end]);
+                end++;
+            }
+            for (size_t i = next; i < end; i++) {
+                parts[order[i]] = part;
+            }
+            next = end;
+        }
+        return parts;
+    }
+
+    std::vector<int> assignAlongCurve(const int *gridCounts, int numRanks, CurveType type,
+                                      const std::vector<double>& weights) {
+        return partitionAlongCurve(curveOrder(gridCounts, type), weights, numRanks);
+    }
+
+    size_t countNonEmptyVoxels(const char *data, size_t numVoxels, bool is16BitData) {
+        return is16BitData ? countAboveZero<unsigned short>(data, numVoxels)
+                           : countAboveZero<unsigned char>(data, numVoxels);
+    }
+}
@@ -0,0 +1,214 @@
+//
+// Kernels for converting floating-point volume data to 8- and 16-bit integers.
+//
+
+#include "utils/Quantization.h"
+#include "utils/ParallelUtils.h"
+
+#include <algorithm>
+#include <cstring>
+#include <limits>
+#include <type_traits>
+#include <vector>
+
+namespace liv {
+
+    namespace {
+
+        // Number of independent accumulators used by the reduction, chosen so that the inner loops map onto
+        // full vector registers and the compiler can vectorize them without reassociating floating-point math.
+        constexpr size_t kLanes = 16;
+
+        // Number of elements converted per batch when the source type needs to be widened to float first.
+        constexpr size_t kBatch = 1024;
+
+        inline float toFloat(float value) { return value; }
+        inline double toFloat(double value) { return value; }
+        inline float toFloat(half value) { return halfToFloat(value); }
+
+        template <typename Src>
+        using ComputeType = typename std::conditional<std::is_same<Src, double>::value, double, float>::type;
+
+        // gathers n strided source values into a contiguous buffer of the compute type
+        template <typename Src, typename Compute>
+        inline void widen(const Src *src, size_t n, size_t stride, Compute *dst) {
+            for (size_t j = 0; j < n; j++) {
+                dst[j] = toFloat(src[j * stride]);
+            }
+        }
+
+        // v - v is 0 only for finite values, as it is NaN for infinities and NaNs
+        template <typename Compute>
+        inline bool isFinite(Compute v) {
+            return v - v == Compute(0);
+        }
+
+        template <typename Compute>
+        inline void rangeOfSpan(const Compute *data, size_t count, Compute *lo, Compute *hi) {
+            size_t i = 0;
+            for (; i + kLanes <= count; i += kLanes) {
+                for (size_t j = 0; j < kLanes; j++) {
+                    const Compute v = data[i + j];
+                    const bool finite = isFinite(v);
+                    lo[j] = finite && v < lo[j] ? v : lo[j];
+                    hi[j] = finite && v > hi[j] ? v : hi[j];
+                }
+            }
+            for (; i < count; i++) {
+                const Compute v = data[i];
+                const bool finite = isFinite(v);
+                lo[0] = finite && v < lo[0] ? v : lo[0];
+                hi[0] = finite && v > hi[0] ? v : hi[0];
+            }
+        }
+
+        template <typename Src>
+        ValueRange computeRangeImpl(const Src *data, size_t count, size_t stride) {
+            using Compute = ComputeType<Src>;
+
+            const size_t numChunks = getNumParallelChunks(count);
+            std::vector<ValueRange> partial(numChunks, {std::numeric_limits<double>::max(), std::numeric_limits<double>::lowest()});
+
+            parallelFor(0, count, [&](size_t begin, size_t end, size_t chunk) {
+                Compute lo[kLanes];
+                Compute hi[kLanes];
+                for (size_t j = 0; j < kLanes; j++) {
+                    lo[j] = std::numeric_limits<Compute>::max();
+                    hi[j] = std::numeric_limits<Compute>::lowest();
+                }
+
+                if (stride == 1 && std::is_same<Src, Compute>::value) {
+                    rangeOfSpan(reinterpret_cast<const Compute *>(data) + begin, end - begin, lo, hi);
+                } else {
+                    // gather and widen in batches so that the reduction loop stays vectorizable
+                    Compute widened[kBatch];
+                    for (size_t i = begin; i < end; i += kBatch) {
+                        const size_t n = std::min(kBatch, end - i);
+                        widen(data + i * stride, n, stride, widened);
+                        rangeOfSpan(widened, n, lo, hi);
+                    }
+                }
+
+                ValueRange result = partial[chunk];
+                for (size_t j = 0; j < kLanes; j++) {
+                    result.min = std::min(result.min, static_cast<double>(lo[j]));
+                    result.max = std::max(result.max, static_cast<double>(hi[j]));
+                }
+                partial[chunk] = result;
+            });
+
+            ValueRange range = partial[0];
+            for (const auto& p : partial) {
+                range.min = std::min(range.min, p.min);
+                range.max = std::max(range.max, p.max);
+            }
+            return range;
+        }
+
+        template <typename Compute, typename Dst>
+        inline void quantizeSpan(const Compute *src, size_t count, Compute offset, Compute scale, Dst *dst) {
+            constexpr Compute maxValue = sizeof(Dst) == 1 ? Compute(255) : Compute(65535);
+            for (size_t i = 0; i < count; i++) {
+                Compute v = (src[i] - offset) * scale;
+                // the comparisons are ordered so that NaNs end up as 0
+                v = v > Compute(0) ? v : Compute(0);
+                v = v < maxValue ? v : maxValue;
+                const auto q = static_cast<unsigned int>(v + Compute(0.5));
+                dst[i] = static_cast<Dst>(q);
+            }
+        }
+
+        template <typename Src, typename Dst>
+        void quantizeImpl(const Src *src, size_t count, const ValueRange& range, Dst *dst, size_t stride) {
+            using Compute = ComputeType<Src>;
+
+            constexpr double maxValue = sizeof(Dst) == 1 ? 255.0 : 65535.0;
+
+            if (!(range.max > range.min)) {
+                std::memset(dst, 0, count * sizeof(Dst));
+                return;
+            }
+
+            const auto offset = static_cast<Compute>(range.min);
+            const auto scale = static_cast<Compute>(maxValue / (range.max - range.min));
+
+            parallelFor(0, count, [&](size_t begin, size_t end, size_t) {
+                if (stride == 1 && std::is_same<Src, Compute>::value) {
+                    quantizeSpan(reinterpret_cast<const Compute *>(src) + begin, end - begin, offset, scale, dst + begin);
+                } else {
+                    // gather and widen in batches so that the conversion loop stays vectorizable
+                    Compute widened[kBatch];
+                    for (size_t i = begin; i < end; i += kBatch) {
+                        const size_t n = std::min(kBatch, end - i);
+                        widen(src + i * stride, n, stride, widened);
+                        quantizeSpan(widened, n, offset, scale, dst + i);
+                    }
+                }
+            });
+        }
+    }
+
+    float halfToFloat(half value) {
+        const uint32_t sign = static_cast<uint32_t>(value.bits & 0x8000u) << 16;
+        const uint32_t exponent = (value.bits >> 10) & 0x1fu;
+        uint32_t mantissa = value.bits & 0x3ffu;
+
+        uint32_t bits;
+        if (exponent == 0x1fu) {
+            // infinity or NaN
+            bits = sign | 0x7f800000u | (mantissa << 13);
+        } else if (exponent != 0) {
+            bits = sign | ((exponent + 112u) << 23) | (mantissa << 13);
+        } else if (mantissa == 0) {
+            bits = sign;
+        } else {
+            // subnormal: normalize the mantissa
+            uint32_t e = 113;
+            while ((mantissa & 0x400u) == 0) {
+                mantissa <<= 1;
+                e--;
+            }
+            bits = sign | (e << 23) | ((mantissa & 0x3ffu) << 13);
+        }
+
+        float result;
+        std::memcpy(&result, &bits, sizeof(result));
+        return result;
+    }
+
+    ValueRange computeValueRange(const float *data, size_t count, size_t stride) {
+        return computeRangeImpl(data, count, stride);
+    }
+
+    ValueRange computeValueRange(const double *data, size_t count, size_t stride) {
+        return computeRangeImpl(data, count, stride);
+    }
+
+    ValueRange computeValueRange(const half *data, size_t count, size_t stride) {
+        return computeRangeImpl(data, count, stride);
+    }
+
+    void quantize(const float *src, size_t count, const ValueRange& range, char *dst, size_t stride) {
+        quantizeImpl(src, count, range, dst, stride);
+    }
+
+    void quantize(const float *src, size_t count, const ValueRange& range, unsigned short *dst, size_t stride) {
+        quantizeImpl(src, count, range, dst, stride);
+    }
+
+    void quantize(const double *src, size_t count, const ValueRange& range, char *dst, size_t stride) {
+        quantizeImpl(src, count, range, dst, stride);
+    }
+
+    void quantize(const double *src, size_t count, const ValueRange& range, unsigned short *dst, size_t stride) {
+        quantizeImpl(src, count, range, dst, stride);
+    }
+
+    void quantize(const half *src, size_t count, const ValueRange& range, char *dst, size_t stride) {
+        quantizeImpl(src, count, range, dst, stride);
+    }
+
+    void quantize(const half *src, size_t count, const ValueRange& range, unsigned short *dst, size_t stride) {
+        quantizeImpl(src, count, range, dst, stride);
+    }
+}
@@ -0,0 +1,116 @@
+//
+// Background reading of the timesteps of a time series.
+//
+
+#include "utils/TimestepPrefetcher.h"
+
+#include <algorithm>
+#include <chrono>
+#include <filesystem>
+#include <iostream>
+#include <utility>
+
+namespace liv {
+
+    TimestepPrefetcher::TimestepPrefetcher(Loader loader, int numSteps, int depth)
+        : loader(std::move(loader)), numSteps(numSteps), slots(std::max(depth, 1) + 2) {
+        for (int slot = 0; slot < static_cast<int>(slots.size()); slot++) {
+            freeSlots.push_back(slot);
+        }
+        reader = std::thread(&TimestepPrefetcher::read, this);
+    }
+
+    TimestepPrefetcher::~TimestepPrefetcher() {
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            stopping = true;
+        }
+        changed.notify_all();
+        reader.join();
+    }
+
+    void TimestepPrefetcher::read() {
+        for (int step = 0; step < numSteps; step++) {
+            int slot;
+            {
+                std::unique_lock<std::mutex> lock(mutex);
+                changed.wait(lock, [this] { return stopping || !freeSlots.empty(); });
+                if (stopping) {
+                    return;
+                }
+                slot = freeSlots.front();
+                freeSlots.pop_front();
+            }
+
+            const auto begin = std::chrono::steady_clock::now();
+            const bool loaded = loader(step, slots[slot].data);
+            const std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - begin;
+
+            {
+                std::lock_guard<std::mutex> lock(mutex);
+                if (!loaded) {
+                    std::cerr << "ERROR: Could not read timestep " << step << std::endl;
+                    failed = true;
+                } else {
+                    slots[slot].step = step;
+                    slots[slot].readSeconds = elapsed.count();
+                    readySlots.push_back(slot);
+                }
+            }
+            changed.notify_all();
+            if (!loaded) {
+                return;
+            }
+        }
+    }
+
+    bool TimestepPrefetcher::next(PrefetchedTimestep& timestep) {
+        const auto begin = std::chrono::steady_clock::now();
+
+        std::unique_lock<std::mutex> lock(mutex);
+        changed.wait(lock, [this] { return !readySlots.empty() || failed || handedOut >= numSteps; });
+        if (readySlots.empty()) {
+            return false;
+        }
+
+        const int slot = readySlots.front();
+        readySlots.pop_front();
+        handedOut++;
+        lock.unlock();
+
+        const std::chrono::duration<double> waited = std::chrono::steady_clock::now() - begin;
+        timestep.step = slots[slot].step;
+        timestep.data = slots[slot].data.data();
+        timestep.size = slots[slot].data.size();
+        timestep.readSeconds = slots[slot].readSeconds;
+        timestep.waitSeconds = waited.count();
+        timestep.slot = slot;
+        return true;
+    }
+
+    void TimestepPrefetcher::release(const PrefetchedTimestep& timestep) {
+        if (timestep.slot < 0) {
+            return;
+        }
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            freeSlots.push_back(timestep.slot);
+        }
+        changed.notify_all();
+    }
+
+    std::vector<std::string> listTimestepFiles(const std::string& directory, const std::string& extension) {
+        std::vector<std::string> files;
+        std::error_code error;
+        for (const auto& entry : std::filesystem::directory_iterator(directory, error)) {
+            if (entry.is_regular_file() && entry.path().extension() == extension) {
+                files.push_back(entry.path().string());
+            }
+        }
+        if (error) {
+            std::cerr << "ERROR: Could not list timesteps in " << directory << ": " << error.message() << std::endl;
+        }
+        std::sort(files.begin(), files.end());
+        return files;
+    }
+}
@@ -0,0 +1,247 @@
+//
+// Decomposition of raw volumes into blocks, collective reading of the blocks with MPI-IO and mapping of block files.
+//
+
+#include "utils/VolumeIO.h"
+
+#include <algorithm>
+#include <climits>
+#include <cerrno>
+#include <cstring>
+#include <fcntl.h>
+#include <fstream>
+#include <iostream>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#include <utility>
+
+namespace liv {
+
+    MappedFile::MappedFile(MappedFile&& other) noexcept
+        : address(std::exchange(other.address, nullptr)), length(std::exchange(other.length, 0)) {}
+
+    MappedFile& MappedFile::operator=(MappedFile&& other) noexcept {
+        if (this != &other) {
+            close();
+            address = std::exchange(other.address, nullptr);
+            length = std::exchange(other.length, 0);
+        }
+        return *this;
+    }
+
+    MappedFile::~MappedFile() {
+        close();
+    }
+
+    bool MappedFile::open(const std::string& path, const MappingOptions& options) {
+        close();
+
+        const int fd = ::open(path.c_str(), O_RDONLY);
+        if (fd < 0) {
+            std::cerr << "ERROR: Could not open block file " << path << ": " << std::strerror(errno) << std::endl;
+            return false;
+        }
+
+        struct stat status{};
+        if (fstat(fd, &status) != 0) {
+            std::cerr << "ERROR: Could not query the size of " << path << ": " << std::strerror(errno) << std::endl;
+            ::close(fd);
+            return false;
+        }
+
+        if (status.st_size == 0) {
+            // mmap rejects empty mappings, an empty file is an empty block
+            ::close(fd);
+            return true;
+        }
+
+        int flags = MAP_PRIVATE;
+#ifdef MAP_POPULATE
+        if (options.populate) {
+            flags |= MAP_POPULATE;
+        }
+#endif
+        // private writable mapping, so that the pointer can be passed to the non-const volume interface
+        void *mapping = mmap(nullptr, static_cast<size_t>(status.st_size), PROT_READ | PROT_WRITE, flags, fd, 0);
+        // the mapping keeps the file referenced
+        ::close(fd);
+
+        if (mapping == MAP_FAILED) {
+            std::cerr << "ERROR: Could not map block file " << path << ": " << std::strerror(errno) << std::endl;
+            return false;
+        }
+
+        address = static_cast<char *>(mapping);
+        length = static_cast<size_t>(status.st_size);
+
+        // the hints are advisory, failures are ignored
+        if (options.sequential) {
+            madvise(address, length, MADV_SEQUENTIAL);
+        }
+#ifdef MADV_HUGEPAGE
+        if (options.hugePages) {
+            madvise(address, length, MADV_HUGEPAGE);
+        }
+#endif
+        return true;
+    }
+
+    void MappedFile::close() {
+        if (address != nullptr) {
+            munmap(address, length);
+        }
+        address = nullptr;
+        length = 0;
+    }
+
+    bool readVolumeDescription(const std::string& infoFilePath, VolumeDescription& description) {
+        std::ifstream infoFile(infoFilePath);
+        if (!infoFile.is_open()) {
+            std::cerr << "ERROR: Could not open volume info file " << infoFilePath << std::endl;
+            return false;
+        }
+
+        infoFile >> description.dimensions[0] >> description.dimensions[1] >> description.dimensions[2];
+        infoFile >> description.bitResolution;
+
+        if (infoFile.fail()) {
+            std::cerr << "ERROR: Could not read the volume description from " << infoFilePath << std::endl;
+            return false;
+        }
+        if (description.bitResolution != 8 && description.bitResolution != 16) {
+            std::cerr << "ERROR: Unsupported bit resolution " << description.bitResolution << " in " << infoFilePath << std::endl;
+            return false;
+        }
+        return true;
+    }
+
+    std::string volumeInfoPath(const std::string& rawFilePath) {
+        return rawFilePath.substr(0, rawFilePath.find_last_of('.')) + ".info";
+    }
+
+    void computeBlockGrid(int numBlocks, int * grid) {
+        grid[0] = grid[1] = grid[2] = 1;
+        int bestDifference = INT_MAX;
+
+        for (int x = 1; x <= numBlocks && bestDifference > 0; x++) {
+            if (numBlocks % x != 0) {
+                continue;
+            }
+            const int remaining = numBlocks / x;
+            for (int y = 1; y <= remaining; y++) {
+                if (remaining % y != 0) {
+                    continue;
+                }
+                const int z = remaining / y;
+
+                // the most cube-like grid has the smallest difference between its largest and smallest count
+                const int difference = std::max({x, y, z}) - std::min({x, y, z});
+                if (difference < bestDifference) {
+                    grid[0] = x;
+                    grid[1] = y;
+                    grid[2] = z;
+                    bestDifference = difference;
+                }
+                if (difference == 0) {
+                    break;
+                }
+            }
+        }
+    }
+
+    Box blockBox(const int * volumeDimensions, const int * grid, int blockIndex) {
+        const int blockCoordinates[3] = {
+            blockIndex % grid[0],
+            (blockIndex / grid[0]) % grid[1],
+            blockIndex / (grid[0] * grid[1])
+        };
+
+        Box box{};
+        for (int d = 0; d < 3; d++) {
+            const int size = volumeDimensions[d] / grid[d];
+            const int remainder = volumeDimensions[d] % grid[d];
+            const int i = blockCoordinates[d];
+
+            box.extent[d] = size + (i < remainder ? 1 : 0);
+            box.offset[d] = i * size + std::min(i, remainder);
+        }
+        return box;
+    }
+
+    bool readVolumeBox(const std::string& rawFilePath, const VolumeDescription& description, const Box& box,
+                       MPI_Comm comm, std::vector<char>& data) {
+        // let the MPI library aggregate the reads of all ranks
+        MPI_Info info;
+        MPI_Info_create(&info);
+        MPI_Info_set(info, "romio_cb_read", "enable");
+
+        MPI_File file;
+        const int openResult = MPI_File_open(comm, rawFilePath.c_str(), MPI_MODE_RDONLY, info, &file);
+        MPI_Info_free(&info);
+
+        if (openResult != MPI_SUCCESS) {
+            std::cerr << "ERROR: Could not open volume file " << rawFilePath << std::endl;
+            return false;
+        }
+
+        MPI_Datatype elementType;
+        MPI_Type_contiguous(static_cast<int>(description.elementSize()), MPI_BYTE, &elementType);
+        MPI_Type_commit(&elementType);
+
+        // the file is stored x-fastest, which is C order for z, y, x
+        const int sizes[3] = {description.dimensions[2], description.dimensions[1], description.dimensions[0]};
+        const int subsizes[3] = {box.extent[2], box.extent[1], box.extent[0]};
+        const int starts[3] = {box.offset[2], box.offset[1], box.offset[0]};
+
+        MPI_Datatype fileType;
+        MPI_Type_create_subarray(3, sizes, subsizes, starts, MPI_ORDER_C, elementType, &fileType);
+        MPI_Type_commit(&fileType);
+
+        // read whole rows, so that the count stays within an int for large blocks
+        MPI_Datatype rowType;
+        MPI_Type_contiguous(box.extent[0], elementType, &rowType);
+        MPI_Type_commit(&rowType);
+
+        data.resize(box.numVoxels() * description.elementSize());
+        MPI_File_set_view(file, 0, elementType, fileType, "native", MPI_INFO_NULL);
+
+        MPI_Status status;
+        const int readResult = MPI_File_read_all(file, data.data(), box.extent[1] * box.extent[2], rowType, &status);
+
+        MPI_Type_free(&rowType);
+        MPI_Type_free(&fileType);
+        MPI_Type_free(&elementType);
+        MPI_File_close(&file);
+
+        if (readResult != MPI_SUCCESS) {
+            std::cerr << "ERROR: Could not read volume data from " << rawFilePath << std::endl;
+            return false;
+        }
+        return true;
+    }
+
+    bool loadVolumeBlock(const std::string& rawFilePath, MPI_Comm comm, VolumeBlock& block) {
+        int rank;
+        int numRanks;
+        MPI_Comm_rank(comm, &rank);
+        MPI_Comm_size(comm, &numRanks);
+
+        // one rank reads the description, so that all ranks agree on it
+        int valid = 0;
+        if (rank == 0) {
+            valid = readVolumeDescription(volumeInfoPath(rawFilePath), block.volume);
+        }
+        MPI_Bcast(&valid, 1, MPI_INT, 0, comm);
+        if (!valid) {
+            return false;
+        }
+        MPI_Bcast(&block.volume, sizeof(VolumeDescription), MPI_BYTE, 0, comm);
+
+        int grid[3];
+        computeBlockGrid(numRanks, grid);
+        block.box = blockBox(block.volume.dimensions, grid, rank);
+
+        return readVolumeBox(rawFilePath, block.volume, block.box, comm, block.data);
+    }
+}
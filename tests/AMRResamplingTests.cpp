@@ -0,0 +1,106 @@
+#include <vector>
+#include "gtest/gtest.h"
+#include "utils/AMRResampling.h"
+
+namespace {
+    liv::Box makeBox(int x, int y, int z, int sizeX, int sizeY, int sizeZ) {
+        return liv::Box{{x, y, z}, {sizeX, sizeY, sizeZ}};
+    }
+
+    float at(const std::vector<float>& brick, const liv::Box& box, int x, int y, int z) {
+        return brick[x + box.extent[0] * (y + box.extent[1] * z)];
+    }
+}
+
+TEST(AMRResamplingTest, FinestPatchWins) {
+    // a coarse 4x4x4 level with a refined 2x2x2 region at its center
+    const std::vector<float> coarse(64, 1.0f);
+    const std::vector<float> fine(64, 5.0f);
+
+    const auto box = makeBox(0, 0, 0, 8, 8, 8);
+    liv::AMRResampler resampler(box, 1);
+    resampler.addPatch({0, makeBox(0, 0, 0, 4, 4, 4), coarse.data()});
+    resampler.addPatch({1, makeBox(2, 2, 2, 4, 4, 4), fine.data()});
+    resampler.resample();
+
+    const auto& brick = resampler.getBrick();
+    ASSERT_FLOAT_EQ(at(brick, box, 0, 0, 0), 1.0f);
+    ASSERT_FLOAT_EQ(at(brick, box, 1, 7, 3), 1.0f);
+    ASSERT_FLOAT_EQ(at(brick, box, 2, 2, 2), 5.0f);
+    ASSERT_FLOAT_EQ(at(brick, box, 5, 5, 5), 5.0f);
+    ASSERT_FLOAT_EQ(at(brick, box, 6, 5, 5), 1.0f);
+}
+
+TEST(AMRResamplingTest, CoarserBrickAveragesFinePatches) {
+    std::vector<float> fine(4 * 2 * 2);
+    for (size_t i = 0; i < fine.size(); i++) {
+        fine[i] = static_cast<float>(i % 4);
+    }
+
+    const auto box = makeBox(0, 0, 0, 2, 1, 1);
+    liv::AMRResampler resampler(box, 0);
+    resampler.addPatch({1, makeBox(0, 0, 0, 4, 2, 2), fine.data()});
+    resampler.resample();
+
+    ASSERT_FLOAT_EQ(resampler.getBrick()[0], 0.5f);
+    ASSERT_FLOAT_EQ(resampler.getBrick()[1], 2.5f);
+}
+
+TEST(AMRResamplingTest, UncoveredCellsHoldFillValue) {
+    const std::vector<float> patch(8, 3.0f);
+
+    const auto box = makeBox(-1, 0, 0, 4, 2, 2);
+    liv::AMRResampler resampler(box, 0, 2, -1.0f);
+    resampler.addPatch({0, makeBox(0, 0, 0, 2, 2, 2), patch.data()});
+    resampler.resample();
+
+    const auto& brick = resampler.getBrick();
+    ASSERT_FLOAT_EQ(at(brick, box, 0, 0, 0), -1.0f);
+    ASSERT_FLOAT_EQ(at(brick, box, 1, 1, 1), 3.0f);
+    ASSERT_FLOAT_EQ(at(brick, box, 3, 1, 1), -1.0f);
+}
+
+TEST(AMRResamplingTest, IncrementalUpdateMatchesFullResample) {
+    std::vector<float> coarse(8 * 8 * 8);
+    std::vector<float> fineA(4 * 4 * 4, 2.0f);
+    std::vector<float> fineB(4 * 4 * 4, 3.0f);
+    for (size_t i = 0; i < coarse.size(); i++) {
+        coarse[i] = static_cast<float>(i);
+    }
+
+    const auto box = makeBox(0, 0, 0, 16, 16, 16);
+    liv::AMRResampler incremental(box, 1);
+    incremental.addPatch({0, makeBox(0, 0, 0, 8, 8, 8), coarse.data()});
+    incremental.addPatch({1, makeBox(0, 0, 0, 4, 4, 4), fineA.data()});
+    incremental.addPatch({1, makeBox(8, 8, 8, 4, 4, 4), fineB.data()});
+    incremental.resample();
+
+    std::vector<float> changed(4 * 4 * 4, 7.0f);
+    incremental.setPatchData(2, changed.data());
+    const auto regions = incremental.resample({2});
+
+    ASSERT_EQ(regions.size(), 1u);
+    ASSERT_EQ(regions[0].offset[0], 8);
+    ASSERT_EQ(regions[0].extent[0], 4);
+
+    liv::AMRResampler full(box, 1);
+    full.addPatch({0, makeBox(0, 0, 0, 8, 8, 8), coarse.data()});
+    full.addPatch({1, makeBox(0, 0, 0, 4, 4, 4), fineA.data()});
+    full.addPatch({1, makeBox(8, 8, 8, 4, 4, 4), changed.data()});
+    full.resample();
+
+    ASSERT_EQ(incremental.getBrick(), full.getBrick());
+}
+
+TEST(AMRResamplingTest, BoundingBoxSpansAllLevels) {
+    const std::vector<liv::AMRPatch> patches = {
+        {0, makeBox(2, 0, 0, 2, 2, 2), nullptr},
+        {2, makeBox(0, 0, 0, 6, 4, 20), nullptr},
+    };
+
+    const auto bounds = liv::boundingBox(patches, 1);
+    ASSERT_EQ(bounds.offset[0], 0);
+    ASSERT_EQ(bounds.extent[0], 8);
+    ASSERT_EQ(bounds.extent[1], 4);
+    ASSERT_EQ(bounds.extent[2], 10);
+}
@@ -0,0 +1,163 @@
+#include <algorithm>
+#include <cstdio>
+#include <random>
+#include <string>
+#include <vector>
+#include "gtest/gtest.h"
+#include "utils/BrickContainer.h"
+
+namespace {
+    const int kDimensions[3] = {13, 9, 7};
+    const int kBrickSize[3] = {5, 4, 3};
+
+    std::vector<unsigned short> makeVolume(bool compressible) {
+        std::vector<unsigned short> volume(kDimensions[0] * kDimensions[1] * kDimensions[2]);
+        std::mt19937 generator(7);
+        for (size_t i = 0; i < volume.size(); i++) {
+            volume[i] = compressible ? static_cast<unsigned short>(i / 50) : static_cast<unsigned short>(generator());
+        }
+        return volume;
+    }
+
+    std::vector<char> extractBox(const std::vector<unsigned short>& volume, const liv::Box& box) {
+        std::vector<char> data(box.numVoxels() * sizeof(unsigned short));
+        auto *values = reinterpret_cast<unsigned short *>(data.data());
+        size_t i = 0;
+        for (int z = box.offset[2]; z < box.offset[2] + box.extent[2]; z++) {
+            for (int y = box.offset[1]; y < box.offset[1] + box.extent[1]; y++) {
+                for (int x = box.offset[0]; x < box.offset[0] + box.extent[0]; x++) {
+                    values[i++] = volume[(z * kDimensions[1] + y) * kDimensions[0] + x];
+                }
+            }
+        }
+        return data;
+    }
+
+    void writeContainer(const std::string& path, const std::vector<unsigned short>& volume,
+                        liv::BrickCompression compression) {
+        liv::BrickContainerWriter writer;
+        ASSERT_TRUE(writer.open(path, {{kDimensions[0], kDimensions[1], kDimensions[2]}, 16}, kBrickSize, compression));
+
+        // bricks may arrive in any order
+        for (int brick = writer.getGrid().numBricks() - 1; brick >= 0; brick--) {
+            const auto data = extractBox(volume, writer.getGrid().brickBox(brick));
+            ASSERT_TRUE(writer.writeBrick(brick, data.data()));
+        }
+        ASSERT_TRUE(writer.close());
+    }
+}
+
+TEST(BrickContainerTest, BricksRoundTrip) {
+    const std::string path = "BrickContainerTest_bricks.livb";
+    const auto volume = makeVolume(false);
+    writeContainer(path, volume, liv::BrickCompression::None);
+
+    ASSERT_TRUE(liv::isBrickContainer(path));
+
+    liv::BrickContainer container;
+    ASSERT_TRUE(container.open(path));
+    ASSERT_EQ(container.getVolume().bitResolution, 16);
+    ASSERT_TRUE(container.hasMinMax());
+
+    std::vector<char> brick;
+    for (int i = 0; i < container.getGrid().numBricks(); i++) {
+        const auto& entry = container.getEntry(i);
+        ASSERT_EQ(entry.offset % liv::kBrickContainerDefaultAlignment, 0u);
+
+        ASSERT_TRUE(container.readBrick(i, brick));
+        const auto expected = extractBox(volume, container.getGrid().brickBox(i));
+        ASSERT_EQ(brick, expected);
+
+        const auto *values = reinterpret_cast<const unsigned short *>(expected.data());
+        const auto [lo, hi] = std::minmax_element(values, values + expected.size() / 2);
+        ASSERT_EQ(entry.minValue, *lo);
+        ASSERT_EQ(entry.maxValue, *hi);
+        ASSERT_EQ(entry.nonEmptyVoxels, static_cast<uint32_t>(std::count_if(values, values + expected.size() / 2,
+                                                                           [](unsigned short v) { return v != 0; })));
+    }
+
+    std::remove(path.c_str());
+}
+
+TEST(BrickContainerTest, BoxesSpanningBricks) {
+    const std::string path = "BrickContainerTest_boxes.livb";
+    const auto volume = makeVolume(false);
+    writeContainer(path, volume, liv::BrickCompression::None);
+
+    liv::BrickContainer container;
+    ASSERT_TRUE(container.open(path, true));
+
+    std::vector<char> data;
+    const liv::Box box{{3, 2, 1}, {8, 6, 5}};
+    ASSERT_TRUE(container.readBox(box, data));
+    ASSERT_EQ(data, extractBox(volume, box));
+
+    ASSERT_TRUE(container.hasVoxelCounts());
+    const liv::Box whole{{0, 0, 0}, {kDimensions[0], kDimensions[1], kDimensions[2]}};
+    double nonEmpty = 0;
+    for (int i = 0; i < container.getGrid().numBricks(); i++) {
+        nonEmpty += container.getEntry(i).nonEmptyVoxels;
+    }
+    ASSERT_DOUBLE_EQ(container.estimateNonEmptyVoxels(whole), nonEmpty);
+
+    const liv::Box outside{{10, 0, 0}, {5, 1, 1}};
+    ASSERT_FALSE(container.readBox(outside, data));
+
+    std::remove(path.c_str());
+}
+
+TEST(BrickContainerTest, AnyBlockCountReadsFromOneFile) {
+    const std::string path = "BrickContainerTest_blocks.livb";
+    const auto volume = makeVolume(false);
+    writeContainer(path, volume, liv::BrickCompression::None);
+
+    for (int numBlocks : {1, 3, 4, 6}) {
+        int grid[3];
+        liv::computeBlockGrid(numBlocks, grid);
+        for (int block = 0; block < numBlocks; block++) {
+            liv::VolumeBlock loaded;
+            ASSERT_TRUE(liv::loadContainerBlock(path, block, numBlocks, loaded));
+            const auto box = liv::blockBox(kDimensions, grid, block);
+            ASSERT_EQ(loaded.data, extractBox(volume, box));
+        }
+    }
+
+    std::remove(path.c_str());
+}
+
+TEST(BrickContainerTest, CompressedBricksRoundTrip) {
+    if (!liv::isCompressionSupported(liv::BrickCompression::Deflate)) {
+        GTEST_SKIP() << "LiV was built without zlib";
+    }
+
+    const std::string path = "BrickContainerTest_compressed.livb";
+    const auto volume = makeVolume(true);
+    writeContainer(path, volume, liv::BrickCompression::Deflate);
+
+    liv::BrickContainer container;
+    ASSERT_TRUE(container.open(path));
+    ASSERT_EQ(container.getEntry(0).compression, static_cast<uint32_t>(liv::BrickCompression::Deflate));
+
+    std::vector<char> data;
+    const liv::Box whole{{0, 0, 0}, {kDimensions[0], kDimensions[1], kDimensions[2]}};
+    ASSERT_TRUE(container.readBox(whole, data));
+    ASSERT_EQ(data, extractBox(volume, whole));
+
+    std::remove(path.c_str());
+}
+
+TEST(BrickContainerTest, RejectsOtherFiles) {
+    const std::string path = "BrickContainerTest_other.raw";
+    {
+        std::vector<char> zeros(4096, 0);
+        FILE *file = std::fopen(path.c_str(), "wb");
+        std::fwrite(zeros.data(), 1, zeros.size(), file);
+        std::fclose(file);
+    }
+
+    ASSERT_FALSE(liv::isBrickContainer(path));
+    liv::BrickContainer container;
+    ASSERT_FALSE(container.open(path));
+
+    std::remove(path.c_str());
+}
@@ -0,0 +1,107 @@
+#include <numeric>
+#include <vector>
+#include "gtest/gtest.h"
+#include "utils/Bricking.h"
+#include "utils/BrickStatistics.h"
+
+TEST(BrickGridTest, TruncatesBoundaryBricks) {
+    int volumeDimensions[3] = {100, 64, 10};
+    int brickSize[3] = {64, 64, 64};
+    liv::BrickGrid grid(volumeDimensions, brickSize);
+
+    ASSERT_EQ(grid.numBricks(), 2);
+
+    auto last = grid.brickBox(1);
+    ASSERT_EQ(last.offset[0], 64);
+    ASSERT_EQ(last.extent[0], 36);
+    ASSERT_EQ(last.extent[1], 64);
+    ASSERT_EQ(last.extent[2], 10);
+}
+
+TEST(BrickGridTest, FindsIntersectingBricks) {
+    int volumeDimensions[3] = {32, 32, 32};
+    int brickSize[3] = {8, 8, 8};
+    liv::BrickGrid grid(volumeDimensions, brickSize);
+
+    int offset[3] = {7, 0, 16};
+    int extent[3] = {2, 1, 1};
+    auto bricks = grid.bricksIntersecting(offset, extent);
+
+    ASSERT_EQ(bricks, (std::vector<int>{32, 33}));
+
+    int outside[3] = {40, 0, 0};
+    ASSERT_TRUE(grid.bricksIntersecting(outside, extent).empty());
+}
+
+TEST(CopyBoxTest, CopiesStridedBox) {
+    std::vector<unsigned short> src(4 * 3 * 2);
+    std::iota(src.begin(), src.end(), 0);
+
+    // copy the box [1,3) x [1,3) x [1,2) with x and y swapped in the destination
+    std::vector<unsigned short> dst(4, 0);
+    const size_t e = sizeof(unsigned short);
+    size_t srcStrides[3] = {e, 4 * e, 12 * e};
+    size_t dstStrides[3] = {2 * e, e, 4 * e};
+    int extent[3] = {2, 2, 1};
+
+    liv::copyBox(reinterpret_cast<const char *>(&src[1 + 4 + 12]), srcStrides,
+                 reinterpret_cast<char *>(dst.data()), dstStrides, extent, e);
+
+    ASSERT_EQ(dst, (std::vector<unsigned short>{17, 21, 18, 22}));
+}
+
+TEST(BoxTest, IntersectsAndPadsBoxes) {
+    const liv::Box a{{0, 0, 0}, {4, 4, 4}};
+    const liv::Box b{{4, 2, -1}, {2, 2, 2}};
+
+    liv::Box overlap{};
+    ASSERT_FALSE(liv::intersectBoxes(a, b, overlap));
+
+    const liv::Box padded = liv::paddedBox(a, 1);
+    ASSERT_EQ(padded.offset[0], -1);
+    ASSERT_EQ(padded.extent[0], 6);
+
+    ASSERT_TRUE(liv::intersectBoxes(padded, b, overlap));
+    ASSERT_EQ(overlap.offset[0], 4);
+    ASSERT_EQ(overlap.extent[0], 1);
+    ASSERT_EQ(overlap.offset[2], -1);
+    ASSERT_EQ(overlap.extent[2], 2);
+}
+
+TEST(HashBoxTest, DetectsSingleByteChange) {
+    std::vector<char> data(100 * 7 * 3, 0);
+    size_t strides[3] = {1, 100, 700};
+    int extent[3] = {100, 7, 3};
+
+    auto hash = liv::hashBox(data.data(), strides, extent, 1);
+    ASSERT_EQ(hash, liv::hashBox(data.data(), strides, extent, 1));
+
+    for (size_t i : {size_t{0}, size_t{70}, size_t{99}, data.size() - 1}) {
+        data[i] = 1;
+        ASSERT_NE(hash, liv::hashBox(data.data(), strides, extent, 1));
+        data[i] = 0;
+    }
+}
+
+TEST(BrickStatisticsTest, ComputesRangesAndHistogram) {
+    int volumeDimensions[3] = {20, 8, 8};
+    int brickSize[3] = {10, 8, 8};
+    liv::BrickGrid grid(volumeDimensions, brickSize);
+
+    std::vector<unsigned short> data(20 * 8 * 8, 0);
+    data[12] = 1000;
+    data[19 + 20 * 7 + 160 * 7] = 65535;
+
+    liv::BrickStatistics statistics;
+    liv::computeBrickStatistics(reinterpret_cast<const char *>(data.data()), grid, volumeDimensions, true, 16, statistics);
+
+    ASSERT_EQ(statistics.minMax, (std::vector<int>{0, 0, 0, 65535}));
+    ASSERT_EQ(statistics.histogram.size(), 16u);
+    ASSERT_EQ(statistics.histogram[0], 20 * 8 * 8 - 1);
+    ASSERT_EQ(statistics.histogram[15], 1);
+
+    data[3] = 7;
+    liv::updateBrickRanges(reinterpret_cast<const char *>(data.data()), grid, volumeDimensions, true, {0}, statistics);
+    ASSERT_EQ(statistics.minMax[1], 7);
+    ASSERT_EQ(statistics.histogram[15], 1);
+}
@@ -0,0 +1,100 @@
+#include <mpi.h>
+#include <algorithm>
+#include <vector>
+#include "gtest/gtest.h"
+#include "utils/HaloExchange.h"
+#include "utils/VolumeIO.h"
+
+namespace {
+    class MPIEnvironment : public ::testing::Environment {
+    public:
+        void SetUp() override {
+            MPI_Init(nullptr, nullptr);
+        }
+
+        void TearDown() override {
+            MPI_Finalize();
+        }
+    };
+
+    const auto* environment = ::testing::AddGlobalTestEnvironment(new MPIEnvironment);
+
+    const int dimensions[3] = {12, 10, 9};
+
+    int valueAt(int x, int y, int z) {
+        return x + 100 * y + 10000 * z;
+    }
+
+    // the value of a padded cell: its own voxel inside the volume, otherwise the nearest voxel of the brick
+    int expectedAt(const liv::Box& box, const int *coordinates) {
+        int source[3];
+        bool inside = true;
+        for (int axis = 0; axis < 3; axis++) {
+            inside &= coordinates[axis] >= 0 && coordinates[axis] < dimensions[axis];
+        }
+        for (int axis = 0; axis < 3; axis++) {
+            source[axis] = inside ? coordinates[axis]
+                : std::clamp(coordinates[axis], box.offset[axis], box.offset[axis] + box.extent[axis] - 1);
+        }
+        return valueAt(source[0], source[1], source[2]);
+    }
+
+    liv::Box rankBox(MPI_Comm comm) {
+        int rank, numRanks;
+        MPI_Comm_rank(comm, &rank);
+        MPI_Comm_size(comm, &numRanks);
+        int grid[3];
+        liv::computeBlockGrid(numRanks, grid);
+        return liv::blockBox(dimensions, grid, rank);
+    }
+
+    std::vector<int> fillBrick(const liv::Box& box) {
+        std::vector<int> brick;
+        for (int z = 0; z < box.extent[2]; z++) {
+            for (int y = 0; y < box.extent[1]; y++) {
+                for (int x = 0; x < box.extent[0]; x++) {
+                    brick.push_back(valueAt(box.offset[0] + x, box.offset[1] + y, box.offset[2] + z));
+                }
+            }
+        }
+        return brick;
+    }
+}
+
+// On a single rank, every ghost cell repeats the nearest voxel. Run with several ranks, ghost cells inside the volume
+// hold the voxels of the neighbouring bricks.
+TEST(HaloExchangeTest, GhostLayerMatchesWholeVolume) {
+    const liv::Box box = rankBox(MPI_COMM_WORLD);
+    const std::vector<int> brick = fillBrick(box);
+
+    for (int ghost : {1, 2}) {
+        liv::HaloExchange halo(box, ghost, sizeof(int), MPI_COMM_WORLD);
+        const liv::Box& padded = halo.getPaddedBox();
+        std::vector<int> paddedBrick(padded.numVoxels(), -1);
+
+        // exchanged twice, to reuse the persistent requests
+        for (int round = 0; round < 2; round++) {
+            ASSERT_TRUE(halo.exchange(reinterpret_cast<const char *>(brick.data()),
+                                      reinterpret_cast<char *>(paddedBrick.data())));
+
+            size_t i = 0;
+            for (int z = 0; z < padded.extent[2]; z++) {
+                for (int y = 0; y < padded.extent[1]; y++) {
+                    for (int x = 0; x < padded.extent[0]; x++) {
+                        const int coordinates[3] = {padded.offset[0] + x, padded.offset[1] + y, padded.offset[2] + z};
+                        ASSERT_EQ(paddedBrick[i++], expectedAt(box, coordinates))
+                            << "at " << coordinates[0] << ", " << coordinates[1] << ", " << coordinates[2];
+                    }
+                }
+            }
+        }
+    }
+}
+
+TEST(HaloExchangeTest, NoNeighboursOnSingleRank) {
+    const liv::Box box{{0, 0, 0}, {4, 3, 2}};
+    liv::HaloExchange halo(box, 1, sizeof(int), MPI_COMM_SELF);
+
+    ASSERT_TRUE(halo.getNeighbours().empty());
+    ASSERT_EQ(halo.getPaddedBox().numVoxels(), 6u * 5u * 4u);
+}
@@ -0,0 +1,101 @@
+#include <algorithm>
+#include <cstdlib>
+#include <string>
+#include <vector>
+#include "gtest/gtest.h"
+#include "utils/JVMConfiguration.h"
+
+namespace {
+    liv::JVMConfiguration makeConfiguration() {
+        liv::JVMConfiguration configuration;
+        configuration.classPath = "/opt/liv/libs/a.jar:/opt/liv/libs/b.jar:";
+        configuration.fileOptions = {"-Xmx8g", "-Dscenery.LogLevel=debug"};
+        configuration.headless = "true";
+        configuration.lwjglSharedPath = "/tmp/";
+        configuration.lwjglLibraryPath = "/tmp/";
+        configuration.mpiJniLibPath = "/usr/local/lib/";
+        return configuration;
+    }
+
+    bool contains(const std::vector<std::string>& options, const std::string& option) {
+        return std::find(options.begin(), options.end(), option) != options.end();
+    }
+}
+
+TEST(JVMConfigurationTest, SerializationRoundTrip) {
+    const auto configuration = makeConfiguration();
+    const auto buffer = liv::serializeJVMConfiguration(configuration);
+
+    liv::JVMConfiguration received;
+    ASSERT_TRUE(liv::deserializeJVMConfiguration(buffer, received));
+
+    ASSERT_EQ(received.classPath, configuration.classPath);
+    ASSERT_EQ(received.fileOptions, configuration.fileOptions);
+    ASSERT_EQ(received.headless, configuration.headless);
+    ASSERT_EQ(received.benchmark, configuration.benchmark);
+    ASSERT_EQ(received.mpiJniLibPath, configuration.mpiJniLibPath);
+    ASSERT_EQ(received.classDataArchiveDirectory, configuration.classDataArchiveDirectory);
+}
+
+TEST(JVMConfigurationTest, RankEnvironmentIsNotBroadcast) {
+    auto configuration = makeConfiguration();
+    configuration.gpuId = "0";
+    const auto buffer = liv::serializeJVMConfiguration(configuration);
+
+    // another rank assigned a different GPU by its launch script
+    setenv("SCENERY_GPU_ID", "2", 1);
+    liv::JVMConfiguration received;
+    ASSERT_TRUE(liv::deserializeJVMConfiguration(buffer, received));
+    liv::readRankEnvironment(received);
+    unsetenv("SCENERY_GPU_ID");
+
+    ASSERT_EQ(received.gpuId, "2");
+}
+
+TEST(JVMConfigurationTest, RejectsTruncatedBuffer) {
+    auto buffer = liv::serializeJVMConfiguration(makeConfiguration());
+    buffer.resize(buffer.size() - 3);
+
+    liv::JVMConfiguration received;
+    ASSERT_FALSE(liv::deserializeJVMConfiguration(buffer, received));
+}
+
+TEST(JVMConfigurationTest, BuildsRankDependentOptions) {
+    auto configuration = makeConfiguration();
+
+    const auto rank0 = liv::buildJVMOptions(configuration, 0);
+    const auto rank3 = liv::buildJVMOptions(configuration, 3);
+
+    ASSERT_EQ(rank0.front(), "-Djava.class.path=" + configuration.classPath);
+    ASSERT_TRUE(contains(rank0, "-Dscenery.RemoteCamera=true"));
+    ASSERT_FALSE(contains(rank3, "-Dscenery.RemoteCamera=true"));
+    ASSERT_TRUE(contains(rank3, "-Dscenery.Renderer.DeviceId=3"));
+    ASSERT_TRUE(contains(rank3, "-Xmx8g"));
+
+    configuration.gpuId = "1";
+    ASSERT_TRUE(contains(liv::buildJVMOptions(configuration, 3), "-Dscenery.Renderer.DeviceId=1"));
+}
+
+TEST(JVMConfigurationTest, OnlyRecordingRankCreatesClassDataArchive) {
+    auto configuration = makeConfiguration();
+    ASSERT_EQ(liv::classDataArchivePath(configuration, "node01"), "");
+
+    configuration.classDataArchiveDirectory = "/scratch/cds";
+    const auto archive = liv::classDataArchivePath(configuration, "node01");
+    ASSERT_EQ(archive, "/scratch/cds/liv-node01.jsa");
+
+    liv::JVMNodeOptions recording;
+    recording.classDataArchive = archive;
+    recording.recordClassDataArchive = true;
+    const auto recordingOptions = liv::buildJVMOptions(configuration, 0, recording);
+    ASSERT_TRUE(contains(recordingOptions, "-XX:+AutoCreateSharedArchive"));
+    ASSERT_TRUE(contains(recordingOptions, "-XX:SharedArchiveFile=" + archive));
+
+    liv::JVMNodeOptions mapping;
+    mapping.classDataArchive = archive;
+    const auto mappingOptions = liv::buildJVMOptions(configuration, 1, mapping);
+    ASSERT_FALSE(contains(mappingOptions, "-XX:+AutoCreateSharedArchive"));
+    ASSERT_TRUE(contains(mappingOptions, "-XX:SharedArchiveFile=" + archive));
+
+    ASSERT_FALSE(contains(liv::buildJVMOptions(configuration, 1), "-XX:SharedArchiveFile=" + archive));
+}
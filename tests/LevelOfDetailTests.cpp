@@ -0,0 +1,61 @@
+#include <vector>
+#include "gtest/gtest.h"
+#include "utils/LevelOfDetail.h"
+
+TEST(LevelOfDetailTest, BuildsLevelsWithBoxFilter) {
+    int dimensions[3] = {4, 4, 4};
+    std::vector<unsigned char> volume(64, 0);
+    for (int z = 0; z < 2; z++) {
+        for (int y = 0; y < 2; y++) {
+            volume[z * 16 + y * 4 + 0] = 8;
+            volume[z * 16 + y * 4 + 1] = 16;
+        }
+    }
+
+    std::vector<liv::VolumeLevel> levels;
+    liv::buildLevels(reinterpret_cast<const char *>(volume.data()), dimensions, false, 10,
+                     liv::DownsamplingFilter::Box, levels);
+
+    ASSERT_EQ(levels.size(), 2u);
+    ASSERT_EQ(levels[0].dimensions[0], 2);
+    ASSERT_EQ(static_cast<unsigned char>(levels[0].data[0]), 12);
+    ASSERT_EQ(static_cast<unsigned char>(levels[0].data[1]), 0);
+    ASSERT_EQ(levels[1].data.size(), 1u);
+    ASSERT_EQ(static_cast<unsigned char>(levels[1].data[0]), 2);
+}
+
+TEST(LevelOfDetailTest, MaxFilterHandlesOddDimensions) {
+    int dimensions[3] = {3, 1, 1};
+    std::vector<unsigned short> volume = {1, 2, 300};
+
+    std::vector<liv::VolumeLevel> levels;
+    liv::buildLevels(reinterpret_cast<const char *>(volume.data()), dimensions, true, 1,
+                     liv::DownsamplingFilter::Max, levels);
+
+    ASSERT_EQ(levels.size(), 1u);
+    ASSERT_EQ(levels[0].dimensions[0], 2);
+    auto *level = reinterpret_cast<const unsigned short *>(levels[0].data.data());
+    ASSERT_EQ(level[0], 2);
+    ASSERT_EQ(level[1], 300);
+}
+
+TEST(LevelOfDetailTest, UpdatesChangedRegionOnly) {
+    int dimensions[3] = {8, 8, 8};
+    std::vector<unsigned char> volume(512, 0);
+
+    std::vector<liv::VolumeLevel> levels;
+    liv::buildLevels(reinterpret_cast<const char *>(volume.data()), dimensions, false, 3,
+                     liv::DownsamplingFilter::Max, levels);
+
+    volume[7 + 8 * 7 + 64 * 7] = 200;
+    liv::updateLevels(reinterpret_cast<const char *>(volume.data()), dimensions, false, {{4, 4, 4}, {4, 4, 4}},
+                      liv::DownsamplingFilter::Max, levels);
+
+    std::vector<liv::VolumeLevel> expected;
+    liv::buildLevels(reinterpret_cast<const char *>(volume.data()), dimensions, false, 3,
+                     liv::DownsamplingFilter::Max, expected);
+
+    for (size_t level = 0; level < levels.size(); level++) {
+        ASSERT_EQ(levels[level].data, expected[level].data);
+    }
+}
@@ -15,4 +15,174 @@ TEST(VolumeTest, UniqueIdTest) {
     ASSERT_NE(volume1.getId(), volume2.getId());
     ASSERT_NE(volume1.getId(), volume3.getId());
     ASSERT_NE(volume2.getId(), volume3.getId());
-}
\ No newline at end of file
+}
+
+TEST(VolumeTest, UniqueIdAcrossTypesTest) {
+    float position[3] = {0.0f, 0.0f, 0.0f};
+    int dimensions[3] = {1, 1, 1};
+
+    auto shortVolume = liv::createVolume<unsigned short>(position, dimensions, nullptr);
+    auto floatVolume = liv::createVolume<float>(position, dimensions, nullptr);
+    auto fieldsVolume = liv::createMultiFieldVolume<double>(position, dimensions, {{"value", 0}}, sizeof(double), nullptr);
+
+    ASSERT_NE(shortVolume.getId(), floatVolume.getId());
+    ASSERT_NE(shortVolume.getId(), fieldsVolume.getId());
+    ASSERT_NE(floatVolume.getId(), fieldsVolume.getId());
+}
+
+TEST(VolumeTest, FloatingPointRangeTest) {
+    float position[3] = {0.0f, 0.0f, 0.0f};
+    int dimensions[3] = {2, 2, 1};
+    float data[4] = {-1.0f, 0.0f, 2.0f, 3.0f};
+
+    auto volume = liv::createVolume<float>(position, dimensions, nullptr, {8});
+    volume.update(data, sizeof(data));
+
+    ASSERT_DOUBLE_EQ(volume.getQuantizationRange().min, -1.0);
+    ASSERT_DOUBLE_EQ(volume.getQuantizationRange().max, 3.0);
+
+    auto fixedRangeVolume = liv::createVolume<double>(position, dimensions, nullptr, {16, liv::ValueRange{0.0, 1.0}});
+    double doubleData[4] = {-1.0, 0.0, 2.0, 3.0};
+    fixedRangeVolume.update(doubleData, sizeof(doubleData));
+
+    ASSERT_DOUBLE_EQ(fixedRangeVolume.getQuantizationRange().max, 1.0);
+
+    // infinities do not stretch the range
+    float infiniteData[4] = {-std::numeric_limits<float>::infinity(), 0.5f, 1.5f, std::numeric_limits<float>::infinity()};
+    volume.update(infiniteData, sizeof(infiniteData));
+
+    ASSERT_DOUBLE_EQ(volume.getQuantizationRange().min, 0.5);
+    ASSERT_DOUBLE_EQ(volume.getQuantizationRange().max, 1.5);
+}
+
+TEST(VolumeTest, RegionUpdateMarksTouchedBricks) {
+    float position[3] = {0.0f, 0.0f, 0.0f};
+    int dimensions[3] = {16, 16, 16};
+    int brickSize[3] = {8, 8, 8};
+
+    auto volume = liv::createVolume<char>(position, dimensions, nullptr);
+    volume.setBrickSize(brickSize);
+
+    std::vector<char> region(4 * 4 * 4, 1);
+    int offset[3] = {6, 0, 0};
+    int extent[3] = {4, 4, 4};
+    volume.updateRegion(offset, extent, region.data());
+
+    ASSERT_EQ(volume.flushDirtyBricks(), 2);
+    ASSERT_EQ(volume.flushDirtyBricks(), 0);
+}
+
+TEST(VolumeTest, RegionUpdateKeepsVoxelsOfFullUpdate) {
+    float position[3] = {0.0f, 0.0f, 0.0f};
+    int dimensions[3] = {16, 16, 16};
+    int brickSize[3] = {8, 8, 8};
+
+    auto volume = liv::createVolume<char>(position, dimensions, nullptr);
+    volume.setBrickSize(brickSize);
+    volume.setBrickStatistics(true);
+
+    std::vector<char> data(16 * 16 * 16, 5);
+    volume.update(data.data(), static_cast<long int>(data.size()));
+
+    std::vector<char> region(4 * 4 * 4, 1);
+    int offset[3] = {0, 0, 0};
+    int extent[3] = {4, 4, 4};
+    volume.updateRegion(offset, extent, region.data());
+    ASSERT_EQ(volume.flushDirtyBricks(), 1);
+
+    // the transferred brick holds the region and, around it, the voxels of the full update
+    const auto& minMax = volume.getBrickStatistics().minMax;
+    ASSERT_EQ(minMax[0], 1);
+    ASSERT_EQ(minMax[1], 5);
+}
+
+TEST(VolumeTest, FullUpdateAfterRegionUpdateKeepsStagingInSync) {
+    float position[3] = {0.0f, 0.0f, 0.0f};
+    int dimensions[3] = {16, 16, 16};
+    int brickSize[3] = {8, 8, 8};
+
+    auto volume = liv::createVolume<char>(position, dimensions, nullptr);
+    volume.setBrickSize(brickSize);
+    volume.setBrickStatistics(true);
+
+    std::vector<char> data(16 * 16 * 16, 5);
+    volume.update(data.data(), static_cast<long int>(data.size()));
+
+    std::vector<char> region(4 * 4 * 4, 1);
+    int offset[3] = {0, 0, 0};
+    int extent[3] = {4, 4, 4};
+    volume.updateRegion(offset, extent, region.data());
+    ASSERT_EQ(volume.flushDirtyBricks(), 1);
+
+    // a later full update from another buffer replaces the voxels around the next region
+    std::vector<char> nextData(16 * 16 * 16, 7);
+    volume.update(nextData.data(), static_cast<long int>(nextData.size()));
+    std::fill(data.begin(), data.end(), 0);
+
+    std::fill(region.begin(), region.end(), 2);
+    offset[0] = 8;
+    volume.updateRegion(offset, extent, region.data());
+    ASSERT_EQ(volume.flushDirtyBricks(), 1);
+
+    const auto& minMax = volume.getBrickStatistics().minMax;
+    ASSERT_EQ(minMax[2], 2);
+    ASSERT_EQ(minMax[3], 7);
+}
+
+TEST(VolumeTest, ChangeDetectionSkipsUnchangedBricks) {
+    float position[3] = {0.0f, 0.0f, 0.0f};
+    int dimensions[3] = {16, 16, 16};
+    int brickSize[3] = {8, 8, 8};
+
+    auto volume = liv::createVolume<unsigned short>(position, dimensions, nullptr);
+    volume.setBrickSize(brickSize);
+    volume.setChangeDetection(true);
+
+    std::vector<unsigned short> data(16 * 16 * 16, 3);
+    volume.update(data.data(), data.size() * sizeof(unsigned short));
+    ASSERT_EQ(volume.getLastUpdateStatistics().bricksTransferred, 8);
+
+    data[15 + 16 * 15 + 256 * 15] = 4;
+    volume.update(data.data(), data.size() * sizeof(unsigned short));
+    ASSERT_EQ(volume.getLastUpdateStatistics().bricksTransferred, 1);
+    ASSERT_DOUBLE_EQ(volume.getLastUpdateStatistics().skippedFraction(), 7.0 / 8.0);
+}
+
+TEST(VolumeTest, BrickSizeChangeResetsChangeDetection) {
+    float position[3] = {0.0f, 0.0f, 0.0f};
+    int dimensions[3] = {16, 16, 16};
+    int brickSize[3] = {8, 8, 8};
+    int otherBrickSize[3] = {16, 8, 4};
+
+    auto volume = liv::createVolume<unsigned short>(position, dimensions, nullptr);
+    volume.setBrickSize(brickSize);
+    volume.setChangeDetection(true);
+
+    std::vector<unsigned short> data(16 * 16 * 16, 3);
+    volume.update(data.data(), data.size() * sizeof(unsigned short));
+
+    // as many bricks of as many voxels as before, which must not be compared with the previous hashes
+    volume.setBrickSize(otherBrickSize);
+    volume.update(data.data(), data.size() * sizeof(unsigned short));
+    ASSERT_EQ(volume.getLastUpdateStatistics().bricksTransferred, 8);
+}
+
+TEST(MultiFieldVolumeTest, DeinterleavesFields) {
+    struct Cell {
+        float density;
+        float pressure;
+        float temperature;
+    };
+
+    float position[3] = {0.0f, 0.0f, 0.0f};
+    int dimensions[3] = {3, 1, 1};
+    Cell cells[3] = {{0.0f, 10.0f, -1.0f}, {1.0f, 20.0f, -2.0f}, {2.0f, 30.0f, -3.0f}};
+
+    auto volume = liv::createMultiFieldVolume<float>(position, dimensions,
+        {{"density", offsetof(Cell, density)}, {"temperature", offsetof(Cell, temperature)}}, sizeof(Cell), nullptr);
+    volume.update(cells);
+
+    ASSERT_EQ(volume.getNumFields(), 2);
+    ASSERT_DOUBLE_EQ(volume.getQuantizationRange(0).max, 2.0);
+    ASSERT_DOUBLE_EQ(volume.getQuantizationRange(1).min, -3.0);
+}
@@ -0,0 +1,96 @@
+#include <algorithm>
+#include <vector>
+#include "gtest/gtest.h"
+#include "utils/LoadBalancing.h"
+
+TEST(LoadBalancingTest, MovesBricksFromSlowestToFastestRank) {
+    // rank 0 owns all expensive bricks
+    const std::vector<double> costs = {4.0, 4.0, 4.0, 4.0, 1.0, 1.0, 1.0, 1.0};
+    const std::vector<int> owners = {0, 0, 0, 0, 1, 1, 1, 1};
+
+    const auto migrations = liv::planBrickMigrations(costs, owners, 2, 0.1, 16);
+    ASSERT_FALSE(migrations.empty());
+
+    std::vector<int> newOwners(owners);
+    for (const auto& migration : migrations) {
+        ASSERT_EQ(owners[migration.brick], migration.from);
+        newOwners[migration.brick] = migration.to;
+    }
+
+    const auto before = liv::computeRankLoads(costs, owners, 2);
+    const auto after = liv::computeRankLoads(costs, newOwners, 2);
+    ASSERT_LT(*std::max_element(after.begin(), after.end()), *std::max_element(before.begin(), before.end()));
+    ASSERT_DOUBLE_EQ(after[0], 12.0);
+    ASSERT_DOUBLE_EQ(after[1], 8.0);
+}
+
+TEST(LoadBalancingTest, EqualizesEvenlySplittableLoad) {
+    const std::vector<double> costs(8, 1.0);
+    const std::vector<int> owners = {0, 0, 0, 0, 0, 0, 1, 2};
+
+    const auto migrations = liv::planBrickMigrations(costs, owners, 4, 0.0, 16);
+
+    std::vector<int> newOwners(owners);
+    for (const auto& migration : migrations) {
+        newOwners[migration.brick] = migration.to;
+    }
+
+    for (double load : liv::computeRankLoads(costs, newOwners, 4)) {
+        ASSERT_DOUBLE_EQ(load, 2.0);
+    }
+}
+
+TEST(LoadBalancingTest, KeepsBalancedOwnership) {
+    const std::vector<double> costs = {1.0, 1.0, 1.0, 1.1};
+    const std::vector<int> owners = {0, 1, 2, 3};
+
+    ASSERT_TRUE(liv::planBrickMigrations(costs, owners, 4, 0.1, 16).empty());
+}
+
+TEST(LoadBalancingTest, RespectsMigrationLimit) {
+    const std::vector<double> costs(16, 1.0);
+    const std::vector<int> owners(16, 0);
+
+    const auto migrations = liv::planBrickMigrations(costs, owners, 4, 0.0, 3);
+    ASSERT_EQ(migrations.size(), 3u);
+}
+
+TEST(LoadBalancingTest, DoesNotMoveIndivisibleLoad) {
+    // a single brick cannot be split between ranks
+    const std::vector<double> costs = {5.0};
+    const std::vector<int> owners = {0};
+
+    ASSERT_TRUE(liv::planBrickMigrations(costs, owners, 2, 0.1, 16).empty());
+}
+
+TEST(LoadBalancingTest, KeepsBoxesOfRanksDisjoint) {
+    // a row of bricks along x, rank 0 owning the first four
+    std::vector<liv::BrickBounds> bounds;
+    for (int b = 0; b < 6; b++) {
+        bounds.push_back({{static_cast<float>(b), 0.0f, 0.0f}, {static_cast<float>(b + 1), 1.0f, 1.0f}});
+    }
+    const std::vector<double> costs(6, 1.0);
+    const std::vector<int> owners = {0, 0, 0, 0, 1, 2};
+
+    const auto migrations = liv::planBrickMigrations(costs, owners, 3, 0.0, 16, bounds);
+    ASSERT_FALSE(migrations.empty());
+
+    std::vector<int> newOwners(owners);
+    for (const auto& migration : migrations) {
+        newOwners[migration.brick] = migration.to;
+    }
+
+    // the bricks of every rank stay contiguous, so that the box enclosing them holds no brick of another rank
+    for (int rank = 0; rank < 3; rank++) {
+        const auto first = std::find(newOwners.begin(), newOwners.end(), rank);
+        const auto last = std::find(newOwners.rbegin(), newOwners.rend(), rank).base();
+        ASSERT_TRUE(std::all_of(first, last, [rank](int owner) { return owner == rank; })) << "rank " << rank;
+    }
+    ASSERT_EQ(newOwners[3], 1);
+}
+
+TEST(LoadBalancingTest, SmoothsCosts) {
+    ASSERT_DOUBLE_EQ(liv::smoothCost(-1.0, 2.0, 0.5), 2.0);
+    ASSERT_DOUBLE_EQ(liv::smoothCost(1.0, 3.0, 0.5), 2.0);
+    ASSERT_DOUBLE_EQ(liv::smoothCost(1.0, 3.0, 1.0), 3.0);
+}
@@ -0,0 +1,128 @@
+#include <mpi.h>
+#include <algorithm>
+#include <chrono>
+#include <filesystem>
+#include <fstream>
+#include <string>
+#include <thread>
+#include "gtest/gtest.h"
+#include "utils/JVMConfiguration.h"
+#include "utils/NativeLibraryCache.h"
+
+namespace {
+    class MPIEnvironment : public ::testing::Environment {
+    public:
+        void SetUp() override {
+            MPI_Init(nullptr, nullptr);
+        }
+
+        void TearDown() override {
+            MPI_Finalize();
+        }
+    };
+
+    const auto* environment = ::testing::AddGlobalTestEnvironment(new MPIEnvironment);
+
+    void writeFile(const std::filesystem::path& path, const std::string& contents) {
+        std::ofstream file(path, std::ios::binary | std::ios::trunc);
+        file << contents;
+    }
+}
+
+TEST(NativeLibraryCacheTest, DetectsChangedLibraries) {
+    const auto directory = std::filesystem::temp_directory_path() / "liv-native-cache-test";
+    std::filesystem::remove_all(directory);
+    std::filesystem::create_directories(directory / "linux");
+
+    ASSERT_FALSE(liv::isNativeLibraryCacheValid(directory.string()));
+
+    writeFile(directory / "liblwjgl.so", "native library contents");
+    writeFile(directory / "linux" / "libshaderc.so", "another library");
+    ASSERT_TRUE(liv::writeNativeLibraryCacheManifest(directory.string()));
+    ASSERT_TRUE(liv::isNativeLibraryCacheValid(directory.string()));
+
+    // same size, different contents
+    writeFile(directory / "liblwjgl.so", "native library CONTENTS");
+    ASSERT_FALSE(liv::isNativeLibraryCacheValid(directory.string()));
+
+    std::filesystem::remove_all(directory);
+}
+
+TEST(NativeLibraryCacheTest, LibrariesExtractedAfterManifestInvalidateCache) {
+    const auto directory = std::filesystem::temp_directory_path() / "liv-native-cache-lazy-test";
+    std::filesystem::remove_all(directory);
+    std::filesystem::create_directories(directory);
+
+    // a manifest written right after JVM creation, before the renderer loaded its libraries
+    writeFile(directory / "liblwjgl.so", "native library contents");
+    ASSERT_TRUE(liv::writeNativeLibraryCacheManifest(directory.string()));
+    writeFile(directory / "liblwjgl_vulkan.so", "extracted during renderer initialization");
+    ASSERT_FALSE(liv::isNativeLibraryCacheValid(directory.string()));
+
+    // written again once the renderer is configured
+    ASSERT_TRUE(liv::writeNativeLibraryCacheManifest(directory.string()));
+    ASSERT_TRUE(liv::isNativeLibraryCacheValid(directory.string()));
+
+    std::filesystem::remove_all(directory);
+}
+
+TEST(NativeLibraryCacheTest, EmptyExtractionIsNotValid) {
+    const auto directory = std::filesystem::temp_directory_path() / "liv-native-cache-empty-test";
+    std::filesystem::remove_all(directory);
+    std::filesystem::create_directories(directory);
+
+    ASSERT_TRUE(liv::writeNativeLibraryCacheManifest(directory.string()));
+    ASSERT_FALSE(liv::isNativeLibraryCacheValid(directory.string()));
+
+    std::filesystem::remove_all(directory);
+}
+
+TEST(NativeLibraryCacheTest, SharedDirectoryIsUsedForAllRanks) {
+    liv::JVMConfiguration configuration;
+    configuration.lwjglSharedPath = "/tmp/";
+    configuration.nativesFingerprint = 0xabc;
+
+    const auto directory = liv::nativeLibraryDirectory(configuration);
+    ASSERT_EQ(directory, "/tmp//liv-natives-abc");
+
+    liv::JVMNodeOptions nodeOptions;
+    nodeOptions.nativeLibraryDirectory = directory;
+
+    const auto options = liv::buildJVMOptions(configuration, 5, nodeOptions);
+    ASSERT_NE(std::find(options.begin(), options.end(), "-Dorg.lwjgl.system.SharedLibraryExtractPath=" + directory), options.end());
+    ASSERT_NE(std::find(options.begin(), options.end(), "-Dorg.lwjgl.librarypath=" + directory), options.end());
+}
+
+TEST(NativeLibraryCacheTest, OtherRanksStartOnlyOnceManifestIsWritten) {
+    int rank;
+    MPI_Comm_rank(MPI_COMM_WORLD, &rank);
+
+    const auto directory = std::filesystem::temp_directory_path() / "liv-native-cache-node-test";
+    if (rank == 0) {
+        std::filesystem::remove_all(directory);
+        std::filesystem::create_directories(directory);
+    }
+    MPI_Barrier(MPI_COMM_WORLD);
+
+    if (rank == 0) {
+        // the renderer extracts its libraries while the other ranks are already waiting
+        std::this_thread::sleep_for(std::chrono::milliseconds(200));
+        writeFile(directory / "liblwjgl.so", "native library contents");
+
+        int recorded;
+        MPI_Request request;
+        liv::recordNativeLibraryCacheOnNode(directory.string(), MPI_COMM_WORLD, recorded, request);
+        MPI_Wait(&request, MPI_STATUS_IGNORE);
+        EXPECT_TRUE(recorded);
+    } else {
+        EXPECT_TRUE(liv::waitForNativeLibraryCacheOnNode(MPI_COMM_WORLD));
+        // this rank would start its JVM now, and must find the libraries recorded
+        EXPECT_TRUE(liv::isNativeLibraryCacheValid(directory.string()));
+    }
+
+    MPI_Barrier(MPI_COMM_WORLD);
+    if (rank == 0) {
+        EXPECT_TRUE(liv::isNativeLibraryCacheValid(directory.string()));
+        std::filesystem::remove_all(directory);
+    }
+}
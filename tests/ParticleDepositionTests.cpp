@@ -0,0 +1,201 @@
+#include <mpi.h>
+#include <cmath>
+#include <numeric>
+#include <random>
+#include <vector>
+#include "gtest/gtest.h"
+#include "utils/ParticleDeposition.h"
+#include "utils/VolumeIO.h"
+
+namespace {
+    class MPIEnvironment : public ::testing::Environment {
+    public:
+        void SetUp() override {
+            MPI_Init(nullptr, nullptr);
+        }
+
+        void TearDown() override {
+            MPI_Finalize();
+        }
+    };
+
+    const auto* environment = ::testing::AddGlobalTestEnvironment(new MPIEnvironment);
+
+    liv::DepositionGrid unitGrid(int size) {
+        liv::DepositionGrid grid{};
+        for (int axis = 0; axis < 3; axis++) {
+            grid.box.offset[axis] = 0;
+            grid.box.extent[axis] = size;
+            grid.origin[axis] = 0.0f;
+            grid.cellSize[axis] = 1.0f;
+        }
+        return grid;
+    }
+
+    float sum(const std::vector<float>& values) {
+        return std::accumulate(values.begin(), values.end(), 0.0f);
+    }
+}
+
+TEST(ParticleDepositionTest, ParsesKernelNames) {
+    liv::DepositionKernel kernel = liv::DepositionKernel::NearestGridPoint;
+    ASSERT_TRUE(liv::depositionKernelFromString("tsc", kernel));
+    ASSERT_EQ(kernel, liv::DepositionKernel::TriangularShapedCloud);
+    ASSERT_FALSE(liv::depositionKernelFromString("sph", kernel));
+    ASSERT_EQ(kernel, liv::DepositionKernel::TriangularShapedCloud);
+}
+
+TEST(ParticleDepositionTest, NearestGridPointFillsContainingCell) {
+    const auto grid = unitGrid(4);
+    const std::vector<float> positions = {1.9f, 2.1f, 3.5f};
+    const std::vector<float> weights = {2.5f};
+
+    std::vector<float> padded;
+    liv::depositParticles(positions.data(), weights.data(), 1, grid, liv::DepositionKernel::NearestGridPoint, padded);
+
+    ASSERT_EQ(padded.size(), 64u);
+    ASSERT_FLOAT_EQ(padded[1 + 4 * (2 + 4 * 3)], 2.5f);
+    ASSERT_FLOAT_EQ(sum(padded), 2.5f);
+}
+
+TEST(ParticleDepositionTest, CloudInCellSplitsBetweenCellCenters) {
+    const auto grid = unitGrid(4);
+    // a quarter of the way from the center of cell 1 to the center of cell 2 along x, on cell centers otherwise
+    const std::vector<float> positions = {1.75f, 1.5f, 1.5f};
+
+    std::vector<float> padded;
+    liv::depositParticles(positions.data(), nullptr, 1, grid, liv::DepositionKernel::CloudInCell, padded);
+
+    // with one ghost cell, cell (i, j, k) is at (i + 1, j + 1, k + 1) of the 6x6x6 padded grid
+    ASSERT_EQ(padded.size(), 216u);
+    const size_t row = 6 * (2 + 6 * 2);
+    ASSERT_FLOAT_EQ(padded[row + 2], 0.75f);
+    ASSERT_FLOAT_EQ(padded[row + 3], 0.25f);
+    ASSERT_FLOAT_EQ(sum(padded), 1.0f);
+}
+
+TEST(ParticleDepositionTest, TriangularShapedCloudWeightsAreSymmetric) {
+    const auto grid = unitGrid(3);
+    const std::vector<float> positions = {1.5f, 1.5f, 1.5f};
+
+    std::vector<float> padded;
+    liv::depositParticles(positions.data(), nullptr, 1, grid, liv::DepositionKernel::TriangularShapedCloud, padded);
+
+    // centered in cell (1, 1, 1): 0.75 along each axis for the center, 0.125 for the neighbours
+    const size_t center = 2 + 5 * (2 + 5 * 2);
+    ASSERT_FLOAT_EQ(padded[center], 0.75f * 0.75f * 0.75f);
+    ASSERT_FLOAT_EQ(padded[center - 1], 0.125f * 0.75f * 0.75f);
+    ASSERT_FLOAT_EQ(padded[center + 1], 0.125f * 0.75f * 0.75f);
+    ASSERT_FLOAT_EQ(sum(padded), 1.0f);
+}
+
+TEST(ParticleDepositionTest, ConservesWeightWithManyThreads) {
+    const auto grid = unitGrid(8);
+    std::mt19937 generator(7);
+    std::uniform_real_distribution<float> coordinate(0.0f, 8.0f);
+
+    const size_t numParticles = 200000;
+    std::vector<float> positions(3 * numParticles);
+    for (auto& position : positions) {
+        position = coordinate(generator);
+    }
+
+    for (auto kernel : {liv::DepositionKernel::NearestGridPoint, liv::DepositionKernel::CloudInCell,
+                        liv::DepositionKernel::TriangularShapedCloud}) {
+        std::vector<float> padded;
+        liv::depositParticles(positions.data(), nullptr, numParticles, grid, kernel, padded);
+        ASSERT_NEAR(sum(padded), static_cast<float>(numParticles), numParticles * 1e-4);
+    }
+}
+
+TEST(ParticleDepositionTest, GhostLayerHoldsContributionsOfNeighbours) {
+    // the lower half of an 8x4x4 grid, with a particle next to the boundary to the upper half
+    auto grid = unitGrid(4);
+    const std::vector<float> positions = {3.9f, 2.0f, 2.0f};
+
+    std::vector<float> padded;
+    liv::depositParticles(positions.data(), nullptr, 1, grid, liv::DepositionKernel::CloudInCell, padded);
+
+    float ghost = 0.0f;
+    for (int z = 0; z < 6; z++) {
+        for (int y = 0; y < 6; y++) {
+            ghost += padded[5 + 6 * (y + 6 * z)];
+        }
+    }
+    ASSERT_NEAR(ghost, 0.4f, 1e-5);
+
+    // particles beyond the ghost layer are dropped
+    const std::vector<float> outside = {6.0f, 2.0f, 2.0f};
+    liv::depositParticles(outside.data(), nullptr, 1, grid, liv::DepositionKernel::CloudInCell, padded);
+    ASSERT_FLOAT_EQ(sum(padded), 0.0f);
+}
+
+// On a single rank, the brick is the deposit onto the whole grid. Run with several ranks, the particles of every rank
+// lie in its own cells, and the contributions they make to the cells of neighbouring ranks are exchanged.
+TEST(ParticleDepositionTest, DistributedDepositMatchesWholeGrid) {
+    int rank, numRanks;
+    MPI_Comm_rank(MPI_COMM_WORLD, &rank);
+    MPI_Comm_size(MPI_COMM_WORLD, &numRanks);
+
+    const int dimensions[3] = {13, 11, 9};
+    int blockGrid[3];
+    liv::computeBlockGrid(numRanks, blockGrid);
+
+    liv::DepositionGrid whole{};
+    for (int axis = 0; axis < 3; axis++) {
+        whole.box.extent[axis] = dimensions[axis];
+        whole.origin[axis] = -1.0f;
+        whole.cellSize[axis] = 0.5f;
+    }
+    liv::DepositionGrid grid = whole;
+    grid.box = liv::blockBox(dimensions, blockGrid, rank);
+
+    // the same particles on every rank, of which each rank deposits those in its own cells
+    std::mt19937 generator(3);
+    std::uniform_real_distribution<float> unit(0.0f, 1.0f);
+    std::vector<float> positions, weights, localPositions, localWeights;
+    for (int p = 0; p < 20000; p++) {
+        float position[3];
+        bool local = true;
+        for (int axis = 0; axis < 3; axis++) {
+            position[axis] = whole.origin[axis] + unit(generator) * dimensions[axis] * whole.cellSize[axis];
+            const int cell = static_cast<int>(std::floor((position[axis] - whole.origin[axis]) / whole.cellSize[axis]));
+            local &= cell >= grid.box.offset[axis] && cell < grid.box.offset[axis] + grid.box.extent[axis];
+        }
+        const float weight = unit(generator);
+
+        positions.insert(positions.end(), position, position + 3);
+        weights.push_back(weight);
+        if (local) {
+            localPositions.insert(localPositions.end(), position, position + 3);
+            localWeights.push_back(weight);
+        }
+    }
+
+    for (auto kernel : {liv::DepositionKernel::NearestGridPoint, liv::DepositionKernel::CloudInCell,
+                        liv::DepositionKernel::TriangularShapedCloud}) {
+        std::vector<float> reference;
+        liv::depositParticles(positions.data(), weights.data(), weights.size(), whole, kernel, reference);
+
+        liv::ParticleDeposition deposition(grid, kernel, MPI_COMM_WORLD);
+        ASSERT_TRUE(deposition.deposit(localPositions.data(), localWeights.data(), localWeights.size()));
+
+        const int ghost = liv::depositionGhostWidth(kernel);
+        const liv::Box padded = liv::paddedBox(whole.box, ghost);
+        const liv::Box& box = grid.box;
+        const auto& brick = deposition.getBrick();
+
+        size_t i = 0;
+        for (int z = 0; z < box.extent[2]; z++) {
+            for (int y = 0; y < box.extent[1]; y++) {
+                for (int x = 0; x < box.extent[0]; x++) {
+                    const size_t cell = (box.offset[0] + x + ghost) + padded.extent[0]
+                                        * ((box.offset[1] + y + ghost) + static_cast<size_t>(padded.extent[1])
+                                        * (box.offset[2] + z + ghost));
+                    ASSERT_NEAR(brick[i++], reference[cell], 1e-4)
+                        << "at " << box.offset[0] + x << ", " << box.offset[1] + y << ", " << box.offset[2] + z;
+                }
+            }
+        }
+    }
+}
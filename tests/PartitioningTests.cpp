@@ -0,0 +1,107 @@
+#include <algorithm>
+#include <cstdlib>
+#include <set>
+#include <vector>
+#include "gtest/gtest.h"
+#include "utils/Partitioning.h"
+
+TEST(PartitioningTest, MortonInterleavesBits) {
+    ASSERT_EQ(liv::mortonIndex(1, 0, 0), 1u);
+    ASSERT_EQ(liv::mortonIndex(0, 1, 0), 2u);
+    ASSERT_EQ(liv::mortonIndex(0, 0, 1), 4u);
+    ASSERT_EQ(liv::mortonIndex(3, 3, 3), 63u);
+    ASSERT_EQ(liv::mortonIndex(2, 0, 0), 8u);
+}
+
+TEST(PartitioningTest, HilbertStepsToFaceNeighbours) {
+    const int bits = 3;
+    const int side = 1 << bits;
+    const int counts[3] = {side, side, side};
+    const auto order = liv::curveOrder(counts, liv::CurveType::Hilbert);
+
+    std::set<uint64_t> indices;
+    for (int z = 0; z < side; z++) {
+        for (int y = 0; y < side; y++) {
+            for (int x = 0; x < side; x++) {
+                indices.insert(liv::hilbertIndex(x, y, z, bits));
+            }
+        }
+    }
+    ASSERT_EQ(indices.size(), static_cast<size_t>(side * side * side));
+    ASSERT_EQ(*indices.rbegin(), static_cast<uint64_t>(side * side * side - 1));
+
+    for (size_t i = 1; i < order.size(); i++) {
+        const int a = order[i - 1];
+        const int b = order[i];
+        const int distance = std::abs(a % side - b % side) + std::abs(a / side % side - b / side % side)
+                             + std::abs(a / (side * side) - b / (side * side));
+        ASSERT_EQ(distance, 1);
+    }
+}
+
+TEST(PartitioningTest, CurveOrderCoversNonCubicGrids) {
+    const int counts[3] = {5, 3, 2};
+    for (auto type : {liv::CurveType::Morton, liv::CurveType::Hilbert}) {
+        const auto order = liv::curveOrder(counts, type);
+        ASSERT_EQ(std::set<int>(order.begin(), order.end()).size(), 30u);
+    }
+}
+
+TEST(PartitioningTest, EqualWeightsGiveEqualContiguousParts) {
+    const int counts[3] = {4, 4, 4};
+    const auto order = liv::curveOrder(counts, liv::CurveType::Hilbert);
+    const auto owners = liv::partitionAlongCurve(order, {}, 8);
+
+    std::vector<int> sizes(8, 0);
+    for (size_t i = 0; i < order.size(); i++) {
+        sizes[owners[order[i]]]++;
+        if (i > 0) {
+            ASSERT_GE(owners[order[i]], owners[order[i - 1]]);
+        }
+    }
+    for (int size : sizes) {
+        ASSERT_EQ(size, 8);
+    }
+
+    // with eight ranks on a 4x4x4 grid, every rank of the Hilbert curve holds one 2x2x2 octant
+    for (int rank = 0; rank < 8; rank++) {
+        int lower[3] = {4, 4, 4};
+        int upper[3] = {0, 0, 0};
+        for (int cell = 0; cell < 64; cell++) {
+            if (owners[cell] != rank) continue;
+            const int coordinates[3] = {cell % 4, cell / 4 % 4, cell / 16};
+            for (int axis = 0; axis < 3; axis++) {
+                lower[axis] = std::min(lower[axis], coordinates[axis]);
+                upper[axis] = std::max(upper[axis], coordinates[axis]);
+            }
+        }
+        for (int axis = 0; axis < 3; axis++) {
+            ASSERT_EQ(upper[axis] - lower[axis], 1);
+        }
+    }
+}
+
+TEST(PartitioningTest, WeightsShiftSegmentBoundaries) {
+    const std::vector<int> order = {0, 1, 2, 3, 4, 5};
+    const std::vector<double> weights = {10, 0, 0, 0, 0, 10};
+    const auto owners = liv::partitionAlongCurve(order, weights, 2);
+
+    ASSERT_EQ(owners[0], 0);
+    ASSERT_EQ(owners[5], 1);
+}
+
+TEST(PartitioningTest, EveryPartGetsACell) {
+    const std::vector<int> order = {0, 1, 2, 3};
+    const std::vector<double> weights = {100, 0, 0, 0};
+    const auto owners = liv::partitionAlongCurve(order, weights, 4);
+
+    ASSERT_EQ(owners, (std::vector<int>{0, 1, 2, 3}));
+}
+
+TEST(PartitioningTest, CountsNonEmptyVoxels) {
+    const std::vector<unsigned short> values = {0, 3, 0, 65535, 1};
+    ASSERT_EQ(liv::countNonEmptyVoxels(reinterpret_cast<const char *>(values.data()), values.size(), true), 3u);
+
+    const std::vector<unsigned char> bytes = {0, 0, 255, 0};
+    ASSERT_EQ(liv::countNonEmptyVoxels(reinterpret_cast<const char *>(bytes.data()), bytes.size(), false), 1u);
+}
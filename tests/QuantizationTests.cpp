@@ -0,0 +1,116 @@
+#include <cmath>
+#include <limits>
+#include <vector>
+#include "gtest/gtest.h"
+#include "utils/Quantization.h"
+
+TEST(QuantizationTest, ComputesRangeIgnoringNaN) {
+    std::vector<float> values(100000, 1.0f);
+    values[17] = -3.5f;
+    values[99999] = 42.0f;
+    values[500] = std::numeric_limits<float>::quiet_NaN();
+
+    auto range = liv::computeValueRange(values.data(), values.size());
+
+    ASSERT_DOUBLE_EQ(range.min, -3.5);
+    ASSERT_DOUBLE_EQ(range.max, 42.0);
+}
+
+TEST(QuantizationTest, ComputesRangeIgnoringInfinities) {
+    std::vector<double> values(100000, 1.0);
+    values[3] = -2.0;
+    values[70000] = 5.0;
+    values[10] = std::numeric_limits<double>::infinity();
+    values[99999] = -std::numeric_limits<double>::infinity();
+
+    auto range = liv::computeValueRange(values.data(), values.size());
+    ASSERT_DOUBLE_EQ(range.min, -2.0);
+    ASSERT_DOUBLE_EQ(range.max, 5.0);
+
+    // infinities are clamped to the ends of the range
+    std::vector<unsigned short> quantized(values.size());
+    liv::quantize(values.data(), values.size(), range, quantized.data());
+    ASSERT_EQ(quantized[10], 65535);
+    ASSERT_EQ(quantized[99999], 0);
+    ASSERT_EQ(quantized[3], 0);
+
+    // half-precision infinities are skipped as well
+    const std::vector<liv::half> halves = {{0x3c00}, {0x7c00}, {0xfc00}, {0x4000}};
+    range = liv::computeValueRange(halves.data(), halves.size());
+    ASSERT_DOUBLE_EQ(range.min, 1.0);
+    ASSERT_DOUBLE_EQ(range.max, 2.0);
+}
+
+TEST(QuantizationTest, MapsRangeOntoFullUnsignedShortRange) {
+    std::vector<double> values = {0.0, 0.5, 1.0, -1.0, 2.0, std::nan("")};
+    std::vector<unsigned short> quantized(values.size());
+
+    liv::quantize(values.data(), values.size(), {0.0, 1.0}, quantized.data());
+
+    ASSERT_EQ(quantized[0], 0);
+    ASSERT_EQ(quantized[1], 32768);
+    ASSERT_EQ(quantized[2], 65535);
+    ASSERT_EQ(quantized[3], 0);
+    ASSERT_EQ(quantized[4], 65535);
+    ASSERT_EQ(quantized[5], 0);
+}
+
+TEST(QuantizationTest, MapsRangeOntoFullByteRange) {
+    std::vector<float> values(300000);
+    for (size_t i = 0; i < values.size(); i++) {
+        values[i] = static_cast<float>(i % 256);
+    }
+    std::vector<char> quantized(values.size());
+
+    liv::quantize(values.data(), values.size(), {0.0, 255.0}, quantized.data());
+
+    for (size_t i = 0; i < values.size(); i++) {
+        ASSERT_EQ(static_cast<unsigned char>(quantized[i]), i % 256);
+    }
+}
+
+TEST(QuantizationTest, EmptyRangeMapsToZero) {
+    std::vector<float> values(10, 3.0f);
+    std::vector<unsigned short> quantized(values.size(), 7);
+
+    liv::quantize(values.data(), values.size(), {3.0, 3.0}, quantized.data());
+
+    for (auto q : quantized) {
+        ASSERT_EQ(q, 0);
+    }
+}
+
+TEST(QuantizationTest, ConvertsHalfPrecision) {
+    ASSERT_EQ(liv::halfToFloat({0x3c00}), 1.0f);
+    ASSERT_EQ(liv::halfToFloat({0xc000}), -2.0f);
+    ASSERT_EQ(liv::halfToFloat({0x0001}), std::ldexp(1.0f, -24));
+    ASSERT_TRUE(std::isinf(liv::halfToFloat({0x7c00})));
+    ASSERT_TRUE(std::isnan(liv::halfToFloat({0x7e00})));
+
+    std::vector<liv::half> values = {{0x0000}, {0x3800}, {0x3c00}};
+    std::vector<char> quantized(values.size());
+    liv::quantize(values.data(), values.size(), liv::computeValueRange(values.data(), values.size()), quantized.data());
+
+    ASSERT_EQ(static_cast<unsigned char>(quantized[0]), 0);
+    ASSERT_EQ(static_cast<unsigned char>(quantized[1]), 128);
+    ASSERT_EQ(static_cast<unsigned char>(quantized[2]), 255);
+}
+
+TEST(QuantizationTest, GathersStridedValues) {
+    // two interleaved fields, only the second one is converted
+    std::vector<float> cells(2 * 5000);
+    for (size_t i = 0; i < 5000; i++) {
+        cells[2 * i] = 1000.0f;
+        cells[2 * i + 1] = static_cast<float>(i % 2);
+    }
+
+    auto range = liv::computeValueRange(cells.data() + 1, 5000, 2);
+    ASSERT_DOUBLE_EQ(range.min, 0.0);
+    ASSERT_DOUBLE_EQ(range.max, 1.0);
+
+    std::vector<char> quantized(5000);
+    liv::quantize(cells.data() + 1, 5000, range, quantized.data(), 2);
+    for (size_t i = 0; i < 5000; i++) {
+        ASSERT_EQ(static_cast<unsigned char>(quantized[i]), i % 2 ? 255 : 0);
+    }
+}
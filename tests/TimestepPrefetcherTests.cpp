@@ -0,0 +1,136 @@
+#include <atomic>
+#include <chrono>
+#include <filesystem>
+#include <fstream>
+#include <set>
+#include <thread>
+#include <vector>
+#include "gtest/gtest.h"
+#include "liv.h"
+#include "utils/TimestepPrefetcher.h"
+
+namespace {
+    bool fillStep(int step, std::vector<char>& data) {
+        data.assign(16, static_cast<char>(step));
+        return true;
+    }
+
+    // plays 8 steps of a 4x4 volume at 50 steps per second from a loader that takes readTime per step
+    liv::PlaybackStatistics playSteps(std::chrono::milliseconds readTime) {
+        const float position[3] = {0.0f, 0.0f, 0.0f};
+        const int dimensions[3] = {4, 4, 1};
+        auto volume = liv::createVolume<char>(position, dimensions, nullptr);
+
+        liv::TimeSeriesPlayback<char> playback(volume, [readTime](int step, std::vector<char>& data) {
+            std::this_thread::sleep_for(readTime);
+            return fillStep(step, data);
+        }, 8, 50.0);
+        return playback.play();
+    }
+}
+
+TEST(TimestepPrefetcherTest, HandsOutStepsInOrder) {
+    liv::TimestepPrefetcher prefetcher(fillStep, 10);
+
+    liv::PrefetchedTimestep timestep;
+    for (int step = 0; step < 10; step++) {
+        ASSERT_TRUE(prefetcher.next(timestep));
+        ASSERT_EQ(timestep.step, step);
+        ASSERT_EQ(timestep.size, 16u);
+        ASSERT_EQ(timestep.data[0], static_cast<char>(step));
+        prefetcher.release(timestep);
+    }
+    ASSERT_FALSE(prefetcher.next(timestep));
+}
+
+TEST(TimestepPrefetcherTest, KeepsHeldStepsIntact) {
+    liv::TimestepPrefetcher prefetcher(fillStep, 20, 2);
+
+    // hold every step until the following one has been handed out, as the playback does
+    liv::PrefetchedTimestep previous;
+    liv::PrefetchedTimestep current;
+    std::set<char *> buffers;
+    while (prefetcher.next(current)) {
+        if (previous.slot >= 0) {
+            ASSERT_NE(previous.data, current.data);
+            ASSERT_EQ(previous.data[0], static_cast<char>(previous.step));
+        }
+        buffers.insert(current.data);
+        prefetcher.release(previous);
+        previous = current;
+    }
+    ASSERT_EQ(previous.step, 19);
+    ASSERT_LE(buffers.size(), 4u);
+}
+
+TEST(TimestepPrefetcherTest, ReadsAheadWithoutWaiting) {
+    std::atomic<int> read{0};
+    liv::TimestepPrefetcher prefetcher([&read](int step, std::vector<char>& data) {
+        read++;
+        return fillStep(step, data);
+    }, 10, 2);
+
+    // without any release, reading stops once the pool of depth + 2 buffers is full
+    std::this_thread::sleep_for(std::chrono::milliseconds(100));
+    ASSERT_EQ(read.load(), 4);
+
+    liv::PrefetchedTimestep timestep;
+    ASSERT_TRUE(prefetcher.next(timestep));
+    ASSERT_LT(timestep.waitSeconds, 0.05);
+}
+
+TEST(TimestepPrefetcherTest, ReportsSlowReads) {
+    liv::TimestepPrefetcher prefetcher([](int step, std::vector<char>& data) {
+        std::this_thread::sleep_for(std::chrono::milliseconds(50));
+        return fillStep(step, data);
+    }, 2);
+
+    liv::PrefetchedTimestep timestep;
+    ASSERT_TRUE(prefetcher.next(timestep));
+    ASSERT_GE(timestep.readSeconds, 0.04);
+    ASSERT_GE(timestep.waitSeconds, 0.04);
+    prefetcher.release(timestep);
+}
+
+TEST(TimestepPrefetcherTest, StopsOnFailedRead) {
+    liv::TimestepPrefetcher prefetcher([](int step, std::vector<char>& data) {
+        return step < 3 && fillStep(step, data);
+    }, 10);
+
+    liv::PrefetchedTimestep timestep;
+    int steps = 0;
+    while (prefetcher.next(timestep)) {
+        steps++;
+        prefetcher.release(timestep);
+    }
+    ASSERT_EQ(steps, 3);
+}
+
+TEST(TimestepPrefetcherTest, ListsTimestepFilesInOrder) {
+    const auto directory = std::filesystem::temp_directory_path() / "liv_timestep_files";
+    std::filesystem::remove_all(directory);
+    std::filesystem::create_directories(directory);
+    for (const char *name : {"step_002.livb", "step_000.livb", "step_001.livb", "notes.txt"}) {
+        std::ofstream(directory / name) << "x";
+    }
+
+    const auto files = liv::listTimestepFiles(directory.string(), ".livb");
+    ASSERT_EQ(files.size(), 3u);
+    ASSERT_EQ(std::filesystem::path(files[0]).filename(), "step_000.livb");
+    ASSERT_EQ(std::filesystem::path(files[2]).filename(), "step_002.livb");
+
+    std::filesystem::remove_all(directory);
+}
+
+TEST(TimeSeriesPlaybackTest, FastReadsAreNeverLate) {
+    const auto statistics = playSteps(std::chrono::milliseconds(1));
+    ASSERT_EQ(statistics.steps, 8);
+    ASSERT_EQ(statistics.lateSteps, 0);
+}
+
+TEST(TimeSeriesPlaybackTest, SlowReadsAreLate) {
+    const auto statistics = playSteps(std::chrono::milliseconds(60));
+    ASSERT_EQ(statistics.steps, 8);
+    // the first step starts the clock, all others are read after their deadline
+    ASSERT_EQ(statistics.lateSteps, 7);
+}
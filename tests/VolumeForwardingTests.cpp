@@ -0,0 +1,58 @@
+#include <cstdlib>
+#include <map>
+#include "gtest/gtest.h"
+#include "VolumeForwarding.h"
+
+TEST(VolumeForwardingTest, VisualizationRanksServeContiguousGroups) {
+    const int numRanks = 10;
+    const int numVisualizationRanks = 3;
+
+    std::map<int, int> groupSizes;
+    int previous = 0;
+    for (int rank = 0; rank < numRanks; rank++) {
+        const int visualizationRank = liv::visualizationRankOf(rank, numRanks, numVisualizationRanks);
+        ASSERT_LE(visualizationRank, rank);
+        ASSERT_GE(visualizationRank, previous);
+        // a visualization rank serves itself
+        ASSERT_EQ(liv::visualizationRankOf(visualizationRank, numRanks, numVisualizationRanks), visualizationRank);
+        groupSizes[visualizationRank]++;
+        previous = visualizationRank;
+    }
+
+    ASSERT_EQ(groupSizes.size(), static_cast<size_t>(numVisualizationRanks));
+    for (const auto& group : groupSizes) {
+        ASSERT_GE(group.second, numRanks / numVisualizationRanks);
+        ASSERT_LE(group.second, numRanks / numVisualizationRanks + 1);
+    }
+}
+
+TEST(VolumeForwardingTest, VisualizationRankCountLeavesSimulationRanks) {
+    unsetenv("LIV_VISUALIZATION_RANKS");
+    ASSERT_EQ(liv::numVisualizationRanksFromEnvironment(8), 1);
+
+    setenv("LIV_VISUALIZATION_RANKS", "3", 1);
+    ASSERT_EQ(liv::numVisualizationRanksFromEnvironment(8), 3);
+
+    setenv("LIV_VISUALIZATION_RANKS", "8", 1);
+    ASSERT_EQ(liv::numVisualizationRanksFromEnvironment(8), 7);
+
+    setenv("LIV_VISUALIZATION_RANKS", "0", 1);
+    ASSERT_EQ(liv::numVisualizationRanksFromEnvironment(8), 1);
+    unsetenv("LIV_VISUALIZATION_RANKS");
+}
+
+TEST(VolumeForwardingTest, ForwardedVolumeIDsAreDistinct) {
+    liv::ForwardedVolumeIDs ids;
+
+    // ranks and volume IDs beyond 16 bits do not wrap onto each other
+    const int first = ids.get(40000, 1);
+    ASSERT_NE(first, ids.get(40001, 1));
+    ASSERT_NE(first, ids.get(40000, 1 + (1 << 16)));
+    ASSERT_EQ(first, ids.get(40000, 1));
+
+    // volumes of the rendering rank itself use small IDs
+    ASSERT_GT(ids.get(0, 0), 1 << 30);
+
+    ids.erase(40000, 1);
+    ASSERT_NE(first, ids.get(40000, 1));
+}
@@ -0,0 +1,94 @@
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <string>
+#include <vector>
+#include "gtest/gtest.h"
+#include "utils/VolumeIO.h"
+
+TEST(VolumeIOTest, BlockGridIsCubeLike) {
+    int grid[3];
+
+    liv::computeBlockGrid(8, grid);
+    ASSERT_EQ(grid[0] * grid[1] * grid[2], 8);
+    ASSERT_EQ(grid[0], 2);
+    ASSERT_EQ(grid[1], 2);
+    ASSERT_EQ(grid[2], 2);
+
+    liv::computeBlockGrid(12, grid);
+    ASSERT_EQ(grid[0] * grid[1] * grid[2], 12);
+
+    liv::computeBlockGrid(7, grid);
+    ASSERT_EQ(grid[0] * grid[1] * grid[2], 7);
+}
+
+TEST(VolumeIOTest, BlocksTileTheVolume) {
+    const int dimensions[3] = {10, 7, 5};
+    const int grid[3] = {3, 2, 2};
+
+    std::vector<int> covered(10 * 7 * 5, 0);
+    for (int block = 0; block < 12; block++) {
+        const auto box = liv::blockBox(dimensions, grid, block);
+        for (int z = box.offset[2]; z < box.offset[2] + box.extent[2]; z++) {
+            for (int y = box.offset[1]; y < box.offset[1] + box.extent[1]; y++) {
+                for (int x = box.offset[0]; x < box.offset[0] + box.extent[0]; x++) {
+                    covered[(z * 7 + y) * 10 + x]++;
+                }
+            }
+        }
+    }
+
+    for (int count : covered) {
+        ASSERT_EQ(count, 1);
+    }
+}
+
+TEST(VolumeIOTest, RemainderGoesToFirstBlocks) {
+    const int dimensions[3] = {10, 4, 4};
+    const int grid[3] = {3, 1, 1};
+
+    ASSERT_EQ(liv::blockBox(dimensions, grid, 0).extent[0], 4);
+    ASSERT_EQ(liv::blockBox(dimensions, grid, 1).offset[0], 4);
+    ASSERT_EQ(liv::blockBox(dimensions, grid, 1).extent[0], 3);
+    ASSERT_EQ(liv::blockBox(dimensions, grid, 2).offset[0], 7);
+}
+
+TEST(VolumeIOTest, InfoPathReplacesExtension) {
+    ASSERT_EQ(liv::volumeInfoPath("/data/volumes/skull.raw"), "/data/volumes/skull.info");
+}
+
+TEST(VolumeIOTest, MappedFileHoldsFileContents) {
+    const std::string path = "VolumeIOTest_mapped.raw";
+    std::vector<char> contents(3 * 4096 + 17);
+    for (size_t i = 0; i < contents.size(); i++) {
+        contents[i] = static_cast<char>(i * 31);
+    }
+    {
+        std::ofstream file(path, std::ios::binary);
+        file.write(contents.data(), static_cast<std::streamsize>(contents.size()));
+    }
+
+    liv::MappedFile mapped;
+    ASSERT_TRUE(mapped.open(path, {true, true, true}));
+    ASSERT_EQ(mapped.size(), contents.size());
+    ASSERT_EQ(std::memcmp(mapped.data(), contents.data(), contents.size()), 0);
+
+    // writes to the mapping stay private
+    mapped.data()[0] = static_cast<char>(contents[0] + 1);
+    liv::MappedFile moved = std::move(mapped);
+    ASSERT_EQ(mapped.data(), nullptr);
+    ASSERT_EQ(moved.size(), contents.size());
+
+    liv::MappedFile reopened;
+    ASSERT_TRUE(reopened.open(path));
+    ASSERT_EQ(reopened.data()[0], contents[0]);
+
+    std::remove(path.c_str());
+}
+
+TEST(VolumeIOTest, MappingMissingFileFails) {
+    liv::MappedFile mapped;
+    ASSERT_FALSE(mapped.open("VolumeIOTest_missing.raw"));
+    ASSERT_EQ(mapped.data(), nullptr);
+    ASSERT_EQ(mapped.size(), 0u);
+}